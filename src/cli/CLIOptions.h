@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 struct CLIOptions {
@@ -19,4 +20,42 @@ struct CLIOptions {
     bool modules{false};
     bool help{false};
     bool verbose{false};
+    bool verify{false};
+    std::string query;
+    unsigned int frameStep{1};
+    unsigned short port{11112};
+    unsigned int concurrency{0};
+    unsigned int duration{0};
+    bool allowRemote{false};
+    std::string onArrival;
+    int deflateLevel{6};
+    unsigned int threads{0};
+    std::string itkBackend;
+    std::uint64_t maxMemory{0};
+    std::string streamFormat{"nrrd"};
+    std::string gaussianEngine{"discrete"};
+    double sigma{1.0};
+    std::string medianEngine{"histogram"};
+    unsigned int radius{1};
+    std::string precision{"fp32"};
+    std::string resampleEngine;
+    std::string interpolation{"linear"};
+    bool antialias{false};
+    std::string projection{"max"};
+    std::string axis{"z"};
+    double slabThickness{0.0};
+    double slabStep{0.0};
+    std::string equalizeEngine{"clahe2d"};
+    unsigned int tiles{8};
+    double clipLimit{2.0};
+    double alpha{0.3};
+    double beta{0.3};
+    unsigned int connectivity{6};
+    std::uint64_t minSize{0};
+    std::string intensityPath;
+    std::string maskOp{"dilate"};
+    // Set when a flag that picks the code path (e.g. --max-memory) could not be parsed; main exits instead of guessing
+    bool invalid{false};
+    // Directory to watch; the command (or comma-separated chain) runs on every file that arrives there
+    std::string watchDir;
 };
@@ -8,6 +8,9 @@
 
 #include "CLIParser.h"
 
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -17,6 +20,28 @@ namespace {
 bool IsFlag(const std::string& arg, const std::string& shortFlag, const std::string& longFlag) {
     return arg == shortFlag || arg == longFlag;
 }
+
+// Accept plain bytes or a K/M/G/T suffix (powers of 1024, optional trailing B), e.g. 512M or 1.5G; 0 when invalid
+std::uint64_t ParseByteSize(const std::string& text) {
+    char* end = nullptr;
+    const double value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || value <= 0.0) {
+        return 0;
+    }
+    double scale = 1.0;
+    switch (std::toupper(static_cast<unsigned char>(*end))) {
+        case 'T': scale *= 1024.0; [[fallthrough]];
+        case 'G': scale *= 1024.0; [[fallthrough]];
+        case 'M': scale *= 1024.0; [[fallthrough]];
+        case 'K': scale *= 1024.0; ++end; break;
+        default: break;
+    }
+    const std::string rest(end);
+    if (!rest.empty() && rest != "B" && rest != "b" && rest != "iB") {
+        return 0;
+    }
+    return static_cast<std::uint64_t>(value * scale);
+}
 }
 
 CLIOptions ParseCLIArgs(int argc, char* argv[], const CommandRegistry& registry) {
@@ -33,6 +58,245 @@ CLIOptions ParseCLIArgs(int argc, char* argv[], const CommandRegistry& registry)
             opts.modules = true;
         } else if (IsFlag(arg, "-v", "--verbose")) {
             opts.verbose = true;
+        } else if (arg == "--verify") {
+            opts.verify = true;
+        } else if (arg == "--allow-remote") {
+            opts.allowRemote = true;
+        } else if (arg == "--query") {
+            if (i + 1 < argc) {
+                opts.query = argv[++i];
+            } else {
+                std::cerr << "Missing value for --query" << std::endl;
+            }
+        } else if (arg == "--frame-step") {
+            if (i + 1 < argc) {
+                const int step = std::atoi(argv[++i]);
+                opts.frameStep = step > 0 ? static_cast<unsigned int>(step) : 1;
+            } else {
+                std::cerr << "Missing value for --frame-step" << std::endl;
+            }
+        } else if (arg == "--port" || arg == "--concurrency" || arg == "--duration") {
+            if (i + 1 < argc) {
+                const int value = std::atoi(argv[++i]);
+                if (arg == "--port") {
+                    opts.port = static_cast<unsigned short>(value > 0 && value < 65536 ? value : 11112);
+                } else if (arg == "--concurrency") {
+                    opts.concurrency = value > 0 ? static_cast<unsigned int>(value) : 0;
+                } else {
+                    opts.duration = value > 0 ? static_cast<unsigned int>(value) : 0;
+                }
+            } else {
+                std::cerr << "Missing value for " << arg << std::endl;
+            }
+        } else if (arg == "--deflate-level") {
+            if (i + 1 < argc) {
+                const int level = std::atoi(argv[++i]);
+                opts.deflateLevel = level < 0 ? 0 : (level > 9 ? 9 : level);
+            } else {
+                std::cerr << "Missing value for --deflate-level" << std::endl;
+            }
+        } else if (arg == "--threads") {
+            if (i + 1 < argc) {
+                const int threads = std::atoi(argv[++i]);
+                opts.threads = threads > 0 ? static_cast<unsigned int>(threads) : 0;
+            } else {
+                std::cerr << "Missing value for --threads" << std::endl;
+            }
+        } else if (arg == "--itk-backend") {
+            if (i + 1 < argc) {
+                opts.itkBackend = argv[++i];
+            } else {
+                std::cerr << "Missing value for --itk-backend" << std::endl;
+            }
+        } else if (arg == "--max-memory") {
+            if (i + 1 < argc) {
+                opts.maxMemory = ParseByteSize(argv[++i]);
+                if (opts.maxMemory == 0) {
+                    std::cerr << "Invalid --max-memory value: " << argv[i] << " (expected e.g. 512M or 4G)" << std::endl;
+                    opts.invalid = true;
+                }
+            } else {
+                std::cerr << "Missing value for --max-memory" << std::endl;
+                opts.invalid = true;
+            }
+        } else if (arg == "--stream-format") {
+            if (i + 1 < argc) {
+                opts.streamFormat = argv[++i];
+            } else {
+                std::cerr << "Missing value for --stream-format" << std::endl;
+            }
+        } else if (arg == "--gaussian-engine") {
+            if (i + 1 < argc) {
+                opts.gaussianEngine = argv[++i];
+            } else {
+                std::cerr << "Missing value for --gaussian-engine" << std::endl;
+            }
+        } else if (arg == "--sigma") {
+            if (i + 1 < argc) {
+                const double sigma = std::atof(argv[++i]);
+                if (sigma > 0.0) {
+                    opts.sigma = sigma;
+                } else {
+                    std::cerr << "Invalid --sigma value: " << argv[i] << std::endl;
+                }
+            } else {
+                std::cerr << "Missing value for --sigma" << std::endl;
+            }
+        } else if (arg == "--median-engine") {
+            if (i + 1 < argc) {
+                opts.medianEngine = argv[++i];
+            } else {
+                std::cerr << "Missing value for --median-engine" << std::endl;
+            }
+        } else if (arg == "--radius") {
+            if (i + 1 < argc) {
+                const int radius = std::atoi(argv[++i]);
+                opts.radius = radius > 0 ? static_cast<unsigned int>(radius) : 1;
+            } else {
+                std::cerr << "Missing value for --radius" << std::endl;
+            }
+        } else if (arg == "--precision") {
+            if (i + 1 < argc) {
+                opts.precision = argv[++i];
+            } else {
+                std::cerr << "Missing value for --precision" << std::endl;
+            }
+        } else if (arg == "--resample-engine") {
+            if (i + 1 < argc) {
+                opts.resampleEngine = argv[++i];
+            } else {
+                std::cerr << "Missing value for --resample-engine" << std::endl;
+            }
+        } else if (arg == "--interpolation") {
+            if (i + 1 < argc) {
+                opts.interpolation = argv[++i];
+            } else {
+                std::cerr << "Missing value for --interpolation" << std::endl;
+            }
+        } else if (arg == "--antialias") {
+            opts.antialias = true;
+        } else if (arg == "--projection") {
+            if (i + 1 < argc) {
+                opts.projection = argv[++i];
+            } else {
+                std::cerr << "Missing value for --projection" << std::endl;
+            }
+        } else if (arg == "--axis") {
+            if (i + 1 < argc) {
+                opts.axis = argv[++i];
+            } else {
+                std::cerr << "Missing value for --axis" << std::endl;
+            }
+        } else if (arg == "--slab") {
+            if (i + 1 < argc) {
+                const double thickness = std::atof(argv[++i]);
+                if (thickness >= 0.0) {
+                    opts.slabThickness = thickness;
+                } else {
+                    std::cerr << "Invalid --slab value: " << argv[i] << std::endl;
+                }
+            } else {
+                std::cerr << "Missing value for --slab" << std::endl;
+            }
+        } else if (arg == "--slab-step") {
+            if (i + 1 < argc) {
+                const double step = std::atof(argv[++i]);
+                if (step >= 0.0) {
+                    opts.slabStep = step;
+                } else {
+                    std::cerr << "Invalid --slab-step value: " << argv[i] << std::endl;
+                }
+            } else {
+                std::cerr << "Missing value for --slab-step" << std::endl;
+            }
+        } else if (arg == "--equalize-engine") {
+            if (i + 1 < argc) {
+                opts.equalizeEngine = argv[++i];
+            } else {
+                std::cerr << "Missing value for --equalize-engine" << std::endl;
+            }
+        } else if (arg == "--tiles") {
+            if (i + 1 < argc) {
+                const int tiles = std::atoi(argv[++i]);
+                opts.tiles = tiles > 0 ? static_cast<unsigned int>(tiles) : 8;
+            } else {
+                std::cerr << "Missing value for --tiles" << std::endl;
+            }
+        } else if (arg == "--clip-limit") {
+            if (i + 1 < argc) {
+                const double clipLimit = std::atof(argv[++i]);
+                if (clipLimit >= 0.0) {
+                    opts.clipLimit = clipLimit;
+                } else {
+                    std::cerr << "Invalid --clip-limit value: " << argv[i] << std::endl;
+                }
+            } else {
+                std::cerr << "Missing value for --clip-limit" << std::endl;
+            }
+        } else if (arg == "--alpha") {
+            if (i + 1 < argc) {
+                const double alpha = std::atof(argv[++i]);
+                if (alpha >= 0.0 && alpha <= 1.0) {
+                    opts.alpha = alpha;
+                } else {
+                    std::cerr << "Invalid --alpha value: " << argv[i] << " (expected 0-1)" << std::endl;
+                }
+            } else {
+                std::cerr << "Missing value for --alpha" << std::endl;
+            }
+        } else if (arg == "--beta") {
+            if (i + 1 < argc) {
+                const double beta = std::atof(argv[++i]);
+                if (beta >= 0.0 && beta <= 1.0) {
+                    opts.beta = beta;
+                } else {
+                    std::cerr << "Invalid --beta value: " << argv[i] << " (expected 0-1)" << std::endl;
+                }
+            } else {
+                std::cerr << "Missing value for --beta" << std::endl;
+            }
+        } else if (arg == "--connectivity") {
+            if (i + 1 < argc) {
+                const int connectivity = std::atoi(argv[++i]);
+                if (connectivity == 6 || connectivity == 18 || connectivity == 26) {
+                    opts.connectivity = static_cast<unsigned int>(connectivity);
+                } else {
+                    std::cerr << "Invalid --connectivity value: " << argv[i] << " (expected 6, 18 or 26)" << std::endl;
+                }
+            } else {
+                std::cerr << "Missing value for --connectivity" << std::endl;
+            }
+        } else if (arg == "--min-size") {
+            if (i + 1 < argc) {
+                const long long minSize = std::atoll(argv[++i]);
+                opts.minSize = minSize > 0 ? static_cast<std::uint64_t>(minSize) : 0;
+            } else {
+                std::cerr << "Missing value for --min-size" << std::endl;
+            }
+        } else if (arg == "--intensity") {
+            if (i + 1 < argc) {
+                opts.intensityPath = argv[++i];
+            } else {
+                std::cerr << "Missing value for --intensity" << std::endl;
+            }
+        } else if (arg == "--mask-op") {
+            if (i + 1 < argc) {
+                opts.maskOp = argv[++i];
+            } else {
+                std::cerr << "Missing value for --mask-op" << std::endl;
+            }
+        } else if (arg == "--on-arrival") {
+            if (i + 1 < argc) {
+                opts.onArrival = argv[++i];
+            } else {
+                std::cerr << "Missing value for --on-arrival" << std::endl;
+            }
+        } else if (arg == "--watch") {
+            if (i + 1 < argc) {
+                opts.watchDir = argv[++i];
+            } else {
+                std::cerr << "Missing value for --watch" << std::endl;
+            }
         } else if (IsFlag(arg, "-i", "--input")) {
             if (i + 1 < argc) {
                 opts.inputPath = argv[++i];
@@ -76,6 +340,43 @@ void PrintUsage(std::ostream& os, const CommandRegistry& registry) {
     os << "  -i, --input <path>   Specify DICOM file or directory" << std::endl;
     os << "  -o, --output <dir>   Output directory (default: output)" << std::endl;
     os << "  -v, --verbose        Print extra details for commands" << std::endl;
+    os << "      --verify         Verify lossless transcodes via per-frame pixel hashes" << std::endl;
+    os << "      --query <expr>   Lookup filter, e.g. patient=123,modality=CT,series=1.2.*" << std::endl;
+    os << "      --frame-step <n> Export every Nth frame in cine commands (default: 1)" << std::endl;
+    os << "      --port <n>       DICOM port for network commands (default: 11112)" << std::endl;
+    os << "      --concurrency <n> Parallel associations for network commands (default: auto)" << std::endl;
+    os << "      --duration <s>   Stop receivers after s seconds (default: run until Ctrl-C)" << std::endl;
+    os << "      --allow-remote   Let store-scp, qr-scp and serve:dicomweb accept other hosts (default: loopback only)"
+       << std::endl;
+    os << "      --deflate-level <n> zlib level 0-9 for deflated transfer syntax output (default: 6)" << std::endl;
+    os << "      --threads <n>    Worker threads for ITK filters, series loading and deflate (default: all cores)" << std::endl;
+    os << "      --itk-backend <b> ITK threading backend: pool, tbb or platform (default: ITK's choice)" << std::endl;
+    os << "      --max-memory <size> Stream itk:gaussian/median/threshold/aniso in slabs within this budget (e.g. 4G)" << std::endl;
+    os << "      --stream-format <f> Streamed ITK output: nrrd or mha (default: nrrd)" << std::endl;
+    os << "      --gaussian-engine <e> itk:gaussian engine: discrete, recursive or separable (default: discrete)" << std::endl;
+    os << "      --sigma <mm>     Gaussian sigma in mm for itk:gaussian (default: 1)" << std::endl;
+    os << "      --median-engine <e> itk:median engine: histogram or itk (default: histogram)" << std::endl;
+    os << "      --radius <n>     Box radius for itk:median, ball radius for itk:mask, in voxels (default: 1)" << std::endl;
+    os << "      --precision <p>  itk:aniso working volume: fp32 or fp16 (default: fp32)" << std::endl;
+    os << "      --resample-engine <e> itk:resample/vtk:resample engine: separable, itk or vtk (default: separable"
+       << " for ITK, vtk for VTK)" << std::endl;
+    os << "      --interpolation <k> Resampling kernel: linear, bspline or lanczos (default: linear)" << std::endl;
+    os << "      --antialias      Widen the separable resampling kernel on downsampled axes" << std::endl;
+    os << "      --projection <p> itk:slab reduction: max, min, mean or sum (default: max)" << std::endl;
+    os << "      --axis <a>       itk:slab ray axis: x, y, z or an oblique dx,dy,dz (default: z)" << std::endl;
+    os << "      --slab <mm>      itk:slab thickness in mm (default: 0 = whole depth, one image)" << std::endl;
+    os << "      --slab-step <mm> itk:slab spacing between slab starts in mm (default: 0 = one sample)" << std::endl;
+    os << "      --equalize-engine <e> itk:histogram engine: clahe2d, clahe3d or itk (default: clahe2d)" << std::endl;
+    os << "      --tiles <n>      CLAHE tiles per axis (default: 8)" << std::endl;
+    os << "      --clip-limit <x> CLAHE clip limit as a multiple of the mean bin count, 0 = none (default: 2)" << std::endl;
+    os << "      --alpha <a>      ITK equalizer alpha, 0 = equalization to 1 = unsharp mask (default: 0.3)" << std::endl;
+    os << "      --beta <b>       Share of the input kept in the equalized result (default: 0.3)" << std::endl;
+    os << "      --connectivity <n> itk:label neighbourhood: 6, 18 or 26 (default: 6)" << std::endl;
+    os << "      --min-size <n>   itk:label drops components smaller than n voxels (default: 0)" << std::endl;
+    os << "      --intensity <path> itk:label volume for per-label intensity stats (default: the mask)" << std::endl;
+    os << "      --mask-op <op>   itk:mask operation: dilate, erode, open, close, fill or distance (default: dilate)" << std::endl;
+    os << "      --on-arrival <cmd> Run a registered command on every received instance" << std::endl;
+    os << "      --watch <dir>    Run the command (or cmd1,cmd2 chain) on every file written into dir" << std::endl;
     os << std::endl;
     os << "Commands:" << std::endl;
     // Leverage registry for up-to-date list so usage always matches capabilities
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <ostream>
@@ -19,6 +20,61 @@ struct CommandContext {
     std::string inputPath;
     std::string outputDir;
     bool verbose{false};
+    // Re-decode lossless outputs and compare per-frame pixel hashes against the source
+    bool verify{false};
+    // Free-form lookup filter for query commands (key=value[,key=value])
+    std::string query;
+    // Render every Nth frame in cine exports
+    unsigned int frameStep{1};
+    // Network services: listen/connect port, parallel associations (0 = auto), run time in seconds (0 = until Ctrl-C)
+    unsigned short port{11112};
+    unsigned int concurrency{0};
+    unsigned int duration{0};
+    // Serve peers on other hosts too; network services otherwise answer loopback clients only
+    bool allowRemote{false};
+    // Registered command to run on every instance a receiver stores
+    std::string onArrival;
+    // zlib level (0-9) for Deflated Explicit VR Little Endian output
+    int deflateLevel{6};
+    // ITK multithreader: worker threads (0 = ITK default) and backend name (pool, tbb, platform; empty = default)
+    unsigned int threads{0};
+    std::string itkBackend;
+    // Set when commands run concurrently in one process (--watch): process-wide settings such as ITK's global
+    // threader are applied once up front and must not be changed by individual commands
+    bool sharedProcess{false};
+    // Memory budget in bytes for streamed ITK filters (0 = load the whole volume) and their output format (nrrd, mha)
+    std::uint64_t maxMemory{0};
+    std::string streamFormat{"nrrd"};
+    // itk:gaussian smoothing engine (discrete, recursive, separable) and sigma in mm
+    std::string gaussianEngine{"discrete"};
+    double sigma{1.0};
+    // itk:median engine (itk, histogram) and box radius in voxels, also the itk:mask ball radius
+    std::string medianEngine{"histogram"};
+    unsigned int radius{1};
+    // Working-volume precision for itk:aniso (fp32, fp16)
+    std::string precision{"fp32"};
+    // itk:resample / vtk:resample engine (separable, itk, vtk; empty = separable for ITK, vtk for VTK), kernel
+    // (linear, bspline, lanczos) and anti-aliasing
+    std::string resampleEngine;
+    std::string interpolation{"linear"};
+    bool antialias{false};
+    // itk:slab projection (max, min, mean, sum), ray axis (x, y, z or dx,dy,dz), slab thickness and step in mm
+    std::string projection{"max"};
+    std::string axis{"z"};
+    double slabThickness{0.0};
+    double slabStep{0.0};
+    // itk:histogram engine (clahe2d, clahe3d, itk), CLAHE tiles per axis and clip limit, ITK alpha, shared beta
+    std::string equalizeEngine{"clahe2d"};
+    unsigned int tiles{8};
+    double clipLimit{2.0};
+    double alpha{0.3};
+    double beta{0.3};
+    // itk:label neighbourhood (6, 18, 26), smallest component kept in voxels, and optional intensity volume for stats
+    unsigned int connectivity{6};
+    std::uint64_t minSize{0};
+    std::string intensityPath;
+    // itk:mask operation (dilate, erode, open, close, fill, distance); the ball radius is `radius`
+    std::string maskOp{"dilate"};
 };
 
 struct Command {
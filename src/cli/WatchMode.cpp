@@ -0,0 +1,385 @@
+//
+// WatchMode.cpp
+// DicomToolsCpp
+//
+// Implements inotify-driven ingest: completed files are queued to a bounded worker pool that runs the command chain.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#include "WatchMode.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#include "utils/ParallelUtils.h"
+#include "utils/WorkQueue.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+std::vector<std::string> ParseCommandChain(const std::string& command) {
+    std::vector<std::string> chain;
+    std::stringstream stream(command);
+    std::string step;
+    while (std::getline(stream, step, ',')) {
+        if (!step.empty()) {
+            chain.push_back(step);
+        }
+    }
+    return chain;
+}
+
+#ifdef __linux__
+namespace {
+std::atomic<bool> g_stopRequested{false};
+
+void HandleStopSignal(int) {
+    g_stopRequested = true;
+}
+
+struct IngestJob {
+    // File to process, the version that was queued and when its completion event was seen
+    fs::path path;
+    fs::file_time_type written;
+    std::chrono::steady_clock::time_point detected;
+};
+
+// True for `path` itself and anything below it; both sides must be absolute and normalized
+bool IsWithin(const fs::path& path, const fs::path& directory) {
+    const fs::path relative = path.lexically_relative(directory);
+    return !relative.empty() && *relative.begin() != "..";
+}
+
+// Output folder for one ingested file: readable, and unique because the hash covers the full relative path
+std::string OutputFolderName(const fs::path& relative) {
+    std::string name = fs::path(relative).replace_extension().string();
+    std::replace(name.begin(), name.end(), '/', '_');
+    std::ostringstream hash;
+    hash << std::hex << std::setw(8) << std::setfill('0')
+         << (std::hash<std::string>{}(relative.generic_string()) & 0xffffffffu);
+    return name + "-" + hash.str();
+}
+
+bool IsCandidate(const fs::path& path) {
+    // Writers that stage under a temporary name and rename on completion are picked up by the rename
+    const std::string name = path.filename().string();
+    const std::string extension = path.extension().string();
+    if (name.empty() || name[0] == '.' || extension == ".tmp" || extension == ".part") {
+        return false;
+    }
+    if (extension == ".dcm") {
+        return true;
+    }
+    // Extensionless modality output: accept Part 10 files by their DICM magic
+    std::ifstream in(path, std::ios::binary);
+    char header[132];
+    return in.read(header, sizeof(header)) && std::memcmp(header + 128, "DICM", 4) == 0;
+}
+
+std::string NewestDicom(const fs::path& folder, fs::file_time_type since) {
+    // The output a chain step just wrote, if any, becomes the next step's input
+    std::string newest;
+    fs::file_time_type newestTime = since;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(folder, ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".dcm") {
+            const auto written = entry.last_write_time(ec);
+            if (!ec && written >= newestTime) {
+                newestTime = written;
+                newest = entry.path().string();
+            }
+        }
+    }
+    return newest;
+}
+
+double Percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5));
+    return sorted[index];
+}
+
+class TreeWatcher {
+public:
+    // Nothing under `excluded` is watched, so the chain's own output never feeds back into the loop
+    explicit TreeWatcher(const fs::path& excluded) : fd_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)), excluded_(excluded) {}
+    ~TreeWatcher() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    int Descriptor() const { return fd_; }
+
+    // Watches `root` and every directory below it; returns the number of directories added
+    size_t AddTree(const fs::path& root) {
+        if (IsWithin(root.lexically_normal(), excluded_)) {
+            return 0;
+        }
+        size_t added = Add(root) ? 1 : 0;
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec), end; it != end; it.increment(ec)) {
+            if (!it->is_directory(ec)) {
+                continue;
+            }
+            if (IsWithin(it->path().lexically_normal(), excluded_)) {
+                it.disable_recursion_pending();
+                continue;
+            }
+            added += Add(it->path()) ? 1 : 0;
+        }
+        return added;
+    }
+
+    const fs::path* DirectoryOf(int wd) const {
+        auto it = directories_.find(wd);
+        return it == directories_.end() ? nullptr : &it->second;
+    }
+
+    void Forget(int wd) { directories_.erase(wd); }
+
+private:
+    bool Add(const fs::path& directory) {
+        // Close-after-write and rename-into are the two "file is complete" signals; IN_CREATE catches new subfolders
+        const int wd = inotify_add_watch(fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+        if (wd < 0) {
+            std::cerr << "Cannot watch " << directory << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        directories_[wd] = directory;
+        return true;
+    }
+
+    int fd_;
+    fs::path excluded_;
+    std::unordered_map<int, fs::path> directories_;
+};
+
+class IngestPipeline {
+public:
+    IngestPipeline(const CommandRegistry& registry, const std::vector<std::string>& chain, const CommandContext& base,
+                   const fs::path& root, const fs::path& excluded, unsigned int workers)
+        : registry_(registry), chain_(chain), base_(base), root_(root), excluded_(excluded),
+          // A short queue keeps backpressure on the event loop; inotify buffers further events in the kernel
+          queue_(workers * 2, workers, [this](IngestJob& job) { Process(job); }) {}
+
+    // Dispatches a file unless this exact version (path + mtime) is already queued or running; blocks while the
+    // queue is full. Files under the output directory are never ingested.
+    void Submit(const fs::path& path) {
+        std::error_code ec;
+        const auto written = fs::last_write_time(path, ec);
+        if (ec || IsWithin(path.lexically_normal(), excluded_) || !fs::is_regular_file(path, ec) || !IsCandidate(path)) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = dispatched_.find(path.string());
+            if (it != dispatched_.end() && it->second == written) {
+                return;
+            }
+            dispatched_[path.string()] = written;
+        }
+        queue_.Push({path, written, std::chrono::steady_clock::now()});
+    }
+
+    // Used after a kernel queue overflow: pick up anything not queued or running. Finished entries are pruned to
+    // keep long sessions bounded, so a file completed before the overflow may be processed once more.
+    void Rescan() {
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it(root_, fs::directory_options::skip_permission_denied, ec), end; it != end; it.increment(ec)) {
+            if (it->is_regular_file(ec)) {
+                Submit(it->path());
+            }
+        }
+    }
+
+    void Close() { queue_.Close(); }
+
+    std::string Summary(double seconds) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::sort(latencies_.begin(), latencies_.end());
+        std::ostringstream report;
+        report << std::fixed << std::setprecision(2);
+        report << "Ingested " << completed_ << " files (" << failed_ << " failed) in " << seconds << " s ("
+               << (seconds > 0 ? static_cast<double>(completed_) / seconds : 0.0) << " files/s)\n";
+        report << "Event-to-done latency ms: p50 " << Percentile(latencies_, 0.50) << ", p90 " << Percentile(latencies_, 0.90)
+               << ", p99 " << Percentile(latencies_, 0.99) << ", max " << (latencies_.empty() ? 0.0 : latencies_.back()) << "\n";
+        return report.str();
+    }
+
+    size_t Failed() const { return failed_; }
+
+private:
+    void Process(IngestJob& job) {
+        // Commands write fixed file names, so every file gets its own output folder
+        CommandContext ctx = base_;
+        ctx.inputPath = job.path.string();
+        ctx.outputDir = (fs::path(base_.outputDir) / "watch" / OutputFolderName(job.path.lexically_relative(root_))).string();
+        std::error_code ec;
+        fs::create_directories(ctx.outputDir, ec);
+
+        int rc = 0;
+        std::string failedStep;
+        for (const auto& step : chain_) {
+            const auto before = fs::file_time_type::clock::now();
+            try {
+                rc = registry_.Run(step, ctx);
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::cerr << "[watch] " << step << " threw: " << e.what() << std::endl;
+                rc = 1;
+            }
+            if (rc != 0) {
+                failedStep = step;
+                break;
+            }
+            const std::string produced = NewestDicom(ctx.outputDir, before);
+            if (!produced.empty()) {
+                ctx.inputPath = produced;
+            }
+        }
+
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - job.detected).count();
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Done with this version; a newer write already re-registered the path and keeps its own entry
+        auto entry = dispatched_.find(job.path.string());
+        if (entry != dispatched_.end() && entry->second == job.written) {
+            dispatched_.erase(entry);
+        }
+        ++completed_;
+        latencies_.push_back(ms);
+        if (rc != 0) {
+            ++failed_;
+        }
+        std::cout << "[watch] " << job.path.string() << " -> " << (rc == 0 ? "ok" : "failed at " + failedStep) << " ("
+                  << std::fixed << std::setprecision(1) << ms << " ms)" << std::defaultfloat << std::endl;
+    }
+
+    const CommandRegistry& registry_;
+    std::vector<std::string> chain_;
+    CommandContext base_;
+    fs::path root_;
+    fs::path excluded_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, fs::file_time_type> dispatched_;
+    std::vector<double> latencies_;
+    size_t completed_{0};
+    size_t failed_{0};
+    // Declared last so workers start after the bookkeeping exists
+    WorkQueue<IngestJob> queue_;
+};
+}
+
+int RunWatchMode(const CommandRegistry& registry, const std::vector<std::string>& chain, const CommandContext& base,
+                 const std::string& directory) {
+    const fs::path root = fs::absolute(directory).lexically_normal();
+    if (!fs::is_directory(root)) {
+        std::cerr << "--watch needs an existing directory: " << directory << std::endl;
+        return 1;
+    }
+    // The output folder may sit inside the watched tree; its files are results, not arrivals
+    const fs::path excluded = fs::absolute(base.outputDir).lexically_normal();
+    TreeWatcher watcher(excluded);
+    if (watcher.Descriptor() < 0) {
+        std::cerr << "inotify is unavailable: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    const size_t watched = watcher.AddTree(root);
+
+    // ITK and VTK filters already use every core, so chains with one of those (or the "all" suite, which runs them)
+    // take one file at a time; GDCM/DCMTK chains get a small pool. --concurrency overrides both.
+    bool multithreadedStep = false;
+    for (const auto& command : registry.GetCommands()) {
+        if (command.module != "GDCM" && command.module != "DCMTK" &&
+            std::find(chain.begin(), chain.end(), command.name) != chain.end()) {
+            multithreadedStep = true;
+        }
+    }
+    const unsigned int workers = base.concurrency > 0 ? base.concurrency
+                                 : multithreadedStep ? 1u
+                                                     : ParallelUtils::ResolveWorkerCount(4);
+    IngestPipeline pipeline(registry, chain, base, root, excluded, workers);
+    std::string chainText;
+    for (const auto& step : chain) {
+        chainText += (chainText.empty() ? "" : " -> ") + step;
+    }
+    std::cout << "Watching " << root << " (" << watched << " directories) with " << workers << " workers: " << chainText
+              << " (" << (base.duration > 0 ? std::to_string(base.duration) + " s" : "until Ctrl-C") << ")" << std::endl;
+
+    g_stopRequested = false;
+    auto previousHandler = std::signal(SIGINT, HandleStopSignal);
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::seconds(base.duration);
+    alignas(inotify_event) char buffer[64 * 1024];
+    while (!g_stopRequested && (base.duration == 0 || std::chrono::steady_clock::now() < deadline)) {
+        pollfd waiter{watcher.Descriptor(), POLLIN, 0};
+        if (poll(&waiter, 1, 500) <= 0) {
+            continue;
+        }
+        const ssize_t length = read(watcher.Descriptor(), buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            if (event->mask & IN_Q_OVERFLOW) {
+                std::cerr << "[watch] inotify queue overflowed; rescanning " << root << std::endl;
+                pipeline.Rescan();
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                watcher.Forget(event->wd);
+                continue;
+            }
+            const fs::path* parent = watcher.DirectoryOf(event->wd);
+            if (parent == nullptr || event->len == 0) {
+                continue;
+            }
+            const fs::path path = *parent / event->name;
+            if (event->mask & IN_ISDIR) {
+                watcher.AddTree(path);
+                // A directory moved in arrives complete. A freshly created one can gain files before its watch
+                // exists, so it is scanned too; files also reported by IN_CLOSE_WRITE are dropped by Submit.
+                std::error_code ec;
+                for (fs::recursive_directory_iterator it(path, ec), end; it != end; it.increment(ec)) {
+                    pipeline.Submit(it->path());
+                }
+            } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                pipeline.Submit(path);
+            }
+        }
+    }
+    std::signal(SIGINT, previousHandler);
+
+    std::cout << "[watch] Stopping; finishing queued files..." << std::endl;
+    pipeline.Close();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const std::string report = pipeline.Summary(seconds);
+    std::cout << report;
+    std::ofstream((fs::path(base.outputDir) / "watch_report.txt").string()) << report;
+    return pipeline.Failed() == 0 ? 0 : 1;
+}
+#else
+int RunWatchMode(const CommandRegistry&, const std::vector<std::string>&, const CommandContext&, const std::string&) {
+    std::cerr << "--watch relies on inotify and is only available on Linux." << std::endl;
+    return 1;
+}
+#endif
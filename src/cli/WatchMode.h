@@ -0,0 +1,24 @@
+//
+// WatchMode.h
+// DicomToolsCpp
+//
+// Declares the watch-folder ingest loop that runs a command chain on every file that finishes arriving in a directory.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "CommandRegistry.h"
+
+// Split "gdcm:anonymize,gdcm:transcode-rle" into the ordered chain applied to each ingested file
+std::vector<std::string> ParseCommandChain(const std::string& command);
+
+// Watch `directory` (recursively) and run `chain` on each file once its writer closes it or it is moved in.
+// Each file gets its own folder under base.outputDir/watch; a step's newest .dcm output feeds the next step.
+// base.outputDir is never watched or ingested, even when it lies inside `directory`.
+// Runs until Ctrl-C or base.duration seconds and returns a process exit code.
+int RunWatchMode(const CommandRegistry& registry, const std::vector<std::string>& chain, const CommandContext& base,
+                 const std::string& directory);
@@ -14,6 +14,7 @@
 #include "cli/CLIOptions.h"
 #include "cli/CLIParser.h"
 #include "cli/CommandRegistry.h"
+#include "cli/WatchMode.h"
 #include "modules/DCMTK/DCMTKTestInterface.h"
 #include "modules/GDCM/GDCMTestInterface.h"
 #include "modules/ITK/ITKTestInterface.h"
@@ -87,6 +88,50 @@ void PrintModuleSummary(const std::vector<ModuleSummary>& modules) {
     std::cout << std::endl;
 }
 
+CommandContext MakeContext(const CLIOptions& options, const std::string& inputPath) {
+    // Single place that copies parsed options into the context every command receives; fields are assigned by name
+    // so adding or reordering members cannot silently shift values between neighbours of the same type
+    CommandContext ctx;
+    ctx.inputPath = inputPath;
+    ctx.outputDir = options.outputDir;
+    ctx.verbose = options.verbose;
+    ctx.verify = options.verify;
+    ctx.query = options.query;
+    ctx.frameStep = options.frameStep;
+    ctx.port = options.port;
+    ctx.concurrency = options.concurrency;
+    ctx.duration = options.duration;
+    ctx.allowRemote = options.allowRemote;
+    ctx.onArrival = options.onArrival;
+    ctx.deflateLevel = options.deflateLevel;
+    ctx.threads = options.threads;
+    ctx.itkBackend = options.itkBackend;
+    ctx.maxMemory = options.maxMemory;
+    ctx.streamFormat = options.streamFormat;
+    ctx.gaussianEngine = options.gaussianEngine;
+    ctx.sigma = options.sigma;
+    ctx.medianEngine = options.medianEngine;
+    ctx.radius = options.radius;
+    ctx.precision = options.precision;
+    ctx.resampleEngine = options.resampleEngine;
+    ctx.interpolation = options.interpolation;
+    ctx.antialias = options.antialias;
+    ctx.projection = options.projection;
+    ctx.axis = options.axis;
+    ctx.slabThickness = options.slabThickness;
+    ctx.slabStep = options.slabStep;
+    ctx.equalizeEngine = options.equalizeEngine;
+    ctx.tiles = options.tiles;
+    ctx.clipLimit = options.clipLimit;
+    ctx.alpha = options.alpha;
+    ctx.beta = options.beta;
+    ctx.connectivity = options.connectivity;
+    ctx.minSize = options.minSize;
+    ctx.intensityPath = options.intensityPath;
+    ctx.maskOp = options.maskOp;
+    return ctx;
+}
+
 int main(int argc, char* argv[]) {
     std::cout << "========================================" << std::endl;
     std::cout << "      Dicom-Tools-cpp Command Suite     " << std::endl;
@@ -118,6 +163,10 @@ int main(int argc, char* argv[]) {
     });
 
     CLIOptions options = ParseCLIArgs(argc, argv, registry);
+    if (options.invalid) {
+        // Falling back to the default path would silently ignore what was asked for, e.g. the memory budget
+        return 1;
+    }
 
     if (options.modules) {
         PrintModuleSummary(BuildModuleSummaries());
@@ -136,6 +185,27 @@ int main(int argc, char* argv[]) {
         return options.command.empty() ? 1 : 0;
     }
 
+    if (!options.watchDir.empty()) {
+        // Ingest mode: no single input; every file that lands in the folder goes through the chain
+        const std::vector<std::string> chain = ParseCommandChain(options.command);
+        for (const auto& step : chain) {
+            if (!registry.Exists(step)) {
+                std::cerr << "Unknown command in --watch chain: " << step << std::endl;
+                return 1;
+            }
+        }
+        if (chain.empty() || !FileSystemUtils::EnsureOutputDir(options.outputDir)) {
+            return 1;
+        }
+        // Files are processed concurrently, so ITK's global threader is set once here rather than per command
+        if (!ITKTests::ConfigureThreading(options.threads, options.itkBackend)) {
+            return 1;
+        }
+        CommandContext base = MakeContext(options, "");
+        base.sharedProcess = true;
+        return RunWatchMode(registry, chain, base, options.watchDir);
+    }
+
     if (!registry.Exists(options.command)) {
         std::cerr << "Unknown command: " << options.command << std::endl;
         PrintUsage(std::cout, registry);
@@ -158,8 +228,7 @@ int main(int argc, char* argv[]) {
     }
 
     // Execute the selected command in the shared context
-    CommandContext ctx{inputPath, options.outputDir, options.verbose};
-    int result = registry.Run(options.command, ctx);
+    int result = registry.Run(options.command, MakeContext(options, inputPath));
 
     std::cout << "========================================" << std::endl;
     return result;
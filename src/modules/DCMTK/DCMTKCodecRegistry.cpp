@@ -0,0 +1,92 @@
+//
+// DCMTKCodecRegistry.cpp
+// DicomToolsCpp
+//
+// Implements one-time JPEG/RLE codec registration for DCMTK and reports which transfer syntaxes are usable.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#include "DCMTKCodecRegistry.h"
+
+#include <iomanip>
+
+#ifdef USE_DCMTK
+#include "dcmtk/config/osconfig.h"
+#include "dcmtk/dcmdata/dccodec.h"
+#include "dcmtk/dcmdata/dcrledrg.h"
+#include "dcmtk/dcmdata/dcrleerg.h"
+#include "dcmtk/dcmdata/dcxfer.h"
+#include "dcmtk/dcmjpeg/djdecode.h"
+#include "dcmtk/dcmjpeg/djencode.h"
+
+DCMTKCodecRegistry& DCMTKCodecRegistry::Instance() {
+    // Function-local static: C++11 guarantees a single, race-free construction even from worker threads
+    static DCMTKCodecRegistry registry;
+    return registry;
+}
+
+DCMTKCodecRegistry::DCMTKCodecRegistry() {
+    // Registering mutates DcmCodecList, so it must never overlap with encodes/decodes on other threads.
+    // Doing it exactly once up front makes concurrent transcodes safe (the list is read-locked while in use).
+    DJDecoderRegistration::registerCodecs();
+    DJEncoderRegistration::registerCodecs();
+    DcmRLEDecoderRegistration::registerCodecs();
+    DcmRLEEncoderRegistration::registerCodecs();
+}
+
+DCMTKCodecRegistry::~DCMTKCodecRegistry() {
+    DJDecoderRegistration::cleanup();
+    DJEncoderRegistration::cleanup();
+    DcmRLEDecoderRegistration::cleanup();
+    DcmRLEEncoderRegistration::cleanup();
+}
+
+std::vector<DCMTKCodecInfo> DCMTKCodecRegistry::AvailableCodecs() const {
+    const E_TransferSyntax candidates[] = {
+        EXS_JPEGProcess1,
+        EXS_JPEGProcess2_4,
+        EXS_JPEGProcess14,
+        EXS_JPEGProcess14SV1,
+        EXS_RLELossless
+    };
+
+    std::vector<DCMTKCodecInfo> codecs;
+    for (E_TransferSyntax xfer : candidates) {
+        DcmXfer info(xfer);
+        DCMTKCodecInfo codec;
+        codec.name = info.getXferName();
+        codec.transferSyntaxUID = info.getXferID();
+        codec.canDecode = DcmCodecList::canChangeCoding(xfer, EXS_LittleEndianExplicit);
+        codec.canEncode = DcmCodecList::canChangeCoding(EXS_LittleEndianExplicit, xfer);
+        codecs.push_back(codec);
+    }
+    return codecs;
+}
+
+#else
+DCMTKCodecRegistry& DCMTKCodecRegistry::Instance() {
+    static DCMTKCodecRegistry registry;
+    return registry;
+}
+
+DCMTKCodecRegistry::DCMTKCodecRegistry() = default;
+DCMTKCodecRegistry::~DCMTKCodecRegistry() = default;
+
+std::vector<DCMTKCodecInfo> DCMTKCodecRegistry::AvailableCodecs() const {
+    return {};
+}
+#endif
+
+void DCMTKCodecRegistry::Print(std::ostream& os) const {
+    const std::vector<DCMTKCodecInfo> codecs = AvailableCodecs();
+    if (codecs.empty()) {
+        os << "No DCMTK codecs registered." << std::endl;
+        return;
+    }
+    for (const auto& codec : codecs) {
+        os << "  " << std::left << std::setw(28) << codec.transferSyntaxUID
+           << " decode:" << (codec.canDecode ? "yes" : "no ")
+           << " encode:" << (codec.canEncode ? "yes" : "no ")
+           << "  " << codec.name << std::endl;
+    }
+}
@@ -0,0 +1,40 @@
+//
+// DCMTKCodecRegistry.h
+// DicomToolsCpp
+//
+// Declares the process-wide owner of DCMTK codec registration so transcodes never register/cleanup per call.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct DCMTKCodecInfo {
+    // One transfer syntax and whether the registered codecs can read and/or write it
+    std::string name;
+    std::string transferSyntaxUID;
+    bool canDecode{false};
+    bool canEncode{false};
+};
+
+class DCMTKCodecRegistry {
+public:
+    // First call registers the JPEG and RLE codecs; initialization is thread-safe and happens once per process.
+    // Codecs are released automatically at process exit, so callers never pair this with a cleanup.
+    static DCMTKCodecRegistry& Instance();
+
+    // Snapshot of the transfer syntaxes covered by the registered codecs
+    std::vector<DCMTKCodecInfo> AvailableCodecs() const;
+    // Print the availability table (used by dcmtk:codecs)
+    void Print(std::ostream& os) const;
+
+    DCMTKCodecRegistry(const DCMTKCodecRegistry&) = delete;
+    DCMTKCodecRegistry& operator=(const DCMTKCodecRegistry&) = delete;
+
+private:
+    DCMTKCodecRegistry();
+    ~DCMTKCodecRegistry();
+};
@@ -7,23 +7,48 @@
 // Thales Matheus Mendonça Santos - November 2025
 
 #include "DCMTKFeatureActions.h"
+#include "DCMTKCodecRegistry.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <tuple>
 #include <vector>
 
+#include "utils/FileSystemUtils.h"
+#include "utils/ImageMetrics.h"
+#include "utils/ParallelDeflate.h"
+#include "utils/ParallelUtils.h"
+#include "utils/PixelHash.h"
+
 #ifdef USE_DCMTK
 #include "dcmtk/config/osconfig.h"
 #include "dcmtk/dcmdata/dcdicdir.h"
 #include "dcmtk/dcmdata/dcddirif.h"
+#include "dcmtk/dcmdata/dcfcache.h"
 #include "dcmtk/dcmdata/dctk.h"
 #include "dcmtk/dcmimgle/dcmimage.h"
-#include "dcmtk/dcmdata/dcrledrg.h"
-#include "dcmtk/dcmdata/dcrleerg.h"
+#include "dcmtk/dcmimage/diregist.h"
+#ifdef WITH_LIBPNG
+#include "dcmtk/dcmimage/dipipng.h"
+#endif
 #include "dcmtk/dcmdata/dcxfer.h"
-#include "dcmtk/dcmjpeg/djdecode.h"
-#include "dcmtk/dcmjpeg/djencode.h"
+#include "dcmtk/dcmjpeg/djrploss.h"
 
 namespace fs = std::filesystem;
 
@@ -32,6 +57,336 @@ namespace {
 std::string JoinPath(const std::string& base, const std::string& filename) {
     return (fs::path(base) / filename).string();
 }
+
+struct FrameWorker {
+    // Per-thread dataset handle; DCMTK datasets must not be shared between threads
+    DcmFileFormat file;
+    DcmElement* pixelData{nullptr};
+    DcmFileCache cache;
+    std::vector<Uint8> buffer;
+};
+
+bool HashFrames(const std::string& filename, std::vector<PixelHash::Hash128>& hashes, std::string& error) {
+    // loadFile leaves large values on disk by default, so pixel data is pulled frame by frame on demand
+    DcmFileFormat probe;
+    if (probe.loadFile(filename.c_str()).bad()) {
+        error = "could not read " + filename;
+        return false;
+    }
+    Sint32 frameCount = 1;
+    if (probe.getDataset()->findAndGetSint32(DCM_NumberOfFrames, frameCount).bad() || frameCount < 1) {
+        frameCount = 1;
+    }
+    const std::size_t frames = static_cast<std::size_t>(frameCount);
+    hashes.assign(frames, PixelHash::Hash128{});
+
+    const unsigned int workerCount = ParallelUtils::ResolveWorkerCount(frames);
+    std::vector<std::unique_ptr<FrameWorker>> workers(workerCount);
+    std::atomic<bool> failed{false};
+
+    ParallelUtils::ParallelFor(frames, workerCount, [&](unsigned int id, std::size_t frame) {
+        if (failed.load()) {
+            return;
+        }
+        auto& worker = workers[id];
+        if (!worker) {
+            worker = std::make_unique<FrameWorker>();
+            if (worker->file.loadFile(filename.c_str()).bad() ||
+                worker->file.getDataset()->findAndGetElement(DCM_PixelData, worker->pixelData).bad()) {
+                failed.store(true);
+                return;
+            }
+        }
+
+        DcmDataset* dataset = worker->file.getDataset();
+        Uint32 frameSize = 0;
+        if (worker->pixelData->getUncompressedFrameSize(dataset, frameSize).bad() || frameSize == 0) {
+            failed.store(true);
+            return;
+        }
+        worker->buffer.resize(frameSize);
+
+        // startFragment = 0 lets DCMTK locate the frame through the offset table, so frames can arrive out of order
+        Uint32 startFragment = 0;
+        OFString colorModel;
+        OFCondition status = worker->pixelData->getUncompressedFrame(dataset, static_cast<Uint32>(frame), startFragment,
+                                                                     worker->buffer.data(), frameSize, colorModel,
+                                                                     &worker->cache);
+        if (status.bad()) {
+            failed.store(true);
+            return;
+        }
+        hashes[frame] = PixelHash::HashBuffer(worker->buffer.data(), frameSize);
+    });
+
+    if (failed.load()) {
+        error = "frame decode failed for " + filename;
+        return false;
+    }
+    return true;
+}
+
+bool VerifyLosslessRoundTrip(const std::string& sourceFile, const std::string& outputFile) {
+    return PixelHash::VerifyRoundTrip(sourceFile, outputFile, HashFrames);
+}
+
+struct MediaEntry {
+    // One source instance, where it lives on the media, and the header fields used to order DICOMDIR records
+    fs::path source;
+    fs::path staged;
+    std::string fileID;
+    std::string patientID;
+    std::string studyUID;
+    std::string seriesUID;
+    std::string sopInstanceUID;
+    Sint32 instanceNumber{0};
+    bool valid{false};
+};
+
+struct DicomDirInstance {
+    // Flattened PATIENT/STUDY/SERIES/IMAGE path for a single leaf record
+    std::string patientID;
+    std::string patientName;
+    std::string studyUID;
+    std::string studyDate;
+    std::string studyDescription;
+    std::string seriesUID;
+    std::string modality;
+    std::string sopInstanceUID;
+    std::string fileID;
+};
+
+std::string RecordString(DcmDirectoryRecord* record, const DcmTagKey& tag) {
+    OFString value;
+    if (record->findAndGetOFStringArray(tag, value).good()) {
+        return value.c_str();
+    }
+    return "";
+}
+
+// DICOMDIR file IDs use '\' separators and are case-insensitive on most media, so compare a normalized form
+std::string NormalizeFileID(std::string fileID) {
+    for (auto& c : fileID) {
+        c = (c == '\\') ? '/' : static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    return fileID;
+}
+
+bool LoadDicomDirIndex(const std::string& path, std::vector<DicomDirInstance>& instances, std::string& error) {
+    // Only the DICOMDIR itself is parsed; referenced files are never opened
+    DcmDicomDir dicomdir(path.c_str());
+    if (dicomdir.error().bad()) {
+        error = dicomdir.error().text();
+        return false;
+    }
+    DcmDirectoryRecord& root = dicomdir.getRootRecord();
+    for (unsigned long p = 0; p < root.cardSub(); ++p) {
+        DcmDirectoryRecord* patient = root.getSub(p);
+        if (patient == nullptr || patient->getRecordType() != ERT_Patient) {
+            continue;
+        }
+        for (unsigned long s = 0; s < patient->cardSub(); ++s) {
+            DcmDirectoryRecord* study = patient->getSub(s);
+            for (unsigned long r = 0; study != nullptr && r < study->cardSub(); ++r) {
+                DcmDirectoryRecord* series = study->getSub(r);
+                for (unsigned long i = 0; series != nullptr && i < series->cardSub(); ++i) {
+                    DcmDirectoryRecord* leaf = series->getSub(i);
+                    if (leaf == nullptr) {
+                        continue;
+                    }
+                    DicomDirInstance instance;
+                    instance.patientID = RecordString(patient, DCM_PatientID);
+                    instance.patientName = RecordString(patient, DCM_PatientName);
+                    instance.studyUID = RecordString(study, DCM_StudyInstanceUID);
+                    instance.studyDate = RecordString(study, DCM_StudyDate);
+                    instance.studyDescription = RecordString(study, DCM_StudyDescription);
+                    instance.seriesUID = RecordString(series, DCM_SeriesInstanceUID);
+                    instance.modality = RecordString(series, DCM_Modality);
+                    instance.sopInstanceUID = RecordString(leaf, DCM_ReferencedSOPInstanceUIDInFile);
+                    instance.fileID = RecordString(leaf, DCM_ReferencedFileID);
+                    instances.push_back(std::move(instance));
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool CollectMediaEntries(const std::string& directory, const fs::path& mediaRoot, std::vector<MediaEntry>& entries) {
+    // Mirror the source tree into the media folder to keep relative paths intact
+    fs::path sourceRoot = fs::is_directory(directory) ? fs::path(directory) : fs::path(directory).parent_path();
+    if (sourceRoot.empty() || !fs::exists(sourceRoot)) {
+        std::cerr << "Input path is invalid for DICOMDIR generation." << std::endl;
+        return false;
+    }
+
+    std::error_code ec;
+    for (const auto& entry : fs::recursive_directory_iterator(sourceRoot)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".dcm") {
+            MediaEntry media;
+            media.source = entry.path();
+            ec.clear();
+            fs::path relative = fs::relative(media.source, sourceRoot, ec);
+            if (ec) {
+                relative = media.source.filename();
+            }
+            media.staged = mediaRoot / relative;
+            media.fileID = NormalizeFileID(relative.generic_string());
+            entries.push_back(std::move(media));
+        }
+    }
+
+    if (entries.empty()) {
+        std::cerr << "No DICOM files found under " << sourceRoot << " to include in DICOMDIR." << std::endl;
+        return false;
+    }
+
+    ec.clear();
+    fs::create_directories(mediaRoot, ec);
+    if (ec) {
+        std::cerr << "Failed to create media output root: " << mediaRoot << " (" << ec.message() << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+size_t StageMediaEntries(std::vector<MediaEntry>& entries) {
+    // Create the directory skeleton up front so staging threads only touch files
+    std::set<fs::path> parents;
+    for (const auto& entry : entries) {
+        parents.insert(entry.staged.parent_path());
+    }
+    for (const auto& parent : parents) {
+        std::error_code mkdirEc;
+        fs::create_directories(parent, mkdirEc);
+        if (mkdirEc) {
+            std::cerr << "Failed to create directory " << parent << " (" << mkdirEc.message() << ")" << std::endl;
+        }
+    }
+
+    // Stage with reflinks/hardlinks where possible so large studies are not duplicated on disk
+    using FileSystemUtils::StageMethod;
+    std::map<StageMethod, size_t> methodCounts;
+    std::mutex mutex;
+    ParallelUtils::ParallelFor(entries.size(), 0, [&](unsigned int, size_t i) {
+        StageMethod method = StageMethod::Copy;
+        std::string error;
+        const bool staged =
+            FileSystemUtils::StageFile(entries[i].source.string(), entries[i].staged.string(), method, error);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (staged) {
+            entries[i].valid = true;
+            ++methodCounts[method];
+        } else {
+            std::cerr << "Failed to stage " << entries[i].source << " -> " << entries[i].staged << " (" << error << ")" << std::endl;
+        }
+    });
+
+    size_t stagedCount = 0;
+    std::string breakdown;
+    for (const StageMethod method :
+         {StageMethod::Reflink, StageMethod::Hardlink, StageMethod::CopyRange, StageMethod::Copy}) {
+        const size_t count = methodCounts[method];
+        stagedCount += count;
+        breakdown += std::string(breakdown.empty() ? "" : ", ") + FileSystemUtils::StageMethodName(method) + " " +
+                     std::to_string(count);
+    }
+    std::cout << "Staged " << stagedCount << " files (" << breakdown << ")" << std::endl;
+    return stagedCount;
+}
+
+void ReadMediaHeaders(std::vector<MediaEntry>& entries) {
+    // Read the headers that decide record order and duplicate skipping in parallel; pixel data is never loaded.
+    // This does not replace the record build: addDicomFile parses each file again, serially.
+    std::mutex logMutex;
+    ParallelUtils::ParallelFor(entries.size(), 0, [&](unsigned int, size_t i) {
+        MediaEntry& entry = entries[i];
+        if (!entry.valid) {
+            return;
+        }
+        DcmFileFormat header;
+        if (header.loadFileUntilTag(OFFilename(entry.staged.c_str()), EXS_Unknown, EGL_noChange,
+                                    DCM_MaxReadLength, ERM_autoDetect, DCM_PixelData).bad()) {
+            entry.valid = false;
+            std::lock_guard<std::mutex> lock(logMutex);
+            std::cerr << "  Skipped " << entry.source << ": unreadable header" << std::endl;
+            return;
+        }
+        DcmDataset* dataset = header.getDataset();
+        OFString value;
+        if (dataset->findAndGetOFString(DCM_PatientID, value).good()) entry.patientID = value.c_str();
+        if (dataset->findAndGetOFString(DCM_StudyInstanceUID, value).good()) entry.studyUID = value.c_str();
+        if (dataset->findAndGetOFString(DCM_SeriesInstanceUID, value).good()) entry.seriesUID = value.c_str();
+        if (dataset->findAndGetOFString(DCM_SOPInstanceUID, value).good()) entry.sopInstanceUID = value.c_str();
+        dataset->findAndGetSint32(DCM_InstanceNumber, entry.instanceNumber);
+    });
+    std::sort(entries.begin(), entries.end(), [](const MediaEntry& a, const MediaEntry& b) {
+        return std::tie(a.patientID, a.studyUID, a.seriesUID, a.instanceNumber, a.staged) <
+               std::tie(b.patientID, b.studyUID, b.seriesUID, b.instanceNumber, b.staged);
+    });
+}
+
+size_t AddMediaRecords(DicomDirInterface& dirif, const std::vector<MediaEntry>& entries, const fs::path& mediaRoot) {
+    // DicomDirInterface is not thread-safe and builds each record from its own read of the file, so insertion is
+    // serial in patient/study/series/instance order; unreadable files were already dropped by ReadMediaHeaders
+    OFFilename rootDir(mediaRoot.c_str());
+    size_t added = 0;
+    for (const auto& entry : entries) {
+        if (!entry.valid) {
+            continue;
+        }
+        OFCondition status = dirif.addDicomFile(OFFilename(entry.staged.c_str()), rootDir);
+        if (status.good()) {
+            ++added;
+        } else {
+            std::cerr << "  Skipped " << entry.source << ": " << status.text() << std::endl;
+        }
+    }
+    return added;
+}
+
+// Accepts a DICOMDIR path, a media folder containing one, or falls back to the default media root
+std::string ResolveDicomDirPath(const std::string& inputPath, const std::string& outputDir) {
+    fs::path candidate(inputPath);
+    if (!inputPath.empty() && candidate.filename() == "DICOMDIR" && fs::is_regular_file(candidate)) {
+        return candidate.string();
+    }
+    if (!inputPath.empty() && fs::is_directory(candidate) && fs::is_regular_file(candidate / "DICOMDIR")) {
+        return (candidate / "DICOMDIR").string();
+    }
+    return (fs::path(outputDir) / "dicomdir_media" / "DICOMDIR").string();
+}
+
+bool MatchesTerm(const std::string& field, const std::string& value) {
+    if (!value.empty() && value.back() == '*') {
+        return field.compare(0, value.size() - 1, value, 0, value.size() - 1) == 0;
+    }
+    return field == value;
+}
+
+// --query is a comma-separated list of key=value terms; a trailing '*' turns a value into a prefix match
+bool MatchesQuery(const DicomDirInstance& instance, const std::vector<std::pair<std::string, std::string>>& terms) {
+    for (const auto& term : terms) {
+        bool matched = false;
+        if (term.first == "patient") {
+            matched = MatchesTerm(instance.patientID, term.second) || MatchesTerm(instance.patientName, term.second);
+        } else if (term.first == "study") {
+            matched = MatchesTerm(instance.studyUID, term.second);
+        } else if (term.first == "series") {
+            matched = MatchesTerm(instance.seriesUID, term.second);
+        } else if (term.first == "instance" || term.first == "sop") {
+            matched = MatchesTerm(instance.sopInstanceUID, term.second);
+        } else if (term.first == "modality") {
+            matched = MatchesTerm(instance.modality, term.second);
+        } else if (term.first == "date") {
+            matched = MatchesTerm(instance.studyDate, term.second);
+        }
+        if (!matched) {
+            return false;
+        }
+    }
+    return true;
+}
 }
 
 void DCMTKTests::TestTagModification(const std::string& filename, const std::string& outputDir) {
@@ -89,120 +444,203 @@ void DCMTKTests::TestPixelDataExtraction(const std::string& filename, const std:
 }
 
 void DCMTKTests::TestDICOMDIRGeneration(const std::string& directory, const std::string& outputDir) {
-    // Copies an input series to a fake media root and builds a DICOMDIR index
+    // Stages an input series into a fake media root (reflink/hardlink when possible) and builds a DICOMDIR index
     std::cout << "--- [DCMTK] DICOMDIR Generation ---" << std::endl;
-    fs::path sourceRoot = fs::is_directory(directory) ? fs::path(directory) : fs::path(directory).parent_path();
     fs::path mediaRoot = fs::path(outputDir) / "dicomdir_media";
-    if (sourceRoot.empty() || !fs::exists(sourceRoot)) {
-        std::cerr << "Input path is invalid for DICOMDIR generation." << std::endl;
+    std::vector<MediaEntry> entries;
+    if (!CollectMediaEntries(directory, mediaRoot, entries)) {
         return;
     }
+    StageMediaEntries(entries);
+    ReadMediaHeaders(entries);
 
-    std::vector<fs::path> dicomFiles;
-    for (const auto& entry : fs::recursive_directory_iterator(sourceRoot)) {
-        if (entry.is_regular_file() && entry.path().extension() == ".dcm") {
-            dicomFiles.push_back(entry.path());
-        }
+    std::string dicomdirPath = (mediaRoot / "DICOMDIR").string();
+    DicomDirInterface dirif;
+    dirif.disableConsistencyCheck(OFTrue);
+    OFCondition status = dirif.createNewDicomDir(DicomDirInterface::AP_GeneralPurpose, OFFilename(dicomdirPath.c_str()), "DICOMTOOLS");
+    if (status.bad()) {
+        std::cerr << "Failed to create DICOMDIR scaffold: " << status.text() << std::endl;
+        return;
     }
 
-    if (dicomFiles.empty()) {
-        std::cerr << "No DICOM files found under " << sourceRoot << " to include in DICOMDIR." << std::endl;
+    const size_t added = AddMediaRecords(dirif, entries, mediaRoot);
+    status = dirif.writeDicomDir();
+    if (status.good()) {
+        std::cout << "Wrote DICOMDIR (" << added << " entries) to '" << dicomdirPath << "'" << std::endl;
+        std::cout << "Media root (relative references): " << mediaRoot << std::endl;
+    } else {
+        std::cerr << "Failed to write DICOMDIR: " << status.text() << std::endl;
+    }
+}
+
+void DCMTKTests::TestDICOMDIRUpdate(const std::string& directory, const std::string& outputDir) {
+    // Appends only instances the existing DICOMDIR does not reference yet; known files are never restaged or reopened
+    std::cout << "--- [DCMTK] DICOMDIR Update ---" << std::endl;
+    fs::path mediaRoot = fs::path(outputDir) / "dicomdir_media";
+    std::string dicomdirPath = (mediaRoot / "DICOMDIR").string();
+    if (!fs::is_regular_file(dicomdirPath)) {
+        std::cout << "No existing DICOMDIR at '" << dicomdirPath << "'; building a new one." << std::endl;
+        TestDICOMDIRGeneration(directory, outputDir);
         return;
     }
 
-    // Mirror the source tree into a temporary media folder to keep relative paths intact
-    std::error_code ec;
-    fs::create_directories(mediaRoot, ec);
-    if (ec) {
-        std::cerr << "Failed to create media output root: " << mediaRoot << " (" << ec.message() << ")" << std::endl;
+    std::vector<DicomDirInstance> indexed;
+    std::string error;
+    if (!LoadDicomDirIndex(dicomdirPath, indexed, error)) {
+        std::cerr << "Failed to read existing DICOMDIR: " << error << std::endl;
         return;
     }
+    std::set<std::string> knownFiles;
+    std::set<std::string> knownInstances;
+    for (const auto& instance : indexed) {
+        knownFiles.insert(NormalizeFileID(instance.fileID));
+        knownInstances.insert(instance.sopInstanceUID);
+    }
 
-    size_t copied = 0;
-    for (const auto& dicom : dicomFiles) {
-        ec.clear();
-        fs::path relative = fs::relative(dicom, sourceRoot, ec);
-        if (ec) {
-            relative = dicom.filename();
-        }
-        fs::path dest = mediaRoot / relative;
-        std::error_code mkdirEc;
-        fs::create_directories(dest.parent_path(), mkdirEc);
-        if (mkdirEc) {
-            std::cerr << "Failed to create directory for " << dest << " (" << mkdirEc.message() << ")" << std::endl;
-            continue;
-        }
-        std::error_code copyErr;
-        fs::copy_file(dicom, dest, fs::copy_options::overwrite_existing, copyErr);
-        if (!copyErr) {
-            ++copied;
-        } else {
-            std::cerr << "Failed to copy " << dicom << " -> " << dest << " (" << copyErr.message() << ")" << std::endl;
+    std::vector<MediaEntry> entries;
+    if (!CollectMediaEntries(directory, mediaRoot, entries)) {
+        return;
+    }
+    const size_t scanned = entries.size();
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const MediaEntry& entry) {
+        return knownFiles.count(entry.fileID) > 0;
+    }), entries.end());
+    if (entries.empty()) {
+        std::cout << "DICOMDIR already references all " << scanned << " files (" << indexed.size() << " records); nothing to add." << std::endl;
+        return;
+    }
+
+    StageMediaEntries(entries);
+    ReadMediaHeaders(entries);
+    size_t duplicates = 0;
+    for (auto& entry : entries) {
+        // Same instance under a new path (e.g. re-sent media) would create a duplicate record
+        if (entry.valid && knownInstances.count(entry.sopInstanceUID) > 0) {
+            entry.valid = false;
+            ++duplicates;
         }
     }
 
-    std::string dicomdirPath = (mediaRoot / "DICOMDIR").string();
-    OFFilename dicomdirName(dicomdirPath.c_str());
-    OFFilename rootDir(mediaRoot.c_str());
     DicomDirInterface dirif;
     dirif.disableConsistencyCheck(OFTrue);
-    OFCondition status = dirif.createNewDicomDir(DicomDirInterface::AP_GeneralPurpose, dicomdirName, "DICOMTOOLS");
+    OFCondition status = dirif.appendToDicomDir(DicomDirInterface::AP_GeneralPurpose, OFFilename(dicomdirPath.c_str()));
     if (status.bad()) {
-        std::cerr << "Failed to create DICOMDIR scaffold: " << status.text() << std::endl;
+        std::cerr << "Failed to open DICOMDIR for append: " << status.text() << std::endl;
         return;
     }
 
-    size_t added = 0;
-    for (const auto& dicom : dicomFiles) {
-        // Use relative paths inside the media root to mimic disc layout
-        ec.clear();
-        fs::path relative = fs::relative(dicom, sourceRoot, ec);
-        if (ec) {
-            relative = dicom.filename();
-        }
-        fs::path copiedPath = mediaRoot / relative;
-        status = dirif.addDicomFile(OFFilename(copiedPath.c_str()), rootDir);
-        if (status.good()) {
-            ++added;
-        } else {
-            std::cerr << "  Skipped " << dicom << ": " << status.text() << std::endl;
-        }
-    }
-
+    const size_t added = AddMediaRecords(dirif, entries, mediaRoot);
     status = dirif.writeDicomDir();
     if (status.good()) {
-        std::cout << "Copied " << copied << " files and wrote DICOMDIR (" << added << " entries) to '" << dicomdirPath << "'" << std::endl;
-        std::cout << "Media root (relative references): " << mediaRoot << std::endl;
+        std::cout << "Appended " << added << " new entries to '" << dicomdirPath << "' (" << indexed.size()
+                  << " existing, " << (scanned - entries.size()) << " files already referenced, "
+                  << duplicates << " known SOP Instance UIDs skipped)" << std::endl;
     } else {
         std::cerr << "Failed to write DICOMDIR: " << status.text() << std::endl;
     }
 }
 
-void DCMTKTests::TestLosslessJPEGReencode(const std::string& filename, const std::string& outputDir) {
+void DCMTKTests::TestDICOMDIRQuery(const std::string& path, const std::string& outputDir, const std::string& query) {
+    // Answers patient/study/series/instance lookups from DICOMDIR records alone
+    std::cout << "--- [DCMTK] DICOMDIR Query ---" << std::endl;
+    std::string dicomdirPath = ResolveDicomDirPath(path, outputDir);
+    if (!fs::is_regular_file(dicomdirPath)) {
+        std::cerr << "No DICOMDIR found at '" << dicomdirPath << "'. Run dcmtk:dicomdir first." << std::endl;
+        return;
+    }
+
+    std::vector<std::pair<std::string, std::string>> terms;
+    std::stringstream queryStream(query);
+    std::string term;
+    while (std::getline(queryStream, term, ',')) {
+        if (term.empty()) {
+            continue;
+        }
+        const auto eq = term.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "Ignoring malformed query term '" << term << "' (expected key=value)" << std::endl;
+            continue;
+        }
+        terms.emplace_back(term.substr(0, eq), term.substr(eq + 1));
+    }
+
+    std::vector<DicomDirInstance> instances;
+    std::string error;
+    if (!LoadDicomDirIndex(dicomdirPath, instances, error)) {
+        std::cerr << "Failed to read DICOMDIR: " << error << std::endl;
+        return;
+    }
+
+    std::string outPath = JoinPath(outputDir, "dcmtk_dicomdir_query.txt");
+    std::ofstream out(outPath);
+    if (!out.is_open()) {
+        std::cerr << "Failed to open " << outPath << " for writing." << std::endl;
+        return;
+    }
+    out << "DICOMDIR: " << dicomdirPath << "\n";
+    out << "Query: " << (query.empty() ? "(all)" : query) << "\n";
+
+    // Records come back in PATIENT/STUDY/SERIES order, so headers are printed only when a level changes
+    size_t matches = 0;
+    std::set<std::string> patients;
+    std::set<std::string> studies;
+    std::set<std::string> series;
+    std::string lastPatient;
+    std::string lastStudy;
+    std::string lastSeries;
+    for (const auto& instance : instances) {
+        if (!MatchesQuery(instance, terms)) {
+            continue;
+        }
+        ++matches;
+        if (matches == 1 || instance.patientID != lastPatient) {
+            out << "PATIENT " << instance.patientID << " [" << instance.patientName << "]\n";
+            lastPatient = instance.patientID;
+            lastStudy.clear();
+        }
+        if (instance.studyUID != lastStudy) {
+            out << "  STUDY " << instance.studyUID << " " << instance.studyDate << " " << instance.studyDescription << "\n";
+            lastStudy = instance.studyUID;
+            lastSeries.clear();
+        }
+        if (instance.seriesUID != lastSeries) {
+            out << "    SERIES " << instance.seriesUID << " " << instance.modality << "\n";
+            lastSeries = instance.seriesUID;
+        }
+        out << "      INSTANCE " << instance.sopInstanceUID << " -> " << instance.fileID << "\n";
+        patients.insert(instance.patientID);
+        studies.insert(instance.studyUID);
+        series.insert(instance.seriesUID);
+    }
+    out << "Matches: " << matches << " instances, " << series.size() << " series, " << studies.size()
+        << " studies, " << patients.size() << " patients\n";
+
+    std::cout << "Matched " << matches << " of " << instances.size() << " DICOMDIR records (" << series.size()
+              << " series, " << studies.size() << " studies, " << patients.size() << " patients) without opening referenced files" << std::endl;
+    std::cout << "Lookup report: " << outPath << std::endl;
+}
+
+bool DCMTKTests::TestLosslessJPEGReencode(const std::string& filename, const std::string& outputDir, bool verify) {
     // Round-trip the dataset through JPEG Lossless to validate codec configuration
     std::cout << "--- [DCMTK] JPEG Lossless Re-encode ---" << std::endl;
-    DJDecoderRegistration::registerCodecs();
-    DJEncoderRegistration::registerCodecs();
+    DCMTKCodecRegistry::Instance();
 
     DcmFileFormat fileformat;
     OFCondition status = fileformat.loadFile(filename.c_str());
     if (!status.good()) {
         std::cerr << "Error reading file for JPEG re-encode: " << status.text() << std::endl;
-        DJDecoderRegistration::cleanup();
-        DJEncoderRegistration::cleanup();
-        return;
+        return false;
     }
 
     std::string outFile = JoinPath(outputDir, "dcmtk_jpeg_lossless.dcm");
     status = fileformat.saveFile(outFile.c_str(), EXS_JPEGProcess14SV1);
     if (status.good()) {
         std::cout << "Saved JPEG Lossless file to '" << outFile << "'" << std::endl;
+        return !verify || VerifyLosslessRoundTrip(filename, outFile);
     } else {
         std::cerr << "JPEG re-encode failed: " << status.text() << std::endl;
+        return false;
     }
-
-    DJDecoderRegistration::cleanup();
-    DJEncoderRegistration::cleanup();
 }
 
 void DCMTKTests::TestExplicitVRRewrite(const std::string& filename, const std::string& outputDir) {
@@ -224,6 +662,213 @@ void DCMTKTests::TestExplicitVRRewrite(const std::string& filename, const std::s
     }
 }
 
+namespace {
+// Deflate chunk size; ~128 KiB keeps a dozen threads busy on a single CT slice while the 32 KiB dictionary overlap stays cheap
+constexpr std::size_t kDeflateBlockSize = 128 * 1024;
+
+// Serialize a dataset or meta group through DCMTK's writer into memory, draining the buffer whenever it fills
+bool SerializeObject(DcmObject& object, E_TransferSyntax xfer, std::vector<Uint8>& bytes) {
+    std::vector<Uint8> buffer(1 << 20);
+    DcmOutputBufferStream stream(buffer.data(), static_cast<offile_off_t>(buffer.size()));
+    bytes.clear();
+    object.transferInit();
+    OFCondition status = EC_Normal;
+    do {
+        status = object.write(stream, xfer, EET_UndefinedLength, nullptr);
+        void* chunk = nullptr;
+        offile_off_t length = 0;
+        stream.flushBuffer(chunk, length);
+        const Uint8* begin = static_cast<const Uint8*>(chunk);
+        bytes.insert(bytes.end(), begin, begin + length);
+    } while (status == EC_StreamNotifyClient);
+    object.transferEnd();
+    return status.good();
+}
+
+// Read a Deflated Explicit VR Little Endian Part 10 file without relying on DCMTK's own (optional) zlib support:
+// the meta group stays uncompressed, everything after it is one raw deflate stream of an explicit LE dataset
+bool LoadDeflatedFile(const std::string& path, DcmFileFormat& fileformat, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    std::vector<Uint8> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (bytes.size() < 144 || std::memcmp(bytes.data() + 128, "DICM", 4) != 0) {
+        error = "not a DICOM Part 10 file";
+        return false;
+    }
+    // (0002,0000) UL leads the meta group and tells us where the deflated stream starts
+    const Uint8* groupLength = bytes.data() + 132;
+    if (groupLength[0] != 0x02 || groupLength[1] != 0x00 || groupLength[2] != 0x00 || groupLength[3] != 0x00 ||
+        groupLength[4] != 'U' || groupLength[5] != 'L') {
+        error = "file meta information lacks (0002,0000)";
+        return false;
+    }
+    const std::size_t metaEnd = 144 + (static_cast<std::size_t>(groupLength[8]) | (static_cast<std::size_t>(groupLength[9]) << 8) |
+                                       (static_cast<std::size_t>(groupLength[10]) << 16) | (static_cast<std::size_t>(groupLength[11]) << 24));
+    if (metaEnd > bytes.size()) {
+        error = "file meta group length exceeds file size";
+        return false;
+    }
+
+    DcmMetaInfo* meta = fileformat.getMetaInfo();
+    DcmInputBufferStream metaStream;
+    metaStream.setBuffer(bytes.data(), static_cast<offile_off_t>(metaEnd));
+    metaStream.setEos();
+    meta->transferInit();
+    OFCondition status = meta->read(metaStream, EXS_LittleEndianExplicit);
+    meta->transferEnd();
+    OFString transferSyntax;
+    if (status.bad() || meta->findAndGetOFString(DCM_TransferSyntaxUID, transferSyntax).bad()) {
+        error = std::string("cannot parse file meta information: ") + status.text();
+        return false;
+    }
+    if (transferSyntax != UID_DeflatedExplicitVRLittleEndianTransferSyntax) {
+        error = "transfer syntax is " + std::string(transferSyntax.c_str()) + ", not Deflated Explicit VR Little Endian";
+        return false;
+    }
+
+    std::vector<Uint8> plain;
+    if (!ParallelDeflate::Decompress(bytes.data() + metaEnd, bytes.size() - metaEnd, plain)) {
+        error = "corrupt or truncated deflate stream";
+        return false;
+    }
+    DcmDataset* dataset = fileformat.getDataset();
+    DcmInputBufferStream datasetStream;
+    datasetStream.setBuffer(plain.data(), static_cast<offile_off_t>(plain.size()));
+    datasetStream.setEos();
+    dataset->transferInit();
+    status = dataset->read(datasetStream, EXS_LittleEndianExplicit);
+    dataset->transferEnd();
+    if (status.bad()) {
+        error = std::string("cannot parse inflated dataset: ") + status.text();
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+bool DCMTKTests::TestDeflatedRewrite(const std::string& filename, const std::string& outputDir, int level, unsigned int workers,
+                                     bool compareSerial) {
+    // Write Deflated Explicit VR Little Endian with the dataset compressed block-parallel, then read it back
+    std::cout << "--- [DCMTK] Deflated Explicit VR Little Endian ---" << std::endl;
+    if (!ParallelDeflate::Available()) {
+        std::cerr << "Deflated transfer syntax needs zlib; rebuild with zlib available." << std::endl;
+        return false;
+    }
+    DCMTKCodecRegistry::Instance();
+
+    DcmFileFormat fileformat;
+    OFCondition status = fileformat.loadFile(filename.c_str());
+    if (!status.good()) {
+        std::cerr << "Error reading file for deflated rewrite: " << status.text() << std::endl;
+        return false;
+    }
+
+    // Deflate wraps a native explicit LE dataset, so encapsulated pixel data is decoded first
+    DcmDataset* dataset = fileformat.getDataset();
+    if (dataset->chooseRepresentation(EXS_LittleEndianExplicit, nullptr).bad() ||
+        !dataset->canWriteXfer(EXS_LittleEndianExplicit)) {
+        std::cerr << "Cannot decode pixel data for deflated rewrite." << std::endl;
+        return false;
+    }
+    DcmMetaInfo* meta = fileformat.getMetaInfo();
+    fileformat.validateMetaInfo(EXS_DeflatedLittleEndianExplicit);
+    meta->computeGroupLengthAndPadding(EGL_withGL, EPD_noChange, EXS_LittleEndianExplicit);
+
+    std::vector<Uint8> metaBytes;
+    std::vector<Uint8> datasetBytes;
+    if (!SerializeObject(*meta, EXS_LittleEndianExplicit, metaBytes) ||
+        !SerializeObject(*dataset, EXS_LittleEndianExplicit, datasetBytes)) {
+        std::cerr << "Failed to serialize dataset for deflate." << std::endl;
+        return false;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<std::uint8_t> deflated;
+    const std::size_t blocks = std::max<std::size_t>(1, (datasetBytes.size() + kDeflateBlockSize - 1) / kDeflateBlockSize);
+    const unsigned int threads = ParallelUtils::ResolveWorkerCount(blocks, workers);
+    const auto parallelStart = Clock::now();
+    if (!ParallelDeflate::Compress(datasetBytes.data(), datasetBytes.size(), level, threads, deflated, kDeflateBlockSize)) {
+        std::cerr << "Deflate failed." << std::endl;
+        return false;
+    }
+    const double parallelMs = std::chrono::duration<double, std::milli>(Clock::now() - parallelStart).count();
+    double serialMs = 0.0;
+    if (compareSerial) {
+        // Same blocks on one thread, so the speedup is measured on identical output; costs a second compression
+        std::vector<std::uint8_t> serial;
+        const auto serialStart = Clock::now();
+        ParallelDeflate::Compress(datasetBytes.data(), datasetBytes.size(), level, 1, serial, kDeflateBlockSize);
+        serialMs = std::chrono::duration<double, std::milli>(Clock::now() - serialStart).count();
+    }
+    // PS3.5 A.5: an odd-length deflated stream gets one trailing pad byte
+    if (deflated.size() % 2 != 0) {
+        deflated.push_back(0);
+    }
+
+    std::string outFile = JoinPath(outputDir, "dcmtk_deflated.dcm");
+    std::ofstream out(outFile, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(metaBytes.data()), static_cast<std::streamsize>(metaBytes.size()));
+    out.write(reinterpret_cast<const char*>(deflated.data()), static_cast<std::streamsize>(deflated.size()));
+    out.close();
+    if (!out) {
+        std::cerr << "Failed to write deflated file: " << outFile << std::endl;
+        return false;
+    }
+
+    const double ratio = deflated.empty() ? 0.0 : static_cast<double>(datasetBytes.size()) / static_cast<double>(deflated.size());
+    std::cout << "Saved Deflated Explicit VR Little Endian copy to '" << outFile << "' (level " << level << ", "
+              << datasetBytes.size() << " -> " << deflated.size() << " bytes, " << std::fixed << std::setprecision(2)
+              << ratio << "x)" << std::endl;
+    std::cout << "Deflate: " << threads << " threads " << parallelMs << " ms across " << blocks << " blocks";
+    if (compareSerial) {
+        std::cout << "; 1 thread " << serialMs << " ms (" << (parallelMs > 0.0 ? serialMs / parallelMs : 0.0) << "x)";
+    }
+    std::cout << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+
+    // Read path: inflate and re-serialize; the explicit LE bytes must match what went into the compressor
+    DcmFileFormat reloaded;
+    std::string error;
+    std::vector<Uint8> roundTrip;
+    if (!LoadDeflatedFile(outFile, reloaded, error)) {
+        std::cerr << "Deflated read-back failed: " << error << std::endl;
+        return false;
+    }
+    if (!SerializeObject(*reloaded.getDataset(), EXS_LittleEndianExplicit, roundTrip) || roundTrip != datasetBytes) {
+        std::cerr << "Deflated read-back differs from the source dataset." << std::endl;
+        return false;
+    }
+    std::cout << "Read-back verified: inflated dataset matches the source byte for byte" << std::endl;
+    return true;
+}
+
+void DCMTKTests::TestDeflatedRead(const std::string& filename, const std::string& outputDir) {
+    // Inflate a Deflated Explicit VR Little Endian file and store it as plain Explicit VR Little Endian
+    std::cout << "--- [DCMTK] Inflate Deflated Explicit VR ---" << std::endl;
+    if (!ParallelDeflate::Available()) {
+        std::cerr << "Deflated transfer syntax needs zlib; rebuild with zlib available." << std::endl;
+        return;
+    }
+
+    DcmFileFormat fileformat;
+    std::string error;
+    const auto start = std::chrono::steady_clock::now();
+    if (!LoadDeflatedFile(filename, fileformat, error)) {
+        std::cerr << "Error reading deflated file: " << error << std::endl;
+        return;
+    }
+    const double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::string outFile = JoinPath(outputDir, "dcmtk_inflated.dcm");
+    OFCondition status = fileformat.saveFile(outFile.c_str(), EXS_LittleEndianExplicit);
+    if (status.good()) {
+        std::cout << "Inflated and parsed in " << std::fixed << std::setprecision(2) << loadMs << " ms; saved Explicit VR Little Endian copy to '"
+                  << outFile << "'" << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+    } else {
+        std::cerr << "Explicit VR write after inflate failed: " << status.text() << std::endl;
+    }
+}
+
 void DCMTKTests::TestMetadataReport(const std::string& filename, const std::string& outputDir) {
     // Export common identifying fields and transfer syntax for quick inspection
     std::cout << "--- [DCMTK] Metadata Report ---" << std::endl;
@@ -276,19 +921,16 @@ void DCMTKTests::TestMetadataReport(const std::string& filename, const std::stri
     std::cout << "Wrote metadata summary to '" << outFile << "'" << std::endl;
 }
 
-void DCMTKTests::TestRLEReencode(const std::string& filename, const std::string& outputDir) {
+bool DCMTKTests::TestRLEReencode(const std::string& filename, const std::string& outputDir, bool verify) {
     // Attempt a lossless RLE transcode to exercise encapsulated pixel data handling
     std::cout << "--- [DCMTK] RLE Lossless Transcode ---" << std::endl;
-    DcmRLEDecoderRegistration::registerCodecs();
-    DcmRLEEncoderRegistration::registerCodecs();
+    DCMTKCodecRegistry::Instance();
 
     DcmFileFormat fileformat;
     OFCondition status = fileformat.loadFile(filename.c_str());
     if (!status.good()) {
         std::cerr << "Error reading file for RLE transcode: " << status.text() << std::endl;
-        DcmRLEDecoderRegistration::cleanup();
-        DcmRLEEncoderRegistration::cleanup();
-        return;
+        return false;
     }
 
     const E_TransferSyntax targetXfer = EXS_RLELossless;
@@ -298,29 +940,26 @@ void DCMTKTests::TestRLEReencode(const std::string& filename, const std::string&
         status = fileformat.saveFile(outFile.c_str(), targetXfer);
         if (status.good()) {
             std::cout << "Saved RLE Lossless file to '" << outFile << "'" << std::endl;
+            return !verify || VerifyLosslessRoundTrip(filename, outFile);
         } else {
             std::cerr << "RLE save failed: " << status.text() << std::endl;
+            return false;
         }
     } else {
         std::cerr << "RLE representation not supported for this dataset." << std::endl;
+        return false;
     }
-
-    DcmRLEDecoderRegistration::cleanup();
-    DcmRLEEncoderRegistration::cleanup();
 }
 
 void DCMTKTests::TestJPEGBaseline(const std::string& filename, const std::string& outputDir) {
     // Save a JPEG Baseline (lossy) copy to check encoder/decoder availability
     std::cout << "--- [DCMTK] JPEG Baseline (Process 1) ---" << std::endl;
-    DJDecoderRegistration::registerCodecs();
-    DJEncoderRegistration::registerCodecs();
+    DCMTKCodecRegistry::Instance();
 
     DcmFileFormat fileformat;
     OFCondition status = fileformat.loadFile(filename.c_str());
     if (!status.good()) {
         std::cerr << "Error reading file for JPEG Baseline: " << status.text() << std::endl;
-        DJDecoderRegistration::cleanup();
-        DJEncoderRegistration::cleanup();
         return;
     }
 
@@ -331,9 +970,126 @@ void DCMTKTests::TestJPEGBaseline(const std::string& filename, const std::string
     } else {
         std::cerr << "JPEG Baseline transcode failed: " << status.text() << std::endl;
     }
+}
+
+void DCMTKTests::TestJPEGQualitySweep(const std::string& filename, const std::string& outputDir) {
+    // Encodes lossy JPEG at several qualities in parallel and scores each decode against the source rendering
+    std::cout << "--- [DCMTK] JPEG Quality Sweep ---" << std::endl;
+    DCMTKCodecRegistry::Instance();
+
+    DcmFileFormat probe;
+    if (probe.loadFile(filename.c_str()).bad()) {
+        std::cerr << "Error reading file for JPEG quality sweep." << std::endl;
+        return;
+    }
+    Uint16 bitsStored = 8;
+    probe.getDataset()->findAndGetUint16(DCM_BitsStored, bitsStored);
+    // Baseline only carries 8-bit samples; deeper data goes through the 12-bit extended process
+    const E_TransferSyntax xfer = bitsStored <= 8 ? EXS_JPEGProcess1 : EXS_JPEGProcess2_4;
+
+    // Score in display space: both images go through the source's VOI window and are rendered to 8 bits.
+    // The encoder may rescale >8-bit input, so stored values are not directly comparable.
+    DicomImage reference(filename.c_str());
+    if (reference.getStatus() != EIS_Normal) {
+        std::cerr << "Could not render source image: " << DicomImage::getString(reference.getStatus()) << std::endl;
+        return;
+    }
+    double windowCenter = 0.0;
+    double windowWidth = 0.0;
+    const bool monochrome = reference.isMonochrome() != 0;
+    if (monochrome) {
+        reference.setMinMaxWindow();
+        reference.getWindow(windowCenter, windowWidth);
+    }
+    const unsigned long width = reference.getWidth();
+    const unsigned long height = reference.getHeight();
+    const unsigned long frames = reference.getFrameCount();
+    const unsigned long samples = monochrome ? 1 : 3;
+    const unsigned long planeSize = reference.getOutputDataSize(8);
+    std::vector<std::vector<Uint8>> referencePlanes(frames, std::vector<Uint8>(planeSize));
+    for (unsigned long frame = 0; frame < frames; ++frame) {
+        reference.getOutputData(referencePlanes[frame].data(), planeSize, 8, frame, 1 /*planar*/);
+    }
+
+    const std::vector<int> qualities = {95, 90, 85, 75, 60, 50, 30};
+    struct SweepResult {
+        bool ok{false};
+        std::uintmax_t bytes{0};
+        ImageMetrics::ErrorStats stats;
+    };
+    std::vector<SweepResult> results(qualities.size());
+    fs::path sweepDir = fs::path(outputDir) / "dcmtk_jpeg_sweep";
+    std::error_code ec;
+    fs::create_directories(sweepDir, ec);
+
+    std::mutex logMutex;
+    ParallelUtils::ParallelFor(qualities.size(), 0, [&](unsigned int, size_t i) {
+        // Each worker owns its dataset; DCMTK datasets are not shared across threads
+        DcmFileFormat fileformat;
+        const std::string outFile = (sweepDir / ("q" + std::to_string(qualities[i]) + ".dcm")).string();
+        DJ_RPLossy params(qualities[i]);
+        DcmDataset* dataset = nullptr;
+        OFCondition status = fileformat.loadFile(filename.c_str());
+        if (status.good()) {
+            dataset = fileformat.getDataset();
+            status = dataset->chooseRepresentation(xfer, &params);
+        }
+        if (status.good() && dataset->canWriteXfer(xfer)) {
+            status = fileformat.saveFile(outFile.c_str(), xfer);
+        } else if (status.good()) {
+            status = EC_IllegalCall;
+        }
+        if (status.bad()) {
+            std::lock_guard<std::mutex> lock(logMutex);
+            std::cerr << "  Quality " << qualities[i] << ": encode failed (" << status.text() << ")" << std::endl;
+            return;
+        }
 
-    DJDecoderRegistration::cleanup();
-    DJEncoderRegistration::cleanup();
+        // Decode from disk so the comparison sees the lossy stream, not the cached original representation
+        DicomImage decoded(outFile.c_str());
+        if (decoded.getStatus() != EIS_Normal || decoded.getFrameCount() != frames) {
+            std::lock_guard<std::mutex> lock(logMutex);
+            std::cerr << "  Quality " << qualities[i] << ": decode failed" << std::endl;
+            return;
+        }
+        if (monochrome) {
+            decoded.setWindow(windowCenter, windowWidth);
+        }
+        ImageMetrics::Accumulator accumulator(255.0);
+        std::vector<Uint8> plane(planeSize);
+        for (unsigned long frame = 0; frame < frames; ++frame) {
+            decoded.getOutputData(plane.data(), planeSize, 8, frame, 1 /*planar*/);
+            // Planar output stacks the colour planes, so they are scored as one taller image
+            accumulator.AddPlane(referencePlanes[frame].data(), plane.data(), width, height * samples);
+        }
+        results[i].stats = accumulator.Result();
+        results[i].bytes = fs::file_size(outFile, ec);
+        results[i].ok = true;
+    });
+
+    const double pixels = static_cast<double>(width) * height * frames;
+    std::string csvPath = JoinPath(outputDir, "dcmtk_jpeg_sweep.csv");
+    std::ofstream csv(csvPath);
+    csv << "Codec,Setting,Bytes,BitsPerPixel,PSNR_dB,MaxAbsError,SSIM,Space\n";
+    std::cout << "Transfer syntax: " << DcmXfer(xfer).getXferName() << std::endl;
+    // Format rows in a local stream so the precision/alignment flags do not leak into later std::cout output
+    std::ostringstream table;
+    table << std::left << std::fixed << std::setw(10) << "Quality" << std::setw(12) << "Bytes" << std::setw(8) << "bpp"
+          << std::setw(10) << "PSNR" << std::setw(8) << "MaxErr" << "SSIM" << "\n";
+    for (size_t i = 0; i < qualities.size(); ++i) {
+        if (!results[i].ok) {
+            continue;
+        }
+        const auto& r = results[i];
+        const double bpp = pixels > 0 ? (static_cast<double>(r.bytes) * 8.0) / pixels : 0.0;
+        csv << "JPEG," << qualities[i] << "," << r.bytes << "," << bpp << "," << r.stats.psnr << ","
+            << r.stats.maxAbsError << "," << r.stats.ssim << ",display8\n";
+        table << std::setw(10) << qualities[i] << std::setw(12) << r.bytes << std::setprecision(3) << std::setw(8) << bpp
+              << std::setprecision(2) << std::setw(10) << r.stats.psnr << std::setprecision(0) << std::setw(8)
+              << r.stats.maxAbsError << std::setprecision(4) << r.stats.ssim << "\n";
+    }
+    std::cout << table.str();
+    std::cout << "Rate-distortion table written to " << csvPath << std::endl;
 }
 
 void DCMTKTests::TestBMPPreview(const std::string& filename, const std::string& outputDir) {
@@ -358,49 +1114,253 @@ void DCMTKTests::TestBMPPreview(const std::string& filename, const std::string&
     }
 }
 
-void DCMTKTests::TestRawDump(const std::string& filename, const std::string& outputDir) {
-    // Dump raw pixel buffer bytes for quick regression comparisons
-    std::cout << "--- [DCMTK] Raw Pixel Dump ---" << std::endl;
-    DicomImage image(filename.c_str());
+void DCMTKTests::TestCineExport(const std::string& filename, const std::string& outputDir, CineFormat format, unsigned int frameStep) {
+    // Renders every Nth frame to individual images or one contact sheet; each worker decodes only its own frame range
+    std::cout << "--- [DCMTK] Cine Export ---" << std::endl;
+    DCMTKCodecRegistry::Instance();
+    frameStep = std::max(1u, frameStep);
+
+    DicomImage probe(filename.c_str(), CIF_UsePartialAccessToPixelData, 0, 1);
+    if (probe.getStatus() != EIS_Normal) {
+        std::cerr << "Could not load image for cine export: " << DicomImage::getString(probe.getStatus()) << std::endl;
+        return;
+    }
+    const unsigned long totalFrames = probe.getNumberOfFrames();
+    const bool monochrome = probe.isMonochrome() != 0;
+
+    // One window for the whole clip so the preview does not flicker frame to frame
+    bool useStoredWindow = false;
+    double windowCenter = 0.0;
+    double windowWidth = 0.0;
+    if (monochrome) {
+        if (probe.getWindowCount() > 0) {
+            useStoredWindow = true;
+        } else {
+            probe.setMinMaxWindow();
+            probe.getWindow(windowCenter, windowWidth);
+        }
+    }
+
+    std::vector<unsigned long> frames;
+    for (unsigned long frame = 0; frame < totalFrames; frame += frameStep) {
+        frames.push_back(frame);
+    }
+
+    // Contiguous frames are decoded in small ranges; strided exports load one frame per DicomImage
+    const size_t framesPerJob = frameStep == 1 ? 8 : 1;
+    const size_t jobs = (frames.size() + framesPerJob - 1) / framesPerJob;
+
+#ifndef WITH_LIBPNG
+    if (format == CineFormat::PNG) {
+        std::cout << "DCMTK was built without libpng; writing PGM/PPM frames instead." << std::endl;
+        format = CineFormat::PNM;
+    }
+#endif
+
+    fs::path cineDir = fs::path(outputDir) / "dcmtk_cine";
+    std::error_code ec;
+    if (format != CineFormat::ContactSheet) {
+        fs::create_directories(cineDir, ec);
+        if (ec) {
+            std::cerr << "Failed to create " << cineDir << " (" << ec.message() << ")" << std::endl;
+            return;
+        }
+    }
+
+    // Contact sheet geometry: near-square grid of thumbnails no wider than kTileWidth
+    constexpr unsigned long kTileWidth = 128;
+    const unsigned long tileWidth = std::min(kTileWidth, probe.getWidth());
+    const unsigned long tileHeight = std::max(1UL, probe.getHeight() * tileWidth / std::max(1UL, probe.getWidth()));
+    const unsigned long columns = static_cast<unsigned long>(std::ceil(std::sqrt(static_cast<double>(frames.size()))));
+    const unsigned long rows = columns == 0 ? 0 : (frames.size() + columns - 1) / columns;
+    const unsigned long samples = monochrome ? 1 : 3;
+    std::vector<Uint8> sheet;
+    if (format == CineFormat::ContactSheet) {
+        sheet.assign(columns * tileWidth * rows * tileHeight * samples, 0);
+    }
+
+    std::atomic<size_t> written{0};
+    std::mutex logMutex;
+    ParallelUtils::ParallelFor(jobs, 0, [&](unsigned int, size_t job) {
+        const size_t first = job * framesPerJob;
+        const size_t last = std::min(frames.size(), first + framesPerJob);
+        const unsigned long startFrame = frames[first];
+        const unsigned long frameCount = frames[last - 1] - startFrame + 1;
+
+        auto applyWindow = [&](DicomImage& target) {
+            if (!monochrome) {
+                return;
+            }
+            if (useStoredWindow) {
+                target.setWindow(0);
+            } else {
+                target.setWindow(windowCenter, windowWidth);
+            }
+        };
+
+        DicomImage image(filename.c_str(), CIF_UsePartialAccessToPixelData, startFrame, frameCount);
+        if (image.getStatus() != EIS_Normal) {
+            std::lock_guard<std::mutex> lock(logMutex);
+            std::cerr << "  Could not decode frames " << startFrame << "-" << (startFrame + frameCount - 1) << std::endl;
+            return;
+        }
+        applyWindow(image);
+
+        std::unique_ptr<DicomImage> thumbnails;
+        if (format == CineFormat::ContactSheet) {
+            thumbnails.reset(image.createScaledImage(tileWidth, tileHeight, 1 /*interpolate*/));
+            if (!thumbnails || thumbnails->getStatus() != EIS_Normal) {
+                std::lock_guard<std::mutex> lock(logMutex);
+                std::cerr << "  Could not scale frames starting at " << startFrame << std::endl;
+                return;
+            }
+            // Scaled copies start from the modality-transformed data, so the VOI window is applied again
+            applyWindow(*thumbnails);
+        }
+
+        std::vector<Uint8> tile;
+        for (size_t i = first; i < last; ++i) {
+            const unsigned long local = frames[i] - startFrame;
+            char name[32];
+            std::snprintf(name, sizeof(name), "frame_%05lu", frames[i]);
+            int ok = 0;
+            switch (format) {
+                case CineFormat::PNG: {
+#ifdef WITH_LIBPNG
+                    DiPNGPlugin png;
+                    ok = image.writePluginFormat(&png, (cineDir / (std::string(name) + ".png")).string().c_str(), local);
+#endif
+                    break;
+                }
+                case CineFormat::PNM:
+                    ok = image.writeRawPPM((cineDir / (std::string(name) + (monochrome ? ".pgm" : ".ppm"))).string().c_str(), 8, local);
+                    break;
+                case CineFormat::BMP:
+                    ok = image.writeBMP((cineDir / (std::string(name) + ".bmp")).string().c_str(), 0, local);
+                    break;
+                case CineFormat::ContactSheet: {
+                    const unsigned long size = thumbnails->getOutputDataSize(8);
+                    tile.resize(size);
+                    ok = thumbnails->getOutputData(tile.data(), size, 8, local);
+                    if (ok) {
+                        // Each job owns distinct tiles, so rows can be copied into the shared sheet without locking
+                        const unsigned long row = static_cast<unsigned long>(i) / columns;
+                        const unsigned long col = static_cast<unsigned long>(i) % columns;
+                        const unsigned long stride = columns * tileWidth * samples;
+                        const unsigned long rowBytes = thumbnails->getWidth() * samples;
+                        for (unsigned long y = 0; y < thumbnails->getHeight() && y < tileHeight; ++y) {
+                            std::memcpy(&sheet[(row * tileHeight + y) * stride + col * tileWidth * samples],
+                                        &tile[y * rowBytes], std::min(rowBytes, tileWidth * samples));
+                        }
+                    }
+                    break;
+                }
+            }
+            if (ok) {
+                ++written;
+            } else {
+                std::lock_guard<std::mutex> lock(logMutex);
+                std::cerr << "  Failed to render frame " << frames[i] << std::endl;
+            }
+        }
+    });
+
+    if (format == CineFormat::ContactSheet) {
+        std::string outFile = JoinPath(outputDir, monochrome ? "dcmtk_cine_sheet.pgm" : "dcmtk_cine_sheet.ppm");
+        std::ofstream out(outFile, std::ios::binary | std::ios::out | std::ios::trunc);
+        out << (monochrome ? "P5" : "P6") << "\n" << columns * tileWidth << " " << rows * tileHeight << "\n255\n";
+        out.write(reinterpret_cast<const char*>(sheet.data()), static_cast<std::streamsize>(sheet.size()));
+        if (out.good()) {
+            std::cout << "Wrote " << written << " of " << frames.size() << " frames as a " << columns << "x" << rows
+                      << " contact sheet to " << outFile << std::endl;
+        } else {
+            std::cerr << "Failed writing contact sheet." << std::endl;
+        }
+        return;
+    }
+    std::cout << "Rendered " << written << " of " << frames.size() << " frames (" << totalFrames << " total, step "
+              << frameStep << ") to " << cineDir << std::endl;
+}
+
+void DCMTKTests::TestRawDump(const std::string& filename, const std::string& outputDir, bool nativeDepth) {
+    // Dump raw pixel buffer bytes for quick regression comparisons, one frame at a time through a reused buffer
+    std::cout << "--- [DCMTK] Raw Pixel Dump" << (nativeDepth ? " (native depth)" : "") << " ---" << std::endl;
+    // Partial access decodes only the current chunk of frames; the rest stays on disk until processNextFrames
+    constexpr unsigned long kFramesPerChunk = 8;
+    DicomImage image(filename.c_str(), CIF_UsePartialAccessToPixelData, 0, kFramesPerChunk);
     if (image.getStatus() != EIS_Normal) {
         std::cerr << "Could not load image for raw dump: " << DicomImage::getString(image.getStatus()) << std::endl;
         return;
     }
 
-    const int bits = image.isMonochrome() ? 16 : 24;
-    const unsigned long count = image.getOutputDataSize(bits);
-    if (count == 0) {
+    // 0 asks DCMTK for the stored bit depth instead of stretching samples to 16/24 bits
+    const int bits = nativeDepth ? 0 : (image.isMonochrome() ? 16 : 24);
+    const unsigned long frameSize = image.getOutputDataSize(bits);
+    if (frameSize == 0) {
         std::cerr << "No pixel data available for raw dump." << std::endl;
         return;
     }
 
-    std::vector<char> buffer(count);
-    if (!image.getOutputData(buffer.data(), count, bits)) {
-        std::cerr << "Failed to extract output data buffer." << std::endl;
+    std::string outFile = JoinPath(outputDir, nativeDepth ? "dcmtk_raw_dump_native.bin" : "dcmtk_raw_dump.bin");
+    std::ofstream out(outFile, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Failed to open " << outFile << " for writing." << std::endl;
         return;
     }
 
-    std::string outFile = JoinPath(outputDir, "dcmtk_raw_dump.bin");
-    std::ofstream out(outFile, std::ios::binary | std::ios::out | std::ios::trunc);
-    out.write(buffer.data(), static_cast<std::streamsize>(count));
+    const unsigned long totalFrames = image.getNumberOfFrames();
+    std::vector<char> buffer(frameSize);
+    unsigned long framesWritten = 0;
+    unsigned long long bytesWritten = 0;
+    while (framesWritten < totalFrames) {
+        const unsigned long framesInChunk = image.getFrameCount();
+        for (unsigned long frame = 0; frame < framesInChunk; ++frame) {
+            if (!image.getOutputData(buffer.data(), frameSize, bits, frame)) {
+                std::cerr << "Failed to extract output data for frame " << (framesWritten + frame) << "." << std::endl;
+                return;
+            }
+            out.write(buffer.data(), static_cast<std::streamsize>(frameSize));
+            bytesWritten += frameSize;
+        }
+        framesWritten += framesInChunk;
+        if (framesWritten < totalFrames && !image.processNextFrames(kFramesPerChunk)) {
+            std::cerr << "Failed to decode frames starting at " << framesWritten << "." << std::endl;
+            return;
+        }
+    }
+
     if (out.good()) {
-        std::cout << "Wrote raw buffer (" << count << " bytes) to " << outFile << std::endl;
+        std::cout << "Wrote raw buffer (" << framesWritten << " frames, " << bytesWritten << " bytes, "
+                  << (bits == 0 ? image.getDepth() : bits) << "-bit output) to " << outFile << std::endl;
     } else {
         std::cerr << "Failed writing raw buffer." << std::endl;
     }
 }
 
+void DCMTKTests::TestCodecAvailability(const std::string&, const std::string&) {
+    // Show which transfer syntaxes the process-wide codec registry can decode/encode
+    std::cout << "--- [DCMTK] Codec Availability ---" << std::endl;
+    DCMTKCodecRegistry::Instance().Print(std::cout);
+}
+
 #else
 namespace DCMTKTests {
 void TestTagModification(const std::string&, const std::string&) { std::cout << "DCMTK not enabled." << std::endl; }
 void TestPixelDataExtraction(const std::string&, const std::string&) {}
 void TestDICOMDIRGeneration(const std::string&, const std::string&) {}
-void TestLosslessJPEGReencode(const std::string&, const std::string&) {}
-void TestRawDump(const std::string&, const std::string&) {}
+void TestDICOMDIRUpdate(const std::string&, const std::string&) {}
+void TestDICOMDIRQuery(const std::string&, const std::string&, const std::string&) {}
+bool TestLosslessJPEGReencode(const std::string&, const std::string&, bool) { return false; }
+void TestRawDump(const std::string&, const std::string&, bool) {}
 void TestExplicitVRRewrite(const std::string&, const std::string&) {}
+bool TestDeflatedRewrite(const std::string&, const std::string&, int, unsigned int, bool) { return false; }
+void TestDeflatedRead(const std::string&, const std::string&) {}
 void TestMetadataReport(const std::string&, const std::string&) {}
-void TestRLEReencode(const std::string&, const std::string&) {}
+bool TestRLEReencode(const std::string&, const std::string&, bool) { return false; }
 void TestJPEGBaseline(const std::string&, const std::string&) {}
 void TestBMPPreview(const std::string&, const std::string&) {}
+void TestCodecAvailability(const std::string&, const std::string&) {}
+void TestCineExport(const std::string&, const std::string&, CineFormat, unsigned int) {}
+void TestJPEGQualitySweep(const std::string&, const std::string&) {}
 } // namespace DCMTKTests
 #endif
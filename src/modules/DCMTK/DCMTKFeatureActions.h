@@ -8,18 +8,47 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 
 namespace DCMTKTests {
+    // Output flavours for the cine exporter; PNG falls back to PNM when DCMTK lacks libpng
+    enum class CineFormat { PNG, PNM, BMP, ContactSheet };
+
     // Individual feature demos executed by CLI commands; implementations live in the .cpp file
     void TestPixelDataExtraction(const std::string& filename, const std::string& outputDir);
     void TestDICOMDIRGeneration(const std::string& directory, const std::string& outputDir);
+    void TestDICOMDIRUpdate(const std::string& directory, const std::string& outputDir);
+    void TestDICOMDIRQuery(const std::string& path, const std::string& outputDir, const std::string& query);
     void TestTagModification(const std::string& filename, const std::string& outputDir);
-    void TestLosslessJPEGReencode(const std::string& filename, const std::string& outputDir);
-    void TestRawDump(const std::string& filename, const std::string& outputDir);
+    // Lossless re-encodes return false when the output could not be written or --verify found a pixel difference
+    bool TestLosslessJPEGReencode(const std::string& filename, const std::string& outputDir, bool verify = false);
+    void TestRawDump(const std::string& filename, const std::string& outputDir, bool nativeDepth = false);
     void TestExplicitVRRewrite(const std::string& filename, const std::string& outputDir);
+    // Deflated Explicit VR Little Endian (1.2.840.10008.1.2.1.99); the dataset is deflated block-parallel on `workers`
+    // threads (0 = auto). compareSerial compresses again on one thread to report the speedup. False when the write
+    // or the byte-for-byte read-back fails
+    bool TestDeflatedRewrite(const std::string& filename, const std::string& outputDir, int level = 6,
+                             unsigned int workers = 0, bool compareSerial = false);
+    void TestDeflatedRead(const std::string& filename, const std::string& outputDir);
     void TestMetadataReport(const std::string& filename, const std::string& outputDir);
-    void TestRLEReencode(const std::string& filename, const std::string& outputDir);
+    bool TestRLEReencode(const std::string& filename, const std::string& outputDir, bool verify = false);
     void TestJPEGBaseline(const std::string& filename, const std::string& outputDir);
+    void TestJPEGQualitySweep(const std::string& filename, const std::string& outputDir);
     void TestBMPPreview(const std::string& filename, const std::string& outputDir);
+    void TestCodecAvailability(const std::string& filename, const std::string& outputDir);
+    // Long-running network services (see DCMTKNetworkActions.cpp); return a process exit code.
+    // The servers answer loopback peers only unless allowRemote is set.
+    int RunStoreSCP(const std::string& outputDir, unsigned short port, unsigned int concurrency,
+                    unsigned int durationSeconds, const std::function<void(const std::string&)>& onArrival,
+                    bool allowRemote = false);
+    int RunStoreSCU(const std::string& path, const std::string& outputDir, unsigned short port, unsigned int concurrency);
+    int RunQuerySCP(const std::string& path, const std::string& outputDir, unsigned short port,
+                    unsigned int concurrency, unsigned int durationSeconds, bool allowRemote = false);
+    int RunQueryBenchmark(const std::string& outputDir, unsigned short port, unsigned int concurrency,
+                          unsigned int durationSeconds);
+    // Localhost DICOMweb server (see DCMTKWebActions.cpp)
+    int RunDicomWebServer(const std::string& path, const std::string& outputDir, unsigned short port,
+                          unsigned int concurrency, unsigned int durationSeconds, bool allowRemote = false);
+    void TestCineExport(const std::string& filename, const std::string& outputDir, CineFormat format, unsigned int frameStep = 1);
 }
@@ -0,0 +1,1126 @@
+//
+// DCMTKNetworkActions.cpp
+// DicomToolsCpp
+//
+// Implements local DIMSE services (C-STORE SCP with async writers, a C-STORE SCU load generator, and an
+// index-backed C-FIND/C-GET SCP with its benchmark client) on dcmnet.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#include "DCMTKFeatureActions.h"
+#include "DCMTKCodecRegistry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "utils/FileSystemUtils.h"
+#include "utils/ParallelUtils.h"
+#include "utils/WorkQueue.h"
+
+#ifdef USE_DCMTK
+#include "dcmtk/config/osconfig.h"
+#include "dcmtk/dcmdata/dctk.h"
+#include "dcmtk/dcmdata/dcuid.h"
+#include "dcmtk/dcmnet/dimse.h"
+#include "dcmtk/dcmnet/scppool.h"
+#include "dcmtk/dcmnet/scpthrd.h"
+#include "dcmtk/dcmnet/scu.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr const char* kSCPAETitle = "DICOMTOOLS";
+constexpr const char* kSCUAETitle = "DICOMTOOLS_SCU";
+
+std::atomic<bool> g_stopRequested{false};
+
+void HandleStopSignal(int) {
+    g_stopRequested = true;
+}
+
+// dcmnet always listens on every interface and has no bind address, so the SCPs filter peers at association time.
+// Host lookup is disabled, so the calling address is numeric; "localhost" covers builds that still resolve it.
+bool IsLoopbackPeer(const std::string& address) {
+    return address.rfind("127.", 0) == 0 || address == "::1" || address.rfind("::ffff:127.", 0) == 0 ||
+           address == "localhost";
+}
+
+// Transfer syntaxes the SCP accepts as-is; received instances are written in the syntax they arrived in
+const std::vector<OFString>& AcceptedTransferSyntaxes() {
+    static const std::vector<OFString> syntaxes = {
+        UID_LittleEndianExplicitTransferSyntax,
+        UID_LittleEndianImplicitTransferSyntax,
+        UID_BigEndianExplicitTransferSyntax,
+        UID_DeflatedExplicitVRLittleEndianTransferSyntax,
+        UID_JPEGProcess1TransferSyntax,
+        UID_JPEGProcess2_4TransferSyntax,
+        UID_JPEGProcess14TransferSyntax,
+        UID_JPEGProcess14SV1TransferSyntax,
+        UID_JPEGLSLosslessTransferSyntax,
+        UID_JPEGLSLossyTransferSyntax,
+        UID_JPEG2000LosslessOnlyTransferSyntax,
+        UID_JPEG2000TransferSyntax,
+        UID_RLELosslessTransferSyntax,
+    };
+    return syntaxes;
+}
+
+struct ReceivedInstance {
+    // Dataset handed from an association thread to the writer pool
+    std::unique_ptr<DcmDataset> dataset;
+    std::string path;
+    std::chrono::steady_clock::time_point received;
+};
+
+class StoreSink {
+public:
+    StoreSink(const fs::path& root, unsigned int writers, std::function<void(const std::string&)> onArrival)
+        : root_(root), onArrival_(std::move(onArrival)),
+          // Arrival commands run on one thread: registered commands write fixed file names and are not re-entrant
+          dispatcher_(256, 1, [this](std::string& path) { onArrival_(path); }),
+          writer_(1024, writers, [this](ReceivedInstance& instance) { Write(instance); }) {}
+
+    ~StoreSink() {
+        writer_.Close();
+        dispatcher_.Close();
+    }
+
+    // Called from association threads; blocks only when the writer backlog is full
+    void Submit(DcmDataset* dataset) {
+        OFString studyUID;
+        OFString sopUID;
+        dataset->findAndGetOFString(DCM_StudyInstanceUID, studyUID);
+        dataset->findAndGetOFString(DCM_SOPInstanceUID, sopUID);
+        // UIDs come from the peer and become path components, so anything outside the UID alphabet is replaced
+        const std::string study = studyUID.c_str();
+        const std::string sop = sopUID.c_str();
+        ReceivedInstance instance;
+        instance.dataset.reset(dataset);
+        instance.path = (root_ / (FileSystemUtils::IsPathSafeUID(study) ? study : "unknown-study") /
+                         ((FileSystemUtils::IsPathSafeUID(sop) ? sop : "instance-" + std::to_string(++anonymous_)) +
+                          ".dcm")).string();
+        instance.received = std::chrono::steady_clock::now();
+        ++received_;
+        writer_.Push(std::move(instance));
+    }
+
+    void Close() {
+        writer_.Close();
+        dispatcher_.Close();
+    }
+
+    size_t Received() const { return received_; }
+    size_t Written() const { return written_; }
+    size_t Failed() const { return failed_; }
+    double MeanWriteLatencyMs() const {
+        return written_ > 0 ? static_cast<double>(writeLatencyUs_) / 1000.0 / static_cast<double>(written_) : 0.0;
+    }
+
+private:
+    void Write(ReceivedInstance& instance) {
+        std::error_code ec;
+        fs::create_directories(fs::path(instance.path).parent_path(), ec);
+        const E_TransferSyntax xfer = instance.dataset->getOriginalXfer();
+        // DcmFileFormat copies the dataset and builds the meta header from it; the copy happens off the network thread
+        DcmFileFormat fileformat(instance.dataset.get());
+        instance.dataset.reset();
+        OFCondition status = fileformat.saveFile(instance.path.c_str(), xfer);
+        if (status.bad()) {
+            ++failed_;
+            std::lock_guard<std::mutex> lock(logMutex_);
+            std::cerr << "  Failed to write " << instance.path << ": " << status.text() << std::endl;
+            return;
+        }
+        ++written_;
+        writeLatencyUs_ += static_cast<size_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - instance.received).count());
+        if (onArrival_) {
+            dispatcher_.Push(instance.path);
+        }
+    }
+
+    fs::path root_;
+    std::function<void(const std::string&)> onArrival_;
+    std::atomic<size_t> anonymous_{0};
+    std::atomic<size_t> received_{0};
+    std::atomic<size_t> written_{0};
+    std::atomic<size_t> failed_{0};
+    std::atomic<size_t> writeLatencyUs_{0};
+    std::mutex logMutex_;
+    // Declared last so worker threads start after the counters exist; writer_ is torn down before dispatcher_
+    WorkQueue<std::string> dispatcher_;
+    WorkQueue<ReceivedInstance> writer_;
+};
+
+// DcmSCPPool default-constructs its workers, so the active sink and peer policy are published through globals
+std::atomic<StoreSink*> g_activeSink{nullptr};
+std::atomic<bool> g_allowRemotePeers{false};
+
+class StoreWorker : public DcmThreadSCP {
+protected:
+    OFBool checkCallingHostAccepted(const OFString& hostOrIP) override {
+        return g_allowRemotePeers || IsLoopbackPeer(hostOrIP.c_str()) ? OFTrue : OFFalse;
+    }
+
+    OFCondition handleIncomingCommand(T_DIMSE_Message* incomingMsg, const DcmPresentationContextInfo& presInfo) override {
+        if (incomingMsg->CommandField != DIMSE_C_STORE_RQ) {
+            // C-ECHO and anything else fall through to the stock handling
+            return DcmThreadSCP::handleIncomingCommand(incomingMsg, presInfo);
+        }
+        T_DIMSE_C_StoreRQ& request = incomingMsg->msg.CStoreRQ;
+        DcmDataset* dataset = nullptr;
+        OFCondition status = receiveSTORERequest(request, presInfo.presentationContextID, dataset);
+        Uint16 response = STATUS_Success;
+        StoreSink* sink = g_activeSink.load();
+        if (status.good() && dataset != nullptr && sink != nullptr) {
+            sink->Submit(dataset);
+        } else {
+            delete dataset;
+            response = STATUS_STORE_Refused_OutOfResources;
+        }
+        if (status.bad()) {
+            return status;
+        }
+        return sendSTOREResponse(presInfo.presentationContextID, request, response);
+    }
+};
+
+struct StoreJob {
+    // File to replay and the presentation context it needs
+    std::string path;
+    std::string sopClassUID;
+    std::string transferSyntaxUID;
+};
+
+double Percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5));
+    return sorted[index];
+}
+
+struct IndexedInstance {
+    // One row of the series index (same columns gdcm:scan writes)
+    std::string file;
+    std::string patientName;
+    std::string patientID;
+    std::string studyUID;
+    std::string seriesUID;
+    std::string sopInstanceUID;
+    std::string modality;
+};
+
+class QueryIndex {
+public:
+    // Prefer the gdcm:scan CSV so queries reflect the project's index; otherwise read headers in parallel. The CSV
+    // left in the output folder is only trusted when it indexes the directory passed as --input.
+    bool Load(const std::string& inputPath, const std::string& outputDir) {
+        const bool explicitCSV = fs::path(inputPath).extension() == ".csv";
+        fs::path csv = explicitCSV ? fs::path(inputPath) : fs::path(outputDir) / "gdcm_series_index.csv";
+        if (fs::is_regular_file(csv) && LoadCSV(csv) && !explicitCSV && !IndexesRoot(inputPath)) {
+            std::cout << "Ignoring " << csv.string() << ": it indexes files outside " << inputPath << std::endl;
+            instances_.clear();
+        }
+        if (!instances_.empty()) {
+            source_ = csv.string();
+        } else if (ScanHeaders(inputPath)) {
+            source_ = "header scan of " + inputPath;
+        } else {
+            return false;
+        }
+        BuildLevels();
+        return !instances_.empty();
+    }
+
+    const std::string& Source() const { return source_; }
+    const std::vector<IndexedInstance>& Instances() const { return instances_; }
+    size_t StudyCount() const { return studies_.size(); }
+    size_t SeriesCount() const { return series_.size(); }
+
+    // Matches at PATIENT/STUDY/SERIES level; each returned index is a representative instance of a distinct entity
+    std::vector<size_t> Find(const std::string& level, DcmDataset* keys) const {
+        std::vector<size_t> matches;
+        std::set<std::string> seen;
+        for (size_t i = 0; i < instances_.size(); ++i) {
+            const IndexedInstance& instance = instances_[i];
+            if (!Matches(keys, instance, level)) {
+                continue;
+            }
+            const std::string& entity = level == "PATIENT" ? instance.patientID
+                                      : level == "STUDY" ? instance.studyUID : instance.seriesUID;
+            if (seen.insert(entity).second) {
+                matches.push_back(i);
+            }
+        }
+        return matches;
+    }
+
+    // Every instance under the matched entities, for C-GET at STUDY/SERIES/IMAGE level
+    std::vector<size_t> Retrieve(const std::string& level, DcmDataset* keys) const {
+        std::vector<size_t> matches;
+        for (size_t i = 0; i < instances_.size(); ++i) {
+            if (Matches(keys, instances_[i], level)) {
+                matches.push_back(i);
+            }
+        }
+        return matches;
+    }
+
+    // Fill the response identifier with the return keys the requester asked for
+    DcmDataset* BuildResponse(const std::string& level, DcmDataset* keys, const IndexedInstance& instance) const {
+        auto* response = new DcmDataset();
+        response->putAndInsertString(DCM_QueryRetrieveLevel, level.c_str());
+        auto put = [&](const DcmTagKey& tag, const std::string& value) {
+            if (keys->tagExists(tag)) {
+                response->putAndInsertString(tag, value.c_str());
+            }
+        };
+        put(DCM_SpecificCharacterSet, "ISO_IR 100");
+        put(DCM_RetrieveAETitle, kSCPAETitle);
+        put(DCM_PatientName, instance.patientName);
+        put(DCM_PatientID, instance.patientID);
+        if (level == "PATIENT") {
+            put(DCM_NumberOfPatientRelatedStudies, std::to_string(patients_.at(instance.patientID).studies.size()));
+            return response;
+        }
+        const StudyInfo& study = studies_.at(instance.studyUID);
+        put(DCM_StudyInstanceUID, instance.studyUID);
+        if (level == "STUDY") {
+            std::string modalities;
+            for (const auto& modality : study.modalities) {
+                modalities += (modalities.empty() ? "" : "\\") + modality;
+            }
+            put(DCM_ModalitiesInStudy, modalities);
+            put(DCM_NumberOfStudyRelatedSeries, std::to_string(study.series.size()));
+            put(DCM_NumberOfStudyRelatedInstances, std::to_string(study.instances));
+            return response;
+        }
+        put(DCM_SeriesInstanceUID, instance.seriesUID);
+        put(DCM_Modality, instance.modality);
+        put(DCM_NumberOfSeriesRelatedInstances, std::to_string(series_.at(instance.seriesUID)));
+        return response;
+    }
+
+private:
+    struct PatientInfo {
+        std::set<std::string> studies;
+    };
+    struct StudyInfo {
+        std::set<std::string> series;
+        std::set<std::string> modalities;
+        size_t instances{0};
+    };
+
+    static std::string Trim(const std::string& value) {
+        // GDCM returns values with their even-length padding (space or NUL)
+        const size_t end = value.find_last_not_of(std::string(" \0\r", 3));
+        return end == std::string::npos ? std::string() : value.substr(0, end + 1);
+    }
+
+    // Splits one CSV row keeping empty fields (a trailing empty Modality included); double-quoted fields may hold
+    // commas and "" for a literal quote
+    static std::vector<std::string> SplitCSVRow(const std::string& line) {
+        std::vector<std::string> fields(1);
+        bool quoted = false;
+        for (size_t i = 0; i < line.size(); ++i) {
+            const char c = line[i];
+            if (quoted) {
+                if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                    fields.back() += '"';
+                    ++i;
+                } else if (c == '"') {
+                    quoted = false;
+                } else {
+                    fields.back() += c;
+                }
+            } else if (c == '"') {
+                quoted = true;
+            } else if (c == ',') {
+                fields.emplace_back();
+            } else if (c != '\r') {
+                fields.back() += c;
+            }
+        }
+        return fields;
+    }
+
+    // True when every indexed file lies under the --input directory (or the directory of an --input file)
+    bool IndexesRoot(const std::string& inputPath) const {
+        std::error_code ec;
+        const fs::path root = fs::weakly_canonical(
+            fs::is_directory(inputPath) ? fs::path(inputPath) : fs::path(inputPath).parent_path(), ec);
+        if (ec || root.empty()) {
+            return false;
+        }
+        return std::all_of(instances_.begin(), instances_.end(), [&](const IndexedInstance& instance) {
+            std::error_code fileError;
+            const fs::path file = fs::weakly_canonical(instance.file, fileError);
+            const fs::path relative = file.lexically_relative(root);
+            return !fileError && !relative.empty() && *relative.begin() != "..";
+        });
+    }
+
+    bool LoadCSV(const fs::path& csv) {
+        std::ifstream in(csv);
+        std::string line;
+        if (!std::getline(in, line)) {
+            return false;
+        }
+        while (std::getline(in, line)) {
+            const std::vector<std::string> fields = SplitCSVRow(line);
+            if (fields.size() < 7) {
+                continue;
+            }
+            // gdcm:scan writes PatientName unquoted, so a comma inside it spreads the name over extra fields
+            const size_t last = fields.size() - 1;
+            std::string name = fields[1];
+            for (size_t i = 2; i + 4 < last; ++i) {
+                name += "," + fields[i];
+            }
+            instances_.push_back({fields[0], Trim(name), Trim(fields[last - 4]), Trim(fields[last - 3]),
+                                  Trim(fields[last - 2]), Trim(fields[last - 1]), Trim(fields[last])});
+        }
+        return !instances_.empty();
+    }
+
+    bool ScanHeaders(const std::string& inputPath) {
+        fs::path root = fs::is_directory(inputPath) ? fs::path(inputPath) : fs::path(inputPath).parent_path();
+        if (root.empty() || !fs::exists(root)) {
+            return false;
+        }
+        for (const auto& entry : fs::recursive_directory_iterator(root)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".dcm") {
+                IndexedInstance instance;
+                instance.file = entry.path().string();
+                instances_.push_back(std::move(instance));
+            }
+        }
+        ParallelUtils::ParallelFor(instances_.size(), 0, [&](unsigned int, size_t i) {
+            DcmFileFormat header;
+            if (header.loadFileUntilTag(OFFilename(instances_[i].file.c_str()), EXS_Unknown, EGL_noChange,
+                                        DCM_MaxReadLength, ERM_autoDetect, DCM_PixelData).bad()) {
+                return;
+            }
+            DcmDataset* dataset = header.getDataset();
+            auto fetch = [&](const DcmTagKey& tag, std::string& target) {
+                OFString value;
+                if (dataset->findAndGetOFStringArray(tag, value).good()) {
+                    target = value.c_str();
+                }
+            };
+            fetch(DCM_PatientName, instances_[i].patientName);
+            fetch(DCM_PatientID, instances_[i].patientID);
+            fetch(DCM_StudyInstanceUID, instances_[i].studyUID);
+            fetch(DCM_SeriesInstanceUID, instances_[i].seriesUID);
+            fetch(DCM_SOPInstanceUID, instances_[i].sopInstanceUID);
+            fetch(DCM_Modality, instances_[i].modality);
+        });
+        instances_.erase(std::remove_if(instances_.begin(), instances_.end(), [](const IndexedInstance& instance) {
+            return instance.sopInstanceUID.empty();
+        }), instances_.end());
+        return !instances_.empty();
+    }
+
+    void BuildLevels() {
+        for (const auto& instance : instances_) {
+            patients_[instance.patientID].studies.insert(instance.studyUID);
+            StudyInfo& study = studies_[instance.studyUID];
+            study.series.insert(instance.seriesUID);
+            if (!instance.modality.empty()) {
+                study.modalities.insert(instance.modality);
+            }
+            ++study.instances;
+            ++series_[instance.seriesUID];
+        }
+    }
+
+    // DICOM wildcard matching for PN/LO/CS keys: '*' any run, '?' one character
+    static bool Wildcard(const char* pattern, const char* value) {
+        if (*pattern == '\0') {
+            return *value == '\0';
+        }
+        if (*pattern == '*') {
+            return Wildcard(pattern + 1, value) || (*value != '\0' && Wildcard(pattern, value + 1));
+        }
+        return *value != '\0' && (*pattern == '?' || *pattern == *value) && Wildcard(pattern + 1, value + 1);
+    }
+
+    // A valueList key is a backslash-separated list (UID lists, ModalitiesInStudy) that matches when any element does
+    static bool MatchKey(DcmDataset* keys, const DcmTagKey& tag, const std::string& value, bool valueList) {
+        OFString key;
+        if (keys->findAndGetOFStringArray(tag, key).bad() || key.empty()) {
+            return true; // absent or universal
+        }
+        if (valueList) {
+            std::stringstream list(key.c_str());
+            std::string element;
+            while (std::getline(list, element, '\\')) {
+                if (Wildcard(element.c_str(), value.c_str())) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        return Wildcard(key.c_str(), value.c_str());
+    }
+
+    static bool Matches(DcmDataset* keys, const IndexedInstance& instance, const std::string& level) {
+        if (!MatchKey(keys, DCM_PatientID, instance.patientID, false) ||
+            !MatchKey(keys, DCM_PatientName, instance.patientName, false)) {
+            return false;
+        }
+        if (level == "PATIENT") {
+            return true;
+        }
+        if (!MatchKey(keys, DCM_StudyInstanceUID, instance.studyUID, true)) {
+            return false;
+        }
+        if (level == "STUDY") {
+            // A study matches CT\PT when any of its instances is CT or PT
+            return MatchKey(keys, DCM_ModalitiesInStudy, instance.modality, true);
+        }
+        if (!MatchKey(keys, DCM_SeriesInstanceUID, instance.seriesUID, true) ||
+            !MatchKey(keys, DCM_Modality, instance.modality, false)) {
+            return false;
+        }
+        return level == "SERIES" || MatchKey(keys, DCM_SOPInstanceUID, instance.sopInstanceUID, true);
+    }
+
+    std::vector<IndexedInstance> instances_;
+    std::map<std::string, PatientInfo> patients_;
+    std::map<std::string, StudyInfo> studies_;
+    std::map<std::string, size_t> series_;
+    std::string source_;
+};
+
+std::string RequestedLevel(DcmDataset* keys) {
+    OFString level;
+    keys->findAndGetOFString(DCM_QueryRetrieveLevel, level);
+    return level.c_str();
+}
+
+struct FindState {
+    // Per-request cursor used by DIMSE_findProvider's callback
+    const QueryIndex* index{nullptr};
+    std::string level;
+    std::vector<size_t> matches;
+    size_t next{0};
+};
+
+void FindCallback(void* callbackData, OFBool cancelled, T_DIMSE_C_FindRQ*, DcmDataset* requestIdentifiers,
+                  int responseCount, T_DIMSE_C_FindRSP* response, DcmDataset** responseIdentifiers, DcmDataset**) {
+    auto* state = static_cast<FindState*>(callbackData);
+    *responseIdentifiers = nullptr;
+    if (responseCount == 1) {
+        state->level = RequestedLevel(requestIdentifiers);
+        if (state->level != "PATIENT" && state->level != "STUDY" && state->level != "SERIES") {
+            response->DimseStatus = STATUS_FIND_Failed_IdentifierDoesNotMatchSOPClass;
+            return;
+        }
+        // Answered entirely from memory; no image file is opened for C-FIND
+        state->matches = state->index->Find(state->level, requestIdentifiers);
+    }
+    if (cancelled) {
+        response->DimseStatus = STATUS_FIND_Cancel_MatchingTerminatedDueToCancelRequest;
+        return;
+    }
+    if (state->next >= state->matches.size()) {
+        response->DimseStatus = STATUS_Success;
+        return;
+    }
+    const IndexedInstance& instance = state->index->Instances()[state->matches[state->next++]];
+    *responseIdentifiers = state->index->BuildResponse(state->level, requestIdentifiers, instance);
+    response->DimseStatus = STATUS_Pending;
+}
+
+struct GetState {
+    // Per-request sub-operation bookkeeping for DIMSE_getProvider's callback
+    const QueryIndex* index{nullptr};
+    T_ASC_Association* assoc{nullptr};
+    std::vector<size_t> matches;
+    size_t next{0};
+    Uint16 completed{0};
+    Uint16 failed{0};
+    Uint16 warning{0};
+};
+
+bool SendSubOperation(T_ASC_Association* assoc, const std::string& file) {
+    DcmFileFormat meta;
+    if (meta.loadFile(file.c_str(), EXS_Unknown, EGL_noChange, DCM_MaxReadLength, ERM_metaOnly).bad()) {
+        return false;
+    }
+    OFString sopClass;
+    OFString sopInstance;
+    OFString xfer;
+    meta.getMetaInfo()->findAndGetOFString(DCM_MediaStorageSOPClassUID, sopClass);
+    meta.getMetaInfo()->findAndGetOFString(DCM_MediaStorageSOPInstanceUID, sopInstance);
+    meta.getMetaInfo()->findAndGetOFString(DCM_TransferSyntaxUID, xfer);
+
+    T_DIMSE_C_StoreRQ request;
+    std::memset(&request, 0, sizeof(request));
+    request.MessageID = assoc->nextMsgID++;
+    OFStandard::strlcpy(request.AffectedSOPClassUID, sopClass.c_str(), sizeof(request.AffectedSOPClassUID));
+    OFStandard::strlcpy(request.AffectedSOPInstanceUID, sopInstance.c_str(), sizeof(request.AffectedSOPInstanceUID));
+    request.DataSetType = DIMSE_DATASET_PRESENT;
+    request.Priority = DIMSE_PRIORITY_MEDIUM;
+
+    T_DIMSE_C_StoreRSP response;
+    DcmDataset* statusDetail = nullptr;
+    OFCondition status;
+    // Same syntax on the wire as on disk: DIMSE streams the file body without building a DcmDataset
+    T_ASC_PresentationContextID presID = ASC_findAcceptedPresentationContextID(assoc, sopClass.c_str(), xfer.c_str());
+    if (presID != 0) {
+        status = DIMSE_storeUser(assoc, presID, &request, file.c_str(), nullptr, nullptr, nullptr,
+                                 DIMSE_BLOCKING, 0, &response, &statusDetail);
+    } else {
+        // The requester negotiated another syntax for this class; transcode in memory
+        presID = ASC_findAcceptedPresentationContextID(assoc, sopClass.c_str());
+        T_ASC_PresentationContext context;
+        if (presID == 0 || ASC_findAcceptedPresentationContext(assoc->params, presID, &context).bad()) {
+            return false;
+        }
+        DCMTKCodecRegistry::Instance();
+        DcmFileFormat fileformat;
+        const E_TransferSyntax target = DcmXfer(context.acceptedTransferSyntax).getXfer();
+        if (fileformat.loadFile(file.c_str()).bad() ||
+            fileformat.getDataset()->chooseRepresentation(target, nullptr).bad()) {
+            return false;
+        }
+        status = DIMSE_storeUser(assoc, presID, &request, nullptr, fileformat.getDataset(), nullptr, nullptr,
+                                 DIMSE_BLOCKING, 0, &response, &statusDetail);
+    }
+    delete statusDetail;
+    return status.good() && response.DimseStatus == STATUS_Success;
+}
+
+void GetCallback(void* callbackData, OFBool cancelled, T_DIMSE_C_GetRQ*, DcmDataset* requestIdentifiers,
+                 int responseCount, T_DIMSE_C_GetRSP* response, DcmDataset**, DcmDataset** responseIdentifiers) {
+    auto* state = static_cast<GetState*>(callbackData);
+    *responseIdentifiers = nullptr;
+    if (responseCount == 1) {
+        const std::string level = RequestedLevel(requestIdentifiers);
+        if (level != "PATIENT" && level != "STUDY" && level != "SERIES" && level != "IMAGE") {
+            response->DimseStatus = STATUS_GET_Failed_IdentifierDoesNotMatchSOPClass;
+            return;
+        }
+        state->matches = state->index->Retrieve(level, requestIdentifiers);
+    }
+
+    const size_t remaining = state->matches.size() - state->next;
+    if (cancelled && remaining > 0) {
+        response->DimseStatus = STATUS_GET_Cancel_SubOperationsTerminatedDueToCancelIndication;
+    } else if (remaining > 0) {
+        // One C-STORE sub-operation per callback so pending responses report progress
+        const IndexedInstance& instance = state->index->Instances()[state->matches[state->next++]];
+        if (SendSubOperation(state->assoc, instance.file)) {
+            ++state->completed;
+        } else {
+            ++state->failed;
+        }
+        response->DimseStatus = state->next < state->matches.size() ? STATUS_Pending
+                              : (state->failed > 0 ? STATUS_GET_Warning_SubOperationsCompleteOneOrMoreFailures : STATUS_Success);
+    } else {
+        response->DimseStatus = state->failed > 0 ? STATUS_GET_Warning_SubOperationsCompleteOneOrMoreFailures : STATUS_Success;
+    }
+    response->NumberOfRemainingSubOperations = static_cast<Uint16>(state->matches.size() - state->next);
+    response->NumberOfCompletedSubOperations = state->completed;
+    response->NumberOfFailedSubOperations = state->failed;
+    response->NumberOfWarningSubOperations = state->warning;
+}
+
+void ServeQueryAssociation(T_ASC_Association* assoc, const QueryIndex& index) {
+    // DIMSE loop for one association; returns on release, abort, or network error
+    for (;;) {
+        T_ASC_PresentationContextID presID = 0;
+        T_DIMSE_Message message;
+        OFCondition status = DIMSE_receiveCommand(assoc, DIMSE_BLOCKING, 0, &presID, &message, nullptr);
+        if (status == DUL_PEERREQUESTEDRELEASE) {
+            ASC_acknowledgeRelease(assoc);
+            break;
+        }
+        if (status.bad()) {
+            ASC_abortAssociation(assoc);
+            break;
+        }
+        if (message.CommandField == DIMSE_C_ECHO_RQ) {
+            status = DIMSE_sendEchoResponse(assoc, presID, &message.msg.CEchoRQ, STATUS_Success, nullptr);
+        } else if (message.CommandField == DIMSE_C_FIND_RQ) {
+            FindState state;
+            state.index = &index;
+            status = DIMSE_findProvider(assoc, presID, &message.msg.CFindRQ, FindCallback, &state, DIMSE_BLOCKING, 0);
+        } else if (message.CommandField == DIMSE_C_GET_RQ) {
+            GetState state;
+            state.index = &index;
+            state.assoc = assoc;
+            status = DIMSE_getProvider(assoc, presID, &message.msg.CGetRQ, GetCallback, &state, DIMSE_BLOCKING, 0);
+        } else {
+            status = DIMSE_BADCOMMANDTYPE;
+        }
+        if (status.bad()) {
+            ASC_abortAssociation(assoc);
+            break;
+        }
+    }
+    ASC_dropSCPAssociation(assoc);
+    ASC_destroyAssociation(&assoc);
+}
+}
+
+int DCMTKTests::RunStoreSCP(const std::string& outputDir, unsigned short port, unsigned int concurrency,
+                            unsigned int durationSeconds, const std::function<void(const std::string&)>& onArrival,
+                            bool allowRemote) {
+    std::cout << "--- [DCMTK] C-STORE SCP ---" << std::endl;
+    const unsigned int associations = concurrency == 0 ? ParallelUtils::ResolveWorkerCount(64) : concurrency;
+    fs::path storeRoot = fs::path(outputDir) / "store_scp";
+
+    StoreSink sink(storeRoot, std::max(2u, ParallelUtils::ResolveWorkerCount(8)), onArrival);
+    g_activeSink = &sink;
+    g_allowRemotePeers = allowRemote;
+
+    DcmSCPPool<StoreWorker> pool;
+    DcmSCPConfig& config = pool.getConfig();
+    config.setAETitle(kSCPAETitle);
+    config.setPort(port);
+    config.setHostLookupEnabled(OFFalse);
+    // Non-blocking accept with a short timeout lets the pool notice shutdown requests
+    config.setConnectionBlockingMode(DUL_NOBLOCK);
+    config.setConnectionTimeout(1);
+
+    OFList<OFString> syntaxes;
+    for (const auto& uid : AcceptedTransferSyntaxes()) {
+        syntaxes.push_back(uid);
+    }
+    config.addPresentationContext(UID_VerificationSOPClass, syntaxes);
+    for (int i = 0; i < numberOfDcmAllStorageSOPClassUIDs; ++i) {
+        config.addPresentationContext(dcmAllStorageSOPClassUIDs[i], syntaxes);
+    }
+    pool.setMaxThreads(static_cast<Uint16>(std::min(associations, 65535u)));
+
+    g_stopRequested = false;
+    auto previousHandler = std::signal(SIGINT, HandleStopSignal);
+    std::atomic<bool> listening{true};
+    std::thread stopper([&] {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(durationSeconds);
+        while (listening) {
+            if (g_stopRequested || (durationSeconds > 0 && std::chrono::steady_clock::now() >= deadline)) {
+                pool.stopAfterCurrentAssociations();
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    });
+
+    std::cout << "Listening as " << kSCPAETitle << " on port " << port << " (" << associations
+              << " concurrent associations, " << (durationSeconds > 0 ? std::to_string(durationSeconds) + " s" : "until Ctrl-C")
+              << ", " << (allowRemote ? "any host" : "loopback peers only") << "); writing to " << storeRoot << std::endl;
+    const auto start = std::chrono::steady_clock::now();
+    OFCondition status = pool.listen();
+    listening = false;
+    stopper.join();
+    std::signal(SIGINT, previousHandler);
+
+    // Drain the writer backlog before reporting so counts reflect what is on disk
+    sink.Close();
+    g_activeSink = nullptr;
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Received " << sink.Received() << " instances, wrote " << sink.Written() << " (" << sink.Failed()
+              << " failed) in " << std::fixed << std::setprecision(1) << seconds << " s; mean receive-to-disk "
+              << std::setprecision(2) << sink.MeanWriteLatencyMs() << " ms" << std::defaultfloat << std::endl;
+    if (status.bad() && !g_stopRequested && durationSeconds == 0) {
+        std::cerr << "SCP stopped: " << status.text() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int DCMTKTests::RunStoreSCU(const std::string& path, const std::string& outputDir, unsigned short port, unsigned int concurrency) {
+    std::cout << "--- [DCMTK] C-STORE SCU Load Generator ---" << std::endl;
+    fs::path root = fs::is_directory(path) ? fs::path(path) : fs::path(path).parent_path();
+    std::vector<StoreJob> jobs;
+    for (const auto& entry : fs::recursive_directory_iterator(root)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".dcm") {
+            jobs.push_back({entry.path().string(), "", ""});
+        }
+    }
+    if (jobs.empty()) {
+        std::cerr << "No DICOM files found under " << root << " to send." << std::endl;
+        return 1;
+    }
+
+    // Only the meta header is needed to pick a presentation context
+    ParallelUtils::ParallelFor(jobs.size(), 0, [&](unsigned int, size_t i) {
+        DcmFileFormat meta;
+        if (meta.loadFile(jobs[i].path.c_str(), EXS_Unknown, EGL_noChange, DCM_MaxReadLength, ERM_metaOnly).good()) {
+            OFString value;
+            if (meta.getMetaInfo()->findAndGetOFString(DCM_MediaStorageSOPClassUID, value).good()) jobs[i].sopClassUID = value.c_str();
+            if (meta.getMetaInfo()->findAndGetOFString(DCM_TransferSyntaxUID, value).good()) jobs[i].transferSyntaxUID = value.c_str();
+        }
+    });
+    jobs.erase(std::remove_if(jobs.begin(), jobs.end(), [](const StoreJob& job) {
+        return job.sopClassUID.empty() || job.transferSyntaxUID.empty();
+    }), jobs.end());
+
+    // One presentation context per SOP class/transfer syntax pair; uncompressed files may also go as LE
+    std::map<std::string, std::set<std::string>> contexts;
+    for (const auto& job : jobs) {
+        contexts[job.sopClassUID].insert(job.transferSyntaxUID);
+    }
+
+    const unsigned int associations = ParallelUtils::ResolveWorkerCount(jobs.size(), concurrency == 0 ? 4 : concurrency);
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> failures{0};
+    std::vector<std::vector<double>> latencies(associations);
+    std::mutex logMutex;
+    const auto start = std::chrono::steady_clock::now();
+    ParallelUtils::ParallelFor(associations, associations, [&](unsigned int, size_t worker) {
+        DcmSCU scu;
+        scu.setAETitle(kSCUAETitle);
+        scu.setPeerAETitle(kSCPAETitle);
+        scu.setPeerHostName("127.0.0.1");
+        scu.setPeerPort(port);
+        size_t proposed = 0;
+        for (const auto& [sopClass, syntaxes] : contexts) {
+            for (const auto& syntax : syntaxes) {
+                OFList<OFString> list;
+                list.push_back(syntax.c_str());
+                if (syntax != UID_LittleEndianExplicitTransferSyntax && syntax != UID_LittleEndianImplicitTransferSyntax &&
+                    DcmXfer(syntax.c_str()).isNotEncapsulated()) {
+                    list.push_back(UID_LittleEndianExplicitTransferSyntax);
+                }
+                // DICOM caps an association at 128 presentation contexts
+                if (++proposed <= 128) {
+                    scu.addPresentationContext(sopClass.c_str(), list);
+                }
+            }
+        }
+        if (scu.initNetwork().bad() || scu.negotiateAssociation().bad()) {
+            std::lock_guard<std::mutex> lock(logMutex);
+            std::cerr << "  Association " << worker << " could not be established with 127.0.0.1:" << port << std::endl;
+            return;
+        }
+        for (size_t i = next.fetch_add(1); i < jobs.size(); i = next.fetch_add(1)) {
+            const StoreJob& job = jobs[i];
+            T_ASC_PresentationContextID context = scu.findAnyPresentationContextID(job.sopClassUID.c_str(), job.transferSyntaxUID.c_str());
+            Uint16 response = 0;
+            const auto sendStart = std::chrono::steady_clock::now();
+            OFCondition status = context == 0 ? EC_IllegalCall
+                                               : scu.sendSTORERequest(context, job.path.c_str(), nullptr, response);
+            latencies[worker].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sendStart).count());
+            if (status.bad() || response != STATUS_Success) {
+                ++failures;
+            }
+        }
+        scu.releaseAssociation();
+    });
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    for (auto& perWorker : latencies) {
+        all.insert(all.end(), perWorker.begin(), perWorker.end());
+    }
+    std::sort(all.begin(), all.end());
+    const size_t sent = all.size();
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(2);
+    report << "Sent " << sent << " of " << jobs.size() << " instances over " << associations << " associations in "
+           << seconds << " s (" << (seconds > 0 ? static_cast<double>(sent - failures) / seconds : 0.0) << " instances/s, "
+           << failures << " failed)\n";
+    report << "Latency ms: p50 " << Percentile(all, 0.50) << ", p90 " << Percentile(all, 0.90) << ", p99 "
+           << Percentile(all, 0.99) << ", max " << (all.empty() ? 0.0 : all.back()) << "\n";
+    std::cout << report.str();
+
+    std::string reportPath = (fs::path(outputDir) / "store_scu_report.txt").string();
+    std::ofstream out(reportPath);
+    out << report.str();
+    std::cout << "Load report: " << reportPath << std::endl;
+    return failures == 0 && sent == jobs.size() ? 0 : 1;
+}
+
+int DCMTKTests::RunQuerySCP(const std::string& path, const std::string& outputDir, unsigned short port,
+                            unsigned int concurrency, unsigned int durationSeconds, bool allowRemote) {
+    std::cout << "--- [DCMTK] Query/Retrieve SCP ---" << std::endl;
+    QueryIndex index;
+    if (!index.Load(path, outputDir)) {
+        std::cerr << "No instances to serve: run gdcm:scan first or point --input at a DICOM directory." << std::endl;
+        return 1;
+    }
+    std::cout << "Serving " << index.Instances().size() << " instances in " << index.StudyCount() << " studies / "
+              << index.SeriesCount() << " series from " << index.Source() << std::endl;
+
+    // dcmnet's DIMSE providers need the raw association to issue C-GET sub-operations, so this uses the ASC layer directly
+    T_ASC_Network* network = nullptr;
+    dcmDisableGethostbyaddr.set(OFTrue);
+    OFCondition status = ASC_initializeNetwork(NET_ACCEPTOR, port, 30, &network);
+    if (status.bad()) {
+        std::cerr << "Cannot listen on port " << port << ": " << status.text() << std::endl;
+        return 1;
+    }
+
+    const char* queryModels[] = {
+        UID_VerificationSOPClass,
+        UID_FINDStudyRootQueryRetrieveInformationModel,
+        UID_FINDPatientRootQueryRetrieveInformationModel,
+        UID_GETStudyRootQueryRetrieveInformationModel,
+        UID_GETPatientRootQueryRetrieveInformationModel,
+    };
+    std::vector<const char*> syntaxes;
+    for (const auto& uid : AcceptedTransferSyntaxes()) {
+        syntaxes.push_back(uid.c_str());
+    }
+
+    const unsigned int associations = concurrency == 0 ? ParallelUtils::ResolveWorkerCount(64) : concurrency;
+    std::atomic<size_t> served{0};
+    {
+        // Capacity equals the worker count, so accepting blocks once every session thread is busy
+        WorkQueue<T_ASC_Association*> sessions(associations, associations, [&](T_ASC_Association*& assoc) {
+            ServeQueryAssociation(assoc, index);
+            ++served;
+        });
+
+        g_stopRequested = false;
+        auto previousHandler = std::signal(SIGINT, HandleStopSignal);
+        std::cout << "Listening as " << kSCPAETitle << " on port " << port << " (" << associations
+                  << " concurrent associations, " << (durationSeconds > 0 ? std::to_string(durationSeconds) + " s" : "until Ctrl-C")
+                  << ", " << (allowRemote ? "any host" : "loopback peers only") << ")" << std::endl;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(durationSeconds);
+        while (!g_stopRequested && (durationSeconds == 0 || std::chrono::steady_clock::now() < deadline)) {
+            T_ASC_Association* assoc = nullptr;
+            // One-second non-blocking accept so Ctrl-C and --duration are noticed promptly
+            status = ASC_receiveAssociation(network, &assoc, ASC_DEFAULTMAXPDU, nullptr, nullptr, OFFalse, DUL_NOBLOCK, 1);
+            if (status.bad()) {
+                if (assoc != nullptr) {
+                    ASC_dropAssociation(assoc);
+                    ASC_destroyAssociation(&assoc);
+                }
+                continue;
+            }
+            if (!allowRemote && !IsLoopbackPeer(assoc->params->DULparams.callingPresentationAddress)) {
+                // The index names every patient and study, so other hosts are turned away unless --allow-remote
+                T_ASC_RejectParameters reject = {ASC_RESULT_REJECTEDPERMANENT, ASC_SOURCE_SERVICEUSER,
+                                                 ASC_REASON_SU_NOREASON};
+                ASC_rejectAssociation(assoc, &reject);
+                ASC_dropAssociation(assoc);
+                ASC_destroyAssociation(&assoc);
+                continue;
+            }
+            ASC_acceptContextsWithPreferredTransferSyntaxes(assoc->params, queryModels,
+                                                            static_cast<int>(sizeof(queryModels) / sizeof(queryModels[0])),
+                                                            syntaxes.data(), static_cast<int>(syntaxes.size()));
+            // Storage contexts carry the C-GET sub-operations; the requester proposes them with the SCP role
+            ASC_acceptContextsWithPreferredTransferSyntaxes(assoc->params, dcmAllStorageSOPClassUIDs, numberOfDcmAllStorageSOPClassUIDs,
+                                                            syntaxes.data(), static_cast<int>(syntaxes.size()), ASC_SC_ROLE_SCUSCP);
+            if (ASC_acknowledgeAssociation(assoc).bad()) {
+                ASC_dropSCPAssociation(assoc);
+                ASC_destroyAssociation(&assoc);
+                continue;
+            }
+            sessions.Push(assoc);
+        }
+        std::signal(SIGINT, previousHandler);
+        // Leaving the scope drains the queue: open associations finish before the network is dropped
+    }
+    ASC_dropNetwork(&network);
+    std::cout << "Served " << served << " associations." << std::endl;
+    return 0;
+}
+
+int DCMTKTests::RunQueryBenchmark(const std::string& outputDir, unsigned short port, unsigned int concurrency,
+                                  unsigned int durationSeconds) {
+    std::cout << "--- [DCMTK] Query/Retrieve Benchmark ---" << std::endl;
+    auto connect = [&](DcmSCU& scu, bool withStorage) {
+        scu.setAETitle(kSCUAETitle);
+        scu.setPeerAETitle(kSCPAETitle);
+        scu.setPeerHostName("127.0.0.1");
+        scu.setPeerPort(port);
+        OFList<OFString> syntaxes;
+        syntaxes.push_back(UID_LittleEndianExplicitTransferSyntax);
+        syntaxes.push_back(UID_LittleEndianImplicitTransferSyntax);
+        scu.addPresentationContext(UID_FINDStudyRootQueryRetrieveInformationModel, syntaxes);
+        scu.addPresentationContext(UID_GETStudyRootQueryRetrieveInformationModel, syntaxes);
+        if (withStorage) {
+            // Offer every syntax the SCP can send so sub-operations go out without transcoding
+            OFList<OFString> storageSyntaxes;
+            for (const auto& uid : AcceptedTransferSyntaxes()) {
+                storageSyntaxes.push_back(uid);
+            }
+            for (int i = 0; i < numberOfDcmLongSCUStorageSOPClassUIDs; ++i) {
+                scu.addPresentationContext(dcmLongSCUStorageSOPClassUIDs[i], storageSyntaxes, ASC_SC_ROLE_SCP);
+            }
+            // Received instances are counted but not kept: the benchmark measures the SCP, not local disk
+            scu.setStorageMode(DCMSCU_STORAGE_IGNORE);
+        }
+        return scu.initNetwork().good() && scu.negotiateAssociation().good();
+    };
+    auto seriesQuery = [](DcmDataset& keys, const std::string& studyUID) {
+        keys.putAndInsertString(DCM_QueryRetrieveLevel, "SERIES");
+        keys.putAndInsertString(DCM_StudyInstanceUID, studyUID.c_str());
+        keys.putAndInsertString(DCM_SeriesInstanceUID, "");
+        keys.putAndInsertString(DCM_Modality, "");
+        keys.putAndInsertString(DCM_NumberOfSeriesRelatedInstances, "");
+    };
+
+    // Universal study-level query to discover what the SCP serves
+    std::vector<std::string> studies;
+    {
+        DcmSCU scu;
+        if (!connect(scu, false)) {
+            std::cerr << "Could not associate with " << kSCPAETitle << " at 127.0.0.1:" << port
+                      << " (start dcmtk:qr-scp first)." << std::endl;
+            return 1;
+        }
+        DcmDataset keys;
+        keys.putAndInsertString(DCM_QueryRetrieveLevel, "STUDY");
+        keys.putAndInsertString(DCM_StudyInstanceUID, "");
+        keys.putAndInsertString(DCM_NumberOfStudyRelatedInstances, "");
+        OFList<QRResponse*> responses;
+        scu.sendFINDRequest(scu.findPresentationContextID(UID_FINDStudyRootQueryRetrieveInformationModel, ""), &keys, &responses);
+        for (QRResponse* response : responses) {
+            OFString uid;
+            if (response->m_dataset != nullptr && response->m_dataset->findAndGetOFString(DCM_StudyInstanceUID, uid).good()) {
+                studies.push_back(uid.c_str());
+            }
+            delete response;
+        }
+        scu.releaseAssociation();
+    }
+    if (studies.empty()) {
+        std::cerr << "The SCP returned no studies." << std::endl;
+        return 1;
+    }
+
+    const unsigned int associations = concurrency == 0 ? 4 : concurrency;
+    const auto findBudget = std::chrono::seconds(durationSeconds > 0 ? durationSeconds : 5);
+
+    // Phase 1: series-level C-FIND round robin over the studies on every association until the budget runs out
+    std::vector<std::vector<double>> findLatencies(associations);
+    std::vector<std::set<std::string>> seriesSeen(associations);
+    std::atomic<size_t> findFailures{0};
+    const auto findStart = std::chrono::steady_clock::now();
+    ParallelUtils::ParallelFor(associations, associations, [&](unsigned int, size_t worker) {
+        DcmSCU scu;
+        if (!connect(scu, false)) {
+            ++findFailures;
+            return;
+        }
+        const T_ASC_PresentationContextID presID = scu.findPresentationContextID(UID_FINDStudyRootQueryRetrieveInformationModel, "");
+        for (size_t i = worker; std::chrono::steady_clock::now() - findStart < findBudget; i += associations) {
+            DcmDataset keys;
+            seriesQuery(keys, studies[i % studies.size()]);
+            OFList<QRResponse*> responses;
+            const auto sendStart = std::chrono::steady_clock::now();
+            OFCondition status = scu.sendFINDRequest(presID, &keys, &responses);
+            findLatencies[worker].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sendStart).count());
+            if (status.bad()) {
+                ++findFailures;
+            }
+            for (QRResponse* response : responses) {
+                OFString uid;
+                if (response->m_dataset != nullptr && response->m_dataset->findAndGetOFString(DCM_SeriesInstanceUID, uid).good()) {
+                    seriesSeen[worker].insert(uid.c_str());
+                }
+                delete response;
+            }
+        }
+        scu.releaseAssociation();
+    });
+    const double findSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - findStart).count();
+
+    // Phase 2: retrieve every discovered series once, spread over the same number of associations
+    std::set<std::string> seriesSet;
+    for (const auto& seen : seriesSeen) {
+        seriesSet.insert(seen.begin(), seen.end());
+    }
+    const std::vector<std::string> series(seriesSet.begin(), seriesSet.end());
+    const unsigned int getAssociations = ParallelUtils::ResolveWorkerCount(series.size(), associations);
+    std::vector<std::vector<double>> getLatencies(getAssociations);
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> instances{0};
+    std::atomic<size_t> getFailures{0};
+    const auto getStart = std::chrono::steady_clock::now();
+    ParallelUtils::ParallelFor(series.empty() ? 0 : getAssociations, getAssociations, [&](unsigned int, size_t worker) {
+        DcmSCU scu;
+        if (!connect(scu, true)) {
+            ++getFailures;
+            return;
+        }
+        const T_ASC_PresentationContextID presID = scu.findPresentationContextID(UID_GETStudyRootQueryRetrieveInformationModel, "");
+        for (size_t i = next.fetch_add(1); i < series.size(); i = next.fetch_add(1)) {
+            DcmDataset keys;
+            keys.putAndInsertString(DCM_QueryRetrieveLevel, "SERIES");
+            keys.putAndInsertString(DCM_SeriesInstanceUID, series[i].c_str());
+            OFList<RetrieveResponse*> responses;
+            const auto sendStart = std::chrono::steady_clock::now();
+            OFCondition status = scu.sendCGETRequest(presID, &keys, &responses);
+            getLatencies[worker].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sendStart).count());
+            if (status.bad() || responses.empty()) {
+                ++getFailures;
+            } else {
+                // The final response carries the sub-operation totals
+                instances += responses.back()->m_numberOfCompletedSubops;
+                getFailures += responses.back()->m_numberOfFailedSubops;
+            }
+            for (RetrieveResponse* response : responses) {
+                delete response;
+            }
+        }
+        scu.releaseAssociation();
+    });
+    const double getSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - getStart).count();
+
+    auto flatten = [](std::vector<std::vector<double>>& perWorker) {
+        std::vector<double> all;
+        for (auto& values : perWorker) {
+            all.insert(all.end(), values.begin(), values.end());
+        }
+        std::sort(all.begin(), all.end());
+        return all;
+    };
+    const std::vector<double> finds = flatten(findLatencies);
+    const std::vector<double> gets = flatten(getLatencies);
+
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(2);
+    report << "C-FIND (SERIES level): " << finds.size() << " queries over " << associations << " associations in "
+           << findSeconds << " s (" << (findSeconds > 0 ? static_cast<double>(finds.size()) / findSeconds : 0.0)
+           << " queries/s, " << findFailures << " failed)\n";
+    report << "C-FIND latency ms: p50 " << Percentile(finds, 0.50) << ", p90 " << Percentile(finds, 0.90) << ", p99 "
+           << Percentile(finds, 0.99) << ", max " << (finds.empty() ? 0.0 : finds.back()) << "\n";
+    report << "C-GET (SERIES level): " << series.size() << " series, " << instances << " instances over "
+           << getAssociations << " associations in " << getSeconds << " s ("
+           << (getSeconds > 0 ? static_cast<double>(instances) / getSeconds : 0.0) << " instances/s, "
+           << getFailures << " failed)\n";
+    report << "C-GET latency ms per series: p50 " << Percentile(gets, 0.50) << ", p90 " << Percentile(gets, 0.90)
+           << ", p99 " << Percentile(gets, 0.99) << ", max " << (gets.empty() ? 0.0 : gets.back()) << "\n";
+    std::cout << report.str();
+
+    std::string reportPath = (fs::path(outputDir) / "qr_bench_report.txt").string();
+    std::ofstream out(reportPath);
+    out << report.str();
+    std::cout << "Benchmark report: " << reportPath << std::endl;
+    return findFailures == 0 && getFailures == 0 ? 0 : 1;
+}
+
+#else
+namespace DCMTKTests {
+int RunStoreSCP(const std::string&, unsigned short, unsigned int, unsigned int, const std::function<void(const std::string&)>&,
+                bool) { return 1; }
+int RunStoreSCU(const std::string&, const std::string&, unsigned short, unsigned int) { return 1; }
+int RunQuerySCP(const std::string&, const std::string&, unsigned short, unsigned int, unsigned int, bool) { return 1; }
+int RunQueryBenchmark(const std::string&, unsigned short, unsigned int, unsigned int) { return 1; }
+} // namespace DCMTKTests
+#endif
@@ -11,6 +11,9 @@
 #include "DCMTKFeatureActions.h"
 #include "cli/CommandRegistry.h"
 
+#include <filesystem>
+#include <iostream>
+
 #ifdef USE_DCMTK
 
 void DCMTKTests::RegisterCommands(CommandRegistry& registry) {
@@ -22,15 +25,19 @@ void DCMTKTests::RegisterCommands(CommandRegistry& registry) {
         [](const CommandContext& ctx) {
             TestTagModification(ctx.inputPath, ctx.outputDir);
             TestPixelDataExtraction(ctx.inputPath, ctx.outputDir);
-            TestLosslessJPEGReencode(ctx.inputPath, ctx.outputDir);
+            bool reencoded = TestLosslessJPEGReencode(ctx.inputPath, ctx.outputDir, ctx.verify);
             TestJPEGBaseline(ctx.inputPath, ctx.outputDir);
-            TestRLEReencode(ctx.inputPath, ctx.outputDir);
+            reencoded = TestRLEReencode(ctx.inputPath, ctx.outputDir, ctx.verify) && reencoded;
             TestRawDump(ctx.inputPath, ctx.outputDir);
             TestExplicitVRRewrite(ctx.inputPath, ctx.outputDir);
+            TestDeflatedRewrite(ctx.inputPath, ctx.outputDir, ctx.deflateLevel, ctx.threads, ctx.verbose);
             TestMetadataReport(ctx.inputPath, ctx.outputDir);
             TestBMPPreview(ctx.inputPath, ctx.outputDir);
+            TestCineExport(ctx.inputPath, ctx.outputDir, CineFormat::ContactSheet, ctx.frameStep);
             TestDICOMDIRGeneration(ctx.inputPath, ctx.outputDir);
-            return 0;
+            TestDICOMDIRQuery(ctx.inputPath, ctx.outputDir, ctx.query);
+            // Without --verify the suite stays best-effort; with it a failed round-trip fails the run
+            return ctx.verify && !reencoded ? 1 : 0;
         }
     });
 
@@ -59,8 +66,7 @@ void DCMTKTests::RegisterCommands(CommandRegistry& registry) {
         "DCMTK",
         "Re-encode to JPEG Lossless to validate JPEG codec support",
         [](const CommandContext& ctx) {
-            TestLosslessJPEGReencode(ctx.inputPath, ctx.outputDir);
-            return 0;
+            return TestLosslessJPEGReencode(ctx.inputPath, ctx.outputDir, ctx.verify) ? 0 : 1;
         }
     });
 
@@ -74,12 +80,51 @@ void DCMTKTests::RegisterCommands(CommandRegistry& registry) {
         }
     });
 
+    registry.Register({
+        "dcmtk:jpeg-sweep",
+        "DCMTK",
+        "Encode JPEG at several qualities and tabulate PSNR/MaxErr/SSIM vs size",
+        [](const CommandContext& ctx) {
+            TestJPEGQualitySweep(ctx.inputPath, ctx.outputDir);
+            return 0;
+        }
+    });
+
     registry.Register({
         "dcmtk:rle",
         "DCMTK",
         "Re-encode to RLE Lossless",
         [](const CommandContext& ctx) {
-            TestRLEReencode(ctx.inputPath, ctx.outputDir);
+            return TestRLEReencode(ctx.inputPath, ctx.outputDir, ctx.verify) ? 0 : 1;
+        }
+    });
+
+    registry.Register({
+        "dcmtk:cine",
+        "DCMTK",
+        "Render every frame (or every --frame-step) to PNG, or PGM/PPM without libpng",
+        [](const CommandContext& ctx) {
+            TestCineExport(ctx.inputPath, ctx.outputDir, CineFormat::PNG, ctx.frameStep);
+            return 0;
+        }
+    });
+
+    registry.Register({
+        "dcmtk:cine-bmp",
+        "DCMTK",
+        "Render every frame (or every --frame-step) to BMP",
+        [](const CommandContext& ctx) {
+            TestCineExport(ctx.inputPath, ctx.outputDir, CineFormat::BMP, ctx.frameStep);
+            return 0;
+        }
+    });
+
+    registry.Register({
+        "dcmtk:cine-sheet",
+        "DCMTK",
+        "Tile frame thumbnails into a single contact-sheet image",
+        [](const CommandContext& ctx) {
+            TestCineExport(ctx.inputPath, ctx.outputDir, CineFormat::ContactSheet, ctx.frameStep);
             return 0;
         }
     });
@@ -94,6 +139,16 @@ void DCMTKTests::RegisterCommands(CommandRegistry& registry) {
         }
     });
 
+    registry.Register({
+        "dcmtk:raw-dump-native",
+        "DCMTK",
+        "Stream raw pixels frame by frame at the stored bit depth",
+        [](const CommandContext& ctx) {
+            TestRawDump(ctx.inputPath, ctx.outputDir, true);
+            return 0;
+        }
+    });
+
     registry.Register({
         "dcmtk:explicit-vr",
         "DCMTK",
@@ -104,6 +159,27 @@ void DCMTKTests::RegisterCommands(CommandRegistry& registry) {
         }
     });
 
+    registry.Register({
+        "dcmtk:deflate",
+        "DCMTK",
+        "Write Deflated Explicit VR LE with multi-threaded deflate (--deflate-level, --threads) and verify read-back",
+        [](const CommandContext& ctx) {
+            const bool verified = TestDeflatedRewrite(ctx.inputPath, ctx.outputDir, ctx.deflateLevel, ctx.threads,
+                                                      ctx.verbose);
+            return verified ? 0 : 1;
+        }
+    });
+
+    registry.Register({
+        "dcmtk:inflate",
+        "DCMTK",
+        "Read a Deflated Explicit VR Little Endian file and save it as Explicit VR Little Endian",
+        [](const CommandContext& ctx) {
+            TestDeflatedRead(ctx.inputPath, ctx.outputDir);
+            return 0;
+        }
+    });
+
     registry.Register({
         "dcmtk:metadata",
         "DCMTK",
@@ -124,6 +200,16 @@ void DCMTKTests::RegisterCommands(CommandRegistry& registry) {
         }
     });
 
+    registry.Register({
+        "dcmtk:codecs",
+        "DCMTK",
+        "List transfer syntaxes covered by the process-wide codec registry",
+        [](const CommandContext& ctx) {
+            TestCodecAvailability(ctx.inputPath, ctx.outputDir);
+            return 0;
+        }
+    });
+
     registry.Register({
         "dcmtk:dicomdir",
         "DCMTK",
@@ -133,6 +219,88 @@ void DCMTKTests::RegisterCommands(CommandRegistry& registry) {
             return 0;
         }
     });
+
+    registry.Register({
+        "dcmtk:store-scp",
+        "DCMTK",
+        "Receive C-STORE on localhost with concurrent associations and async writers (--port, --on-arrival)",
+        [&registry](const CommandContext& ctx) {
+            std::function<void(const std::string&)> onArrival;
+            if (!ctx.onArrival.empty()) {
+                if (!registry.Exists(ctx.onArrival)) {
+                    std::cerr << "Unknown --on-arrival command: " << ctx.onArrival << std::endl;
+                    return 1;
+                }
+                // Each arrival gets its own output folder so commands with fixed file names do not collide
+                onArrival = [&registry, ctx](const std::string& file) {
+                    CommandContext arrival = ctx;
+                    arrival.inputPath = file;
+                    arrival.outputDir = (std::filesystem::path(ctx.outputDir) / "arrivals" / std::filesystem::path(file).stem()).string();
+                    std::error_code ec;
+                    std::filesystem::create_directories(arrival.outputDir, ec);
+                    registry.Run(ctx.onArrival, arrival);
+                };
+            }
+            return RunStoreSCP(ctx.outputDir, ctx.port, ctx.concurrency, ctx.duration, onArrival, ctx.allowRemote);
+        }
+    });
+
+    registry.Register({
+        "dcmtk:store-scu",
+        "DCMTK",
+        "Replay the input directory to a local C-STORE SCP and report instances/s and latency percentiles",
+        [](const CommandContext& ctx) {
+            return RunStoreSCU(ctx.inputPath, ctx.outputDir, ctx.port, ctx.concurrency);
+        }
+    });
+
+    registry.Register({
+        "dcmtk:qr-scp",
+        "DCMTK",
+        "Serve C-FIND/C-GET on localhost from the gdcm:scan series index (--port, --concurrency, --duration)",
+        [](const CommandContext& ctx) {
+            return RunQuerySCP(ctx.inputPath, ctx.outputDir, ctx.port, ctx.concurrency, ctx.duration, ctx.allowRemote);
+        }
+    });
+
+    registry.Register({
+        "dcmtk:qr-bench",
+        "DCMTK",
+        "Benchmark a local Query/Retrieve SCP: C-FIND queries/s and latency, C-GET instances/s",
+        [](const CommandContext& ctx) {
+            return RunQueryBenchmark(ctx.outputDir, ctx.port, ctx.concurrency, ctx.duration);
+        }
+    });
+
+    registry.Register({
+        "serve:dicomweb",
+        "DCMTK",
+        "Serve WADO-RS metadata/frames/thumbnails and accept STOW-RS on localhost (--port, --concurrency, --duration)",
+        [](const CommandContext& ctx) {
+            return RunDicomWebServer(ctx.inputPath, ctx.outputDir, ctx.port, ctx.concurrency, ctx.duration,
+                                     ctx.allowRemote);
+        }
+    });
+
+    registry.Register({
+        "dcmtk:dicomdir-update",
+        "DCMTK",
+        "Append only new instances to an existing DICOMDIR",
+        [](const CommandContext& ctx) {
+            TestDICOMDIRUpdate(ctx.inputPath, ctx.outputDir);
+            return 0;
+        }
+    });
+
+    registry.Register({
+        "dcmtk:dicomdir-query",
+        "DCMTK",
+        "Look up patients/studies/series/instances from DICOMDIR records (--query)",
+        [](const CommandContext& ctx) {
+            TestDICOMDIRQuery(ctx.inputPath, ctx.outputDir, ctx.query);
+            return 0;
+        }
+    });
 }
 
 #else
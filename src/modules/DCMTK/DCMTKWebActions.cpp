@@ -0,0 +1,1319 @@
+//
+// DCMTKWebActions.cpp
+// DicomToolsCpp
+//
+// Implements a localhost DICOMweb server: WADO-RS metadata, frames served from mmap without transcoding,
+// rendered thumbnails, and STOW-RS uploads.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#include "DCMTKFeatureActions.h"
+#include "DCMTKCodecRegistry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/FileSystemUtils.h"
+#include "utils/ParallelUtils.h"
+#include "utils/WorkQueue.h"
+
+#if defined(USE_DCMTK) && !defined(_WIN32)
+#include "dcmtk/config/osconfig.h"
+#include "dcmtk/dcmdata/dctk.h"
+#include "dcmtk/dcmdata/dcjson.h"
+#include "dcmtk/dcmimgle/dcmimage.h"
+#include "dcmtk/dcmimage/diregist.h"
+#include "dcmtk/dcmjpeg/dipijpeg.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr uint32_t kUndefinedLength = 0xFFFFFFFF;
+constexpr size_t kMaxRequestBody = size_t(1) << 30;
+constexpr unsigned long kThumbnailWidth = 128;
+
+std::atomic<bool> g_stopRequested{false};
+
+void HandleStopSignal(int) {
+    g_stopRequested = true;
+}
+
+// ---------------------------------------------------------------------------
+// Pixel Data layout: located by walking the mapped file, so frames are served without a DCMTK parse
+// ---------------------------------------------------------------------------
+
+struct ByteSpan {
+    // Byte range inside the mapping
+    size_t offset{0};
+    size_t length{0};
+};
+
+struct ElementHeader {
+    uint16_t group{0};
+    uint16_t element{0};
+    char vr[2]{};
+    uint32_t length{0};
+    size_t valueOffset{0};
+};
+
+inline uint16_t ReadU16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline uint32_t ReadU32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline uint64_t ReadU64(const uint8_t* p) {
+    return static_cast<uint64_t>(ReadU32(p)) | (static_cast<uint64_t>(ReadU32(p + 4)) << 32);
+}
+
+bool HasLongLength(const char* vr) {
+    static const char* const kLongVRs[] = {"OB", "OD", "OF", "OL", "OV", "OW", "SQ", "SV", "UC", "UN", "UR", "UT", "UV"};
+    for (const char* candidate : kLongVRs) {
+        if (vr[0] == candidate[0] && vr[1] == candidate[1]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ReadHeader(const uint8_t* data, size_t size, size_t pos, bool explicitVR, ElementHeader& header) {
+    if (pos + 8 > size) {
+        return false;
+    }
+    header.group = ReadU16(data + pos);
+    header.element = ReadU16(data + pos + 2);
+    // Item and delimiter tags never carry a VR
+    if (header.group == 0xFFFE || !explicitVR) {
+        header.vr[0] = header.vr[1] = '\0';
+        header.length = ReadU32(data + pos + 4);
+        header.valueOffset = pos + 8;
+        return true;
+    }
+    header.vr[0] = static_cast<char>(data[pos + 4]);
+    header.vr[1] = static_cast<char>(data[pos + 5]);
+    if (HasLongLength(header.vr)) {
+        if (pos + 12 > size) {
+            return false;
+        }
+        header.length = ReadU32(data + pos + 8);
+        header.valueOffset = pos + 12;
+    } else {
+        header.length = ReadU16(data + pos + 6);
+        header.valueOffset = pos + 8;
+    }
+    return true;
+}
+
+bool SkipSequence(const uint8_t* data, size_t size, size_t& pos, bool explicitVR, int depth);
+
+// Walks elements up to `end`, or up to an item delimiter when `inItem` is set
+bool SkipElements(const uint8_t* data, size_t size, size_t& pos, size_t end, bool explicitVR, int depth, bool inItem) {
+    while (pos < end) {
+        ElementHeader header;
+        if (!ReadHeader(data, size, pos, explicitVR, header)) {
+            return false;
+        }
+        if (inItem && header.group == 0xFFFE && header.element == 0xE00D) {
+            pos = header.valueOffset;
+            return true;
+        }
+        pos = header.valueOffset;
+        if (header.length == kUndefinedLength) {
+            // Undefined-length UN holds implicit VR content
+            const bool nestedExplicit = explicitVR && !(header.vr[0] == 'U' && header.vr[1] == 'N');
+            if (!SkipSequence(data, size, pos, nestedExplicit, depth + 1)) {
+                return false;
+            }
+        } else if (header.length > size - pos) {
+            return false;
+        } else {
+            pos += header.length;
+        }
+    }
+    return !inItem;
+}
+
+bool SkipSequence(const uint8_t* data, size_t size, size_t& pos, bool explicitVR, int depth) {
+    if (depth > 64) {
+        return false;
+    }
+    for (;;) {
+        ElementHeader header;
+        if (!ReadHeader(data, size, pos, false, header) || header.group != 0xFFFE) {
+            return false;
+        }
+        pos = header.valueOffset;
+        if (header.element == 0xE0DD) {
+            return true;
+        }
+        if (header.element != 0xE000) {
+            return false;
+        }
+        if (header.length == kUndefinedLength) {
+            if (!SkipElements(data, size, pos, size, explicitVR, depth + 1, true)) {
+                return false;
+            }
+        } else if (header.length > size - pos) {
+            return false;
+        } else {
+            pos += header.length;
+        }
+    }
+}
+
+struct FrameGeometry {
+    // Attributes needed to slice native Pixel Data and to sanity-check encapsulated frame counts
+    unsigned long frames{1};
+    unsigned long rows{0};
+    unsigned long columns{0};
+    unsigned long samplesPerPixel{1};
+    unsigned long bitsAllocated{16};
+};
+
+struct Fragment {
+    size_t itemOffset{0}; // relative to the first fragment item, as offset tables count
+    ByteSpan value;
+};
+
+bool StartsNewCodestream(const uint8_t* data, const ByteSpan& value) {
+    // JPEG/JPEG-LS SOI or JPEG 2000 SOC marker
+    return value.length >= 2 && data[value.offset] == 0xFF && (data[value.offset + 1] == 0xD8 || data[value.offset + 1] == 0x4F);
+}
+
+// Maps each frame to its fragments: Extended Offset Table, then Basic Offset Table, then the usual defaults
+bool BuildEncapsulatedFrames(const uint8_t* data, size_t size, size_t pos, const FrameGeometry& geometry,
+                             const ByteSpan& extendedOffsets, std::vector<std::vector<ByteSpan>>& frames) {
+    ElementHeader header;
+    if (!ReadHeader(data, size, pos, false, header) || header.group != 0xFFFE || header.element != 0xE000 ||
+        header.length == kUndefinedLength || header.length > size - header.valueOffset) {
+        return false;
+    }
+    const ByteSpan basicOffsets{header.valueOffset, header.length};
+    pos = header.valueOffset + header.length;
+
+    std::vector<Fragment> fragments;
+    const size_t firstFragment = pos;
+    for (;;) {
+        if (!ReadHeader(data, size, pos, false, header) || header.group != 0xFFFE) {
+            return false;
+        }
+        if (header.element == 0xE0DD) {
+            break;
+        }
+        if (header.element != 0xE000 || header.length == kUndefinedLength || header.length > size - header.valueOffset) {
+            return false;
+        }
+        fragments.push_back({pos - firstFragment, {header.valueOffset, header.length}});
+        pos = header.valueOffset + header.length;
+    }
+    if (fragments.empty()) {
+        return false;
+    }
+
+    std::vector<uint64_t> offsets;
+    if (extendedOffsets.length >= 8 * geometry.frames) {
+        for (unsigned long i = 0; i < geometry.frames; ++i) {
+            offsets.push_back(ReadU64(data + extendedOffsets.offset + 8 * i));
+        }
+    } else if (basicOffsets.length >= 4) {
+        for (size_t i = 0; i + 4 <= basicOffsets.length; i += 4) {
+            offsets.push_back(ReadU32(data + basicOffsets.offset + i));
+        }
+    }
+
+    frames.clear();
+    if (!offsets.empty()) {
+        for (size_t f = 0; f < offsets.size(); ++f) {
+            const uint64_t begin = offsets[f];
+            const uint64_t end = f + 1 < offsets.size() ? offsets[f + 1] : UINT64_MAX;
+            std::vector<ByteSpan> spans;
+            for (const auto& fragment : fragments) {
+                if (fragment.itemOffset >= begin && fragment.itemOffset < end) {
+                    spans.push_back(fragment.value);
+                }
+            }
+            frames.push_back(std::move(spans));
+        }
+    } else if (geometry.frames == 1) {
+        std::vector<ByteSpan> spans;
+        for (const auto& fragment : fragments) {
+            spans.push_back(fragment.value);
+        }
+        frames.push_back(std::move(spans));
+    } else if (fragments.size() == geometry.frames) {
+        for (const auto& fragment : fragments) {
+            frames.push_back({fragment.value});
+        }
+    } else {
+        // No offset table and several fragments per frame: split on codestream start markers
+        for (const auto& fragment : fragments) {
+            if (frames.empty() || StartsNewCodestream(data, fragment.value)) {
+                frames.emplace_back();
+            }
+            frames.back().push_back(fragment.value);
+        }
+    }
+    return frames.size() == geometry.frames &&
+           std::none_of(frames.begin(), frames.end(), [](const std::vector<ByteSpan>& spans) { return spans.empty(); });
+}
+
+bool LocateFrames(const uint8_t* data, size_t size, const FrameGeometry& geometry, std::string& transferSyntax,
+                  std::vector<std::vector<ByteSpan>>& frames, std::string& error) {
+    if (size < 132 || std::memcmp(data + 128, "DICM", 4) != 0) {
+        error = "not a DICOM Part 10 file";
+        return false;
+    }
+    // File Meta Information is always explicit VR little endian
+    size_t pos = 132;
+    ElementHeader header;
+    while (ReadHeader(data, size, pos, true, header) && header.group == 0x0002) {
+        if (header.length > size - header.valueOffset) {
+            error = "truncated meta header";
+            return false;
+        }
+        if (header.element == 0x0010) {
+            transferSyntax.assign(reinterpret_cast<const char*>(data + header.valueOffset), header.length);
+            transferSyntax.erase(transferSyntax.find_last_not_of(std::string(" \0", 2)) + 1);
+        }
+        pos = header.valueOffset + header.length;
+    }
+    if (transferSyntax == UID_BigEndianExplicitTransferSyntax || transferSyntax == UID_DeflatedExplicitVRLittleEndianTransferSyntax) {
+        error = "frames cannot be sliced from " + transferSyntax + " without decoding";
+        return false;
+    }
+    const bool explicitVR = transferSyntax != UID_LittleEndianImplicitTransferSyntax;
+
+    ByteSpan extendedOffsets;
+    while (ReadHeader(data, size, pos, explicitVR, header)) {
+        pos = header.valueOffset;
+        if (header.group == 0x7FE0 && header.element == 0x0010) {
+            if (header.length == kUndefinedLength) {
+                if (!BuildEncapsulatedFrames(data, size, pos, geometry, extendedOffsets, frames)) {
+                    error = "could not map fragments to frames";
+                    return false;
+                }
+                return true;
+            }
+            if (header.length > size - pos) {
+                error = "truncated Pixel Data";
+                return false;
+            }
+            // Native pixels: frames are contiguous and must start on a byte boundary
+            const uint64_t frameBits = static_cast<uint64_t>(geometry.rows) * geometry.columns * geometry.samplesPerPixel * geometry.bitsAllocated;
+            if (frameBits == 0 || (geometry.frames > 1 && frameBits % 8 != 0)) {
+                error = "native frames are not byte aligned";
+                return false;
+            }
+            const size_t frameBytes = static_cast<size_t>((frameBits + 7) / 8);
+            frames.clear();
+            for (unsigned long f = 0; f < geometry.frames && (f + 1) * frameBytes <= header.length; ++f) {
+                frames.push_back({{pos + f * frameBytes, frameBytes}});
+            }
+            return !frames.empty();
+        }
+        if (header.group == 0x7FE0 && header.element == 0x0001 && header.length != kUndefinedLength) {
+            extendedOffsets = {pos, header.length};
+        }
+        if (header.length == kUndefinedLength) {
+            const bool nestedExplicit = explicitVR && !(header.vr[0] == 'U' && header.vr[1] == 'N');
+            if (!SkipSequence(data, size, pos, nestedExplicit, 0)) {
+                error = "malformed sequence";
+                return false;
+            }
+        } else if (header.length > size - pos) {
+            break;
+        } else {
+            pos += header.length;
+        }
+    }
+    error = "no Pixel Data";
+    return false;
+}
+
+std::string FrameMediaType(const std::string& transferSyntax) {
+    if (transferSyntax == UID_JPEGProcess1TransferSyntax || transferSyntax == UID_JPEGProcess2_4TransferSyntax ||
+        transferSyntax == UID_JPEGProcess14TransferSyntax || transferSyntax == UID_JPEGProcess14SV1TransferSyntax) {
+        return "image/jpeg";
+    }
+    if (transferSyntax == UID_JPEGLSLosslessTransferSyntax || transferSyntax == UID_JPEGLSLossyTransferSyntax) {
+        return "image/jls";
+    }
+    if (transferSyntax == UID_JPEG2000LosslessOnlyTransferSyntax || transferSyntax == UID_JPEG2000TransferSyntax) {
+        return "image/jp2";
+    }
+    if (transferSyntax == UID_RLELosslessTransferSyntax) {
+        return "image/x-dicom-rle";
+    }
+    return "application/octet-stream";
+}
+
+// ---------------------------------------------------------------------------
+// Catalog and caches
+// ---------------------------------------------------------------------------
+
+struct InstanceRecord {
+    std::string file;
+    std::string studyUID;
+    std::string seriesUID;
+    std::string sopInstanceUID;
+    std::string sopClassUID;
+    std::string transferSyntaxUID;
+    std::string patientName;
+    std::string patientID;
+    std::string modality;
+    FrameGeometry geometry;
+};
+
+bool ReadInstanceRecord(const std::string& file, InstanceRecord& record) {
+    DcmFileFormat header;
+    if (header.loadFileUntilTag(OFFilename(file.c_str()), EXS_Unknown, EGL_noChange, DCM_MaxReadLength,
+                                ERM_autoDetect, DCM_PixelData).bad()) {
+        return false;
+    }
+    DcmDataset* dataset = header.getDataset();
+    auto fetch = [&](DcmItem* item, const DcmTagKey& tag, std::string& target) {
+        OFString value;
+        if (item->findAndGetOFStringArray(tag, value).good()) {
+            target = value.c_str();
+        }
+    };
+    record.file = file;
+    fetch(dataset, DCM_StudyInstanceUID, record.studyUID);
+    fetch(dataset, DCM_SeriesInstanceUID, record.seriesUID);
+    fetch(dataset, DCM_SOPInstanceUID, record.sopInstanceUID);
+    fetch(dataset, DCM_SOPClassUID, record.sopClassUID);
+    fetch(dataset, DCM_PatientName, record.patientName);
+    fetch(dataset, DCM_PatientID, record.patientID);
+    fetch(dataset, DCM_Modality, record.modality);
+    fetch(header.getMetaInfo(), DCM_TransferSyntaxUID, record.transferSyntaxUID);
+
+    Uint16 value = 0;
+    Sint32 frames = 1;
+    if (dataset->findAndGetSint32(DCM_NumberOfFrames, frames).good() && frames > 0) record.geometry.frames = static_cast<unsigned long>(frames);
+    if (dataset->findAndGetUint16(DCM_Rows, value).good()) record.geometry.rows = value;
+    if (dataset->findAndGetUint16(DCM_Columns, value).good()) record.geometry.columns = value;
+    if (dataset->findAndGetUint16(DCM_SamplesPerPixel, value).good()) record.geometry.samplesPerPixel = value;
+    if (dataset->findAndGetUint16(DCM_BitsAllocated, value).good()) record.geometry.bitsAllocated = value;
+    return !record.studyUID.empty() && !record.seriesUID.empty() && !record.sopInstanceUID.empty();
+}
+
+class Catalog {
+public:
+    void Add(const InstanceRecord& record) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto existing = instances_.find(record.sopInstanceUID);
+        if (existing == instances_.end()) {
+            studies_[record.studyUID][record.seriesUID].push_back(record.sopInstanceUID);
+        }
+        instances_[record.sopInstanceUID] = record;
+    }
+
+    bool Find(const std::string& sopInstanceUID, InstanceRecord& record) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = instances_.find(sopInstanceUID);
+        if (it == instances_.end()) {
+            return false;
+        }
+        record = it->second;
+        return true;
+    }
+
+    std::vector<std::string> SeriesOf(const std::string& studyUID) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        std::vector<std::string> series;
+        auto study = studies_.find(studyUID);
+        if (study != studies_.end()) {
+            for (const auto& entry : study->second) {
+                series.push_back(entry.first);
+            }
+        }
+        return series;
+    }
+
+    std::vector<InstanceRecord> InstancesOf(const std::string& studyUID, const std::string& seriesUID) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        std::vector<InstanceRecord> records;
+        auto study = studies_.find(studyUID);
+        if (study == studies_.end()) {
+            return records;
+        }
+        auto series = study->second.find(seriesUID);
+        if (series != study->second.end()) {
+            for (const auto& sop : series->second) {
+                records.push_back(instances_.at(sop));
+            }
+        }
+        return records;
+    }
+
+    std::vector<std::string> Studies() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        std::vector<std::string> studies;
+        for (const auto& entry : studies_) {
+            studies.push_back(entry.first);
+        }
+        return studies;
+    }
+
+    size_t Size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return instances_.size();
+    }
+
+private:
+    mutable std::shared_mutex mutex_;
+    std::map<std::string, InstanceRecord> instances_;
+    std::map<std::string, std::map<std::string, std::vector<std::string>>> studies_;
+};
+
+template <typename Value>
+class LruCache {
+public:
+    // Budget is in the units returned by `cost` (bytes for payloads, bytes mapped for instances)
+    LruCache(size_t budget, std::function<size_t(const Value&)> cost) : budget_(budget), cost_(std::move(cost)) {}
+
+    std::shared_ptr<const Value> Get(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            ++misses_;
+            return nullptr;
+        }
+        ++hits_;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->second;
+    }
+
+    void Put(const std::string& key, std::shared_ptr<const Value> value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        EraseLocked(key);
+        used_ += cost_(*value);
+        entries_.emplace_front(key, std::move(value));
+        index_[key] = entries_.begin();
+        // Evicted values stay alive while a response still holds them
+        while (used_ > budget_ && entries_.size() > 1) {
+            EraseLocked(entries_.back().first);
+        }
+    }
+
+    void Erase(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        EraseLocked(key);
+    }
+
+    size_t Hits() const { return hits_; }
+    size_t Misses() const { return misses_; }
+
+private:
+    void EraseLocked(const std::string& key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return;
+        }
+        used_ -= cost_(*it->second->second);
+        entries_.erase(it->second);
+        index_.erase(it);
+    }
+
+    using Entry = std::pair<std::string, std::shared_ptr<const Value>>;
+    size_t budget_;
+    size_t used_{0};
+    std::function<size_t(const Value&)> cost_;
+    std::list<Entry> entries_;
+    std::unordered_map<std::string, typename std::list<Entry>::iterator> index_;
+    std::mutex mutex_;
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+};
+
+class MappedInstance {
+public:
+    // Maps the whole file read-only and indexes its frames; the descriptor is closed once the mapping exists
+    static std::shared_ptr<const MappedInstance> Open(const InstanceRecord& record, std::string& error) {
+        const int fd = ::open(record.file.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = std::strerror(errno);
+            return nullptr;
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+            ::close(fd);
+            error = "empty file";
+            return nullptr;
+        }
+        const size_t size = static_cast<size_t>(info.st_size);
+        void* base = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            error = std::strerror(errno);
+            return nullptr;
+        }
+        // Frame requests jump around the file; skip kernel readahead past the range asked for
+        ::madvise(base, size, MADV_RANDOM);
+        std::shared_ptr<MappedInstance> instance(new MappedInstance(static_cast<const uint8_t*>(base), size));
+        if (!LocateFrames(instance->data_, size, record.geometry, instance->transferSyntax_, instance->frames_, error)) {
+            return nullptr;
+        }
+        instance->mediaType_ = FrameMediaType(instance->transferSyntax_);
+        return instance;
+    }
+
+    ~MappedInstance() { ::munmap(const_cast<uint8_t*>(data_), size_); }
+
+    MappedInstance(const MappedInstance&) = delete;
+    MappedInstance& operator=(const MappedInstance&) = delete;
+
+    const uint8_t* Data() const { return data_; }
+    size_t Size() const { return size_; }
+    const std::vector<std::vector<ByteSpan>>& Frames() const { return frames_; }
+    const std::string& TransferSyntax() const { return transferSyntax_; }
+    const std::string& MediaType() const { return mediaType_; }
+
+    // Ask the kernel to start paging a frame in before it is written to the socket
+    void Prefetch(const std::vector<ByteSpan>& spans) const {
+        const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        for (const auto& span : spans) {
+            const size_t start = span.offset / page * page;
+            ::madvise(const_cast<uint8_t*>(data_) + start, span.offset + span.length - start, MADV_WILLNEED);
+        }
+    }
+
+private:
+    MappedInstance(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    const uint8_t* data_;
+    size_t size_;
+    std::string transferSyntax_;
+    std::string mediaType_;
+    std::vector<std::vector<ByteSpan>> frames_;
+};
+
+// ---------------------------------------------------------------------------
+// Minimal HTTP/1.1 on POSIX sockets (localhost only, Content-Length bodies, keep-alive)
+// ---------------------------------------------------------------------------
+
+struct HttpRequest {
+    std::string method;
+    std::string path;
+    std::string query;
+    std::map<std::string, std::string> headers; // lower-case names
+    std::string body;
+    bool keepAlive{true};
+
+    std::string Header(const std::string& name) const {
+        auto it = headers.find(name);
+        return it == headers.end() ? std::string() : it->second;
+    }
+};
+
+enum class ReadResult { Ok, Closed, Malformed, TooLarge, LengthRequired };
+
+bool SendAll(int fd, std::vector<iovec> parts) {
+    size_t index = 0;
+    while (index < parts.size()) {
+        const int count = static_cast<int>(std::min<size_t>(parts.size() - index, IOV_MAX));
+        const ssize_t sent = ::writev(fd, parts.data() + index, count);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        // Drop fully written vectors and advance into a partially written one
+        size_t remaining = static_cast<size_t>(sent);
+        while (index < parts.size() && remaining >= parts[index].iov_len) {
+            remaining -= parts[index].iov_len;
+            ++index;
+        }
+        if (index < parts.size()) {
+            parts[index].iov_base = static_cast<char*>(parts[index].iov_base) + remaining;
+            parts[index].iov_len -= remaining;
+        }
+    }
+    return true;
+}
+
+iovec View(const std::string& text) {
+    return {const_cast<char*>(text.data()), text.size()};
+}
+
+const char* ReasonPhrase(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 202: return "Accepted";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 406: return "Not Acceptable";
+        case 409: return "Conflict";
+        case 411: return "Length Required";
+        case 413: return "Payload Too Large";
+        case 415: return "Unsupported Media Type";
+        default: return "Internal Server Error";
+    }
+}
+
+std::string ResponseHead(int status, const std::string& contentType, size_t contentLength, bool keepAlive) {
+    std::ostringstream head;
+    head << "HTTP/1.1 " << status << " " << ReasonPhrase(status) << "\r\n"
+         << "Content-Type: " << contentType << "\r\n"
+         << "Content-Length: " << contentLength << "\r\n"
+         << "Access-Control-Allow-Origin: *\r\n"
+         << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n\r\n";
+    return head.str();
+}
+
+bool SendResponse(int fd, int status, const std::string& contentType, const std::string& body, bool keepAlive) {
+    const std::string head = ResponseHead(status, contentType, body.size(), keepAlive);
+    return SendAll(fd, {View(head), View(body)});
+}
+
+bool SendError(int fd, int status, const std::string& message, bool keepAlive) {
+    return SendResponse(fd, status, "text/plain", message + "\n", keepAlive);
+}
+
+std::string Lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string TrimSpaces(const std::string& text) {
+    const size_t first = text.find_first_not_of(" \t");
+    const size_t last = text.find_last_not_of(" \t\r");
+    return first == std::string::npos ? std::string() : text.substr(first, last - first + 1);
+}
+
+// `buffer` carries bytes read past the end of one request (pipelining) into the next call
+ReadResult ReadRequest(int fd, std::string& buffer, HttpRequest& request) {
+    char chunk[16384];
+    size_t headerEnd;
+    while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+        if (buffer.size() > 64 * 1024) {
+            return ReadResult::Malformed;
+        }
+        const ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            return ReadResult::Closed;
+        }
+        buffer.append(chunk, static_cast<size_t>(received));
+    }
+
+    std::istringstream head(buffer.substr(0, headerEnd));
+    std::string line;
+    std::string target;
+    std::string version;
+    if (!std::getline(head, line)) {
+        return ReadResult::Malformed;
+    }
+    std::istringstream requestLine(line);
+    if (!(requestLine >> request.method >> target >> version)) {
+        return ReadResult::Malformed;
+    }
+    const size_t question = target.find('?');
+    request.path = target.substr(0, question);
+    request.query = question == std::string::npos ? std::string() : target.substr(question + 1);
+    request.headers.clear();
+    while (std::getline(head, line)) {
+        const size_t colon = line.find(':');
+        if (colon != std::string::npos) {
+            request.headers[Lowercase(TrimSpaces(line.substr(0, colon)))] = TrimSpaces(line.substr(colon + 1));
+        }
+    }
+    const std::string connection = Lowercase(request.Header("connection"));
+    request.keepAlive = version == "HTTP/1.1" ? connection != "close" : connection == "keep-alive";
+    buffer.erase(0, headerEnd + 4);
+
+    request.body.clear();
+    if (!request.Header("transfer-encoding").empty()) {
+        return ReadResult::LengthRequired;
+    }
+    const std::string lengthHeader = request.Header("content-length");
+    const size_t length = lengthHeader.empty() ? 0 : static_cast<size_t>(std::strtoull(lengthHeader.c_str(), nullptr, 10));
+    if (length > kMaxRequestBody) {
+        return ReadResult::TooLarge;
+    }
+    request.body.reserve(length);
+    const size_t buffered = std::min(length, buffer.size());
+    request.body.assign(buffer, 0, buffered);
+    buffer.erase(0, buffered);
+    while (request.body.size() < length) {
+        const ssize_t received = ::recv(fd, chunk, std::min(sizeof(chunk), length - request.body.size()), 0);
+        if (received <= 0) {
+            return ReadResult::Closed;
+        }
+        request.body.append(chunk, static_cast<size_t>(received));
+    }
+    return ReadResult::Ok;
+}
+
+std::vector<std::string> SplitPath(const std::string& path) {
+    std::vector<std::string> segments;
+    std::stringstream stream(path);
+    std::string segment;
+    while (std::getline(stream, segment, '/')) {
+        if (!segment.empty()) {
+            segments.push_back(segment);
+        }
+    }
+    return segments;
+}
+
+std::string QueryParameter(const std::string& query, const std::string& name) {
+    std::stringstream stream(query);
+    std::string pair;
+    while (std::getline(stream, pair, '&')) {
+        const size_t equals = pair.find('=');
+        if (pair.substr(0, equals) == name) {
+            return equals == std::string::npos ? std::string() : pair.substr(equals + 1);
+        }
+    }
+    return std::string();
+}
+
+// Accept is honoured loosely: frames are only ever sent in their stored encoding
+bool Accepts(const std::string& accept, const std::string& mediaType) {
+    return accept.empty() || accept.find("*/*") != std::string::npos || accept.find(mediaType) != std::string::npos ||
+           accept.find("transfer-syntax=*") != std::string::npos;
+}
+
+std::string JsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+std::string JsonAttribute(const char* tag, const char* vr, const std::string& value) {
+    if (std::string(vr) == "PN") {
+        return std::string("\"") + tag + "\":{\"vr\":\"PN\",\"Value\":[{\"Alphabetic\":\"" + JsonEscape(value) + "\"}]}";
+    }
+    if (std::string(vr) == "IS" || std::string(vr) == "US") {
+        return std::string("\"") + tag + "\":{\"vr\":\"" + vr + "\",\"Value\":[" + value + "]}";
+    }
+    return std::string("\"") + tag + "\":{\"vr\":\"" + vr + "\",\"Value\":[\"" + JsonEscape(value) + "\"]}";
+}
+
+// ---------------------------------------------------------------------------
+// DICOMweb routes
+// ---------------------------------------------------------------------------
+
+class DicomWebServer {
+public:
+    DicomWebServer(Catalog& catalog, const fs::path& stowRoot, unsigned short port)
+        : catalog_(catalog), stowRoot_(stowRoot), baseUrl_("http://127.0.0.1:" + std::to_string(port)),
+          // Mapped instances are charged by file size; evicting one only unmaps after in-flight responses finish
+          mappings_(size_t(2) << 30, [](const MappedInstance& instance) { return instance.Size(); }),
+          documents_(size_t(256) << 20, [](const std::string& document) { return document.size(); }) {}
+
+    void Serve(int fd) {
+        std::string buffer;
+        HttpRequest request;
+        for (;;) {
+            const ReadResult result = ReadRequest(fd, buffer, request);
+            if (result == ReadResult::Closed) {
+                break;
+            }
+            if (result != ReadResult::Ok) {
+                SendError(fd, result == ReadResult::TooLarge ? 413 : result == ReadResult::LengthRequired ? 411 : 400,
+                          "Request rejected", false);
+                break;
+            }
+            ++requests_;
+            const bool keepAlive = request.keepAlive && !g_stopRequested;
+            if (!Route(fd, request, keepAlive) || !keepAlive) {
+                break;
+            }
+        }
+        ::close(fd);
+    }
+
+    size_t Requests() const { return requests_; }
+    size_t FramesServed() const { return frames_; }
+    size_t MappingHits() const { return mappings_.Hits(); }
+    size_t MappingMisses() const { return mappings_.Misses(); }
+
+private:
+    bool Route(int fd, const HttpRequest& request, bool keepAlive) {
+        const std::vector<std::string> segments = SplitPath(request.path);
+        if (segments.empty() || segments[0] != "studies") {
+            return SendError(fd, 404, "Unknown resource", keepAlive);
+        }
+        if (request.method == "POST") {
+            return segments.size() <= 2 ? Store(fd, request, segments.size() == 2 ? segments[1] : std::string(), keepAlive)
+                                        : SendError(fd, 405, "STOW-RS accepts /studies or /studies/{study}", keepAlive);
+        }
+        if (request.method != "GET") {
+            return SendError(fd, 405, "Only GET and POST are supported", keepAlive);
+        }
+        const size_t n = segments.size();
+        if (n == 1) {
+            return StudyList(fd, keepAlive);
+        }
+        if (n == 3 && segments[2] == "metadata") {
+            return StudyMetadata(fd, segments[1], keepAlive);
+        }
+        if (n == 3 && segments[2] == "series") {
+            return SeriesList(fd, segments[1], keepAlive);
+        }
+        if (n == 5 && segments[2] == "series" && segments[4] == "metadata") {
+            return SendJson(fd, SeriesMetadata(segments[1], segments[3]), keepAlive);
+        }
+        if (n >= 7 && segments[2] == "series" && segments[4] == "instances") {
+            InstanceRecord record;
+            if (!catalog_.Find(segments[5], record) || record.studyUID != segments[1] || record.seriesUID != segments[3]) {
+                return SendError(fd, 404, "Unknown instance", keepAlive);
+            }
+            if (n == 8 && segments[6] == "frames") {
+                return Frames(fd, request, record, segments[7], keepAlive);
+            }
+            if (n == 7 && segments[6] == "thumbnail") {
+                return Thumbnail(fd, record, request.query, keepAlive);
+            }
+        }
+        return SendError(fd, 404, "Unknown resource", keepAlive);
+    }
+
+    bool SendJson(int fd, const std::string& json, bool keepAlive) {
+        return SendResponse(fd, json == "[]" ? 404 : 200, "application/dicom+json", json, keepAlive);
+    }
+
+    bool StudyList(int fd, bool keepAlive) {
+        // QIDO-RS style listing without filters, enough for a viewer to discover what is served
+        std::string json = "[";
+        for (const auto& studyUID : catalog_.Studies()) {
+            size_t instances = 0;
+            InstanceRecord sample;
+            const std::vector<std::string> series = catalog_.SeriesOf(studyUID);
+            for (const auto& seriesUID : series) {
+                const std::vector<InstanceRecord> records = catalog_.InstancesOf(studyUID, seriesUID);
+                instances += records.size();
+                if (!records.empty()) {
+                    sample = records.front();
+                }
+            }
+            json += std::string(json.size() > 1 ? "," : "") + "{" + JsonAttribute("0020000D", "UI", studyUID) + "," +
+                    JsonAttribute("00100010", "PN", sample.patientName) + "," + JsonAttribute("00100020", "LO", sample.patientID) +
+                    "," + JsonAttribute("00201206", "IS", std::to_string(series.size())) + "," +
+                    JsonAttribute("00201208", "IS", std::to_string(instances)) + "}";
+        }
+        return SendResponse(fd, 200, "application/dicom+json", json + "]", keepAlive);
+    }
+
+    bool SeriesList(int fd, const std::string& studyUID, bool keepAlive) {
+        std::string json = "[";
+        for (const auto& seriesUID : catalog_.SeriesOf(studyUID)) {
+            const std::vector<InstanceRecord> records = catalog_.InstancesOf(studyUID, seriesUID);
+            json += std::string(json.size() > 1 ? "," : "") + "{" + JsonAttribute("0020000E", "UI", seriesUID) + "," +
+                    JsonAttribute("00080060", "CS", records.empty() ? std::string() : records.front().modality) + "," +
+                    JsonAttribute("00201209", "IS", std::to_string(records.size())) + "}";
+        }
+        return SendJson(fd, json + "]", keepAlive);
+    }
+
+    bool StudyMetadata(int fd, const std::string& studyUID, bool keepAlive) {
+        std::string json = "[";
+        for (const auto& seriesUID : catalog_.SeriesOf(studyUID)) {
+            const std::string series = SeriesMetadata(studyUID, seriesUID);
+            if (series.size() > 2) {
+                json += (json.size() > 1 ? "," : "") + series.substr(1, series.size() - 2);
+            }
+        }
+        return SendJson(fd, json + "]", keepAlive);
+    }
+
+    // Series metadata is rendered once per series through DCMTK's JSON writer and then served from the cache
+    std::string SeriesMetadata(const std::string& studyUID, const std::string& seriesUID) {
+        const std::string key = "metadata/" + studyUID + "/" + seriesUID;
+        if (auto cached = documents_.Get(key)) {
+            return *cached;
+        }
+        const std::vector<InstanceRecord> records = catalog_.InstancesOf(studyUID, seriesUID);
+        std::vector<std::string> documents(records.size());
+        ParallelUtils::ParallelFor(records.size(), 0, [&](unsigned int, size_t i) {
+            DcmFileFormat header;
+            if (header.loadFileUntilTag(OFFilename(records[i].file.c_str()), EXS_Unknown, EGL_noChange, DCM_MaxReadLength,
+                                        ERM_autoDetect, DCM_PixelData).bad()) {
+                return;
+            }
+            std::ostringstream out;
+            DcmJsonFormatCompact format;
+            header.getDataset()->writeJson(out, format);
+            std::string document = out.str();
+            // Loading stopped at Pixel Data, so point clients at the frames resource instead
+            const size_t close = document.find_last_of('}');
+            if (close == std::string::npos) {
+                return;
+            }
+            const size_t previous = document.find_last_not_of(" \r\n\t", close == 0 ? 0 : close - 1);
+            const bool empty = previous == std::string::npos || document[previous] == '{';
+            document.insert(close, std::string(empty ? "" : ",") + "\"7FE00010\":{\"vr\":\"" +
+                                       (records[i].geometry.bitsAllocated > 8 ? "OW" : "OB") + "\",\"BulkDataURI\":\"" + baseUrl_ +
+                                       "/studies/" + studyUID + "/series/" + seriesUID + "/instances/" +
+                                       records[i].sopInstanceUID + "/frames\"}");
+            documents[i] = std::move(document);
+        });
+        std::string json = "[";
+        for (const auto& document : documents) {
+            if (!document.empty()) {
+                json += (json.size() > 1 ? "," : "") + document;
+            }
+        }
+        json += "]";
+        documents_.Put(key, std::make_shared<const std::string>(json));
+        return json;
+    }
+
+    std::shared_ptr<const MappedInstance> Map(const InstanceRecord& record, std::string& error) {
+        if (auto cached = mappings_.Get(record.sopInstanceUID)) {
+            return cached;
+        }
+        auto instance = MappedInstance::Open(record, error);
+        if (instance) {
+            mappings_.Put(record.sopInstanceUID, instance);
+        }
+        return instance;
+    }
+
+    bool Frames(int fd, const HttpRequest& request, const InstanceRecord& record, const std::string& list, bool keepAlive) {
+        std::string error;
+        std::shared_ptr<const MappedInstance> instance = Map(record, error);
+        if (!instance) {
+            return SendError(fd, 415, "Cannot serve frames of " + record.sopInstanceUID + ": " + error, keepAlive);
+        }
+        if (!Accepts(request.Header("accept"), instance->MediaType())) {
+            return SendError(fd, 406, "Frames are stored as " + instance->MediaType() + " and are not transcoded", keepAlive);
+        }
+
+        std::vector<size_t> numbers;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            const unsigned long number = std::strtoul(item.c_str(), nullptr, 10);
+            if (number == 0 || number > instance->Frames().size()) {
+                return SendError(fd, 404, "Frame " + item + " is out of range", keepAlive);
+            }
+            numbers.push_back(number - 1);
+        }
+        if (numbers.empty()) {
+            return SendError(fd, 400, "No frame numbers", keepAlive);
+        }
+
+        // Part headers live in `strings`; frame bytes are referenced straight from the mapping
+        static const std::string kBoundary = "DicomToolsFrameBoundary";
+        const std::string partHead = "--" + kBoundary + "\r\nContent-Type: " + instance->MediaType() +
+                                     "; transfer-syntax=" + instance->TransferSyntax() + "\r\n\r\n";
+        static const std::string kPartEnd = "\r\n";
+        static const std::string kClose = "--" + kBoundary + "--\r\n";
+        std::vector<iovec> body;
+        size_t length = 0;
+        for (size_t frame : numbers) {
+            const std::vector<ByteSpan>& spans = instance->Frames()[frame];
+            instance->Prefetch(spans);
+            body.push_back(View(partHead));
+            length += partHead.size();
+            for (const auto& span : spans) {
+                body.push_back({const_cast<uint8_t*>(instance->Data()) + span.offset, span.length});
+                length += span.length;
+            }
+            body.push_back(View(kPartEnd));
+            length += kPartEnd.size();
+        }
+        body.push_back(View(kClose));
+        length += kClose.size();
+
+        const std::string head = ResponseHead(200, "multipart/related; type=\"" + instance->MediaType() + "\"; boundary=" + kBoundary,
+                                              length, keepAlive);
+        body.insert(body.begin(), View(head));
+        frames_ += numbers.size();
+        return SendAll(fd, std::move(body));
+    }
+
+    bool Thumbnail(int fd, const InstanceRecord& record, const std::string& query, bool keepAlive) {
+        const std::string frameParameter = QueryParameter(query, "frame");
+        const unsigned long frame = frameParameter.empty() ? 0 : std::max(1UL, std::strtoul(frameParameter.c_str(), nullptr, 10)) - 1;
+        const std::string key = "thumbnail/" + record.sopInstanceUID + "/" + std::to_string(frame);
+        std::shared_ptr<const std::string> jpeg = documents_.Get(key);
+        if (!jpeg) {
+            std::string rendered;
+            if (!RenderThumbnail(record, frame, rendered)) {
+                return SendError(fd, 415, "Could not render " + record.sopInstanceUID, keepAlive);
+            }
+            jpeg = std::make_shared<const std::string>(std::move(rendered));
+            documents_.Put(key, jpeg);
+        }
+        return SendResponse(fd, 200, "image/jpeg", *jpeg, keepAlive);
+    }
+
+    static bool RenderThumbnail(const InstanceRecord& record, unsigned long frame, std::string& jpeg) {
+        DCMTKCodecRegistry::Instance();
+        DicomImage image(record.file.c_str(), CIF_UsePartialAccessToPixelData, frame, 1);
+        if (image.getStatus() != EIS_Normal) {
+            return false;
+        }
+        const unsigned long width = std::min(kThumbnailWidth, image.getWidth());
+        std::unique_ptr<DicomImage> scaled(image.createScaledImage(width, 0UL, 1 /*interpolate*/));
+        if (!scaled || scaled->getStatus() != EIS_Normal) {
+            return false;
+        }
+        if (scaled->isMonochrome()) {
+            if (scaled->getWindowCount() > 0) {
+                scaled->setWindow(0);
+            } else {
+                scaled->setMinMaxWindow();
+            }
+        }
+        // DiJPEGPlugin writes to a FILE*, so render into an anonymous temporary file
+        std::unique_ptr<FILE, int (*)(FILE*)> stream(std::tmpfile(), &std::fclose);
+        if (!stream) {
+            return false;
+        }
+        DiJPEGPlugin plugin;
+        plugin.setQuality(85);
+        if (!scaled->writePluginFormat(&plugin, stream.get(), 0)) {
+            return false;
+        }
+        jpeg.resize(static_cast<size_t>(std::ftell(stream.get())));
+        std::rewind(stream.get());
+        return std::fread(&jpeg[0], 1, jpeg.size(), stream.get()) == jpeg.size();
+    }
+
+    bool Store(int fd, const HttpRequest& request, const std::string& studyUID, bool keepAlive) {
+        const std::string contentType = request.Header("content-type");
+        const size_t boundaryAt = contentType.find("boundary=");
+        if (Lowercase(contentType).find("multipart/related") == std::string::npos || boundaryAt == std::string::npos) {
+            return SendError(fd, 415, "STOW-RS expects multipart/related; type=\"application/dicom\"", keepAlive);
+        }
+        std::string boundary = contentType.substr(boundaryAt + 9);
+        boundary = boundary.substr(0, boundary.find(';'));
+        boundary.erase(std::remove(boundary.begin(), boundary.end(), '"'), boundary.end());
+        const std::string delimiter = "--" + boundary;
+
+        std::string referenced;
+        std::string failed;
+        std::error_code ec;
+        fs::create_directories(stowRoot_, ec);
+        size_t position = request.body.find(delimiter);
+        while (position != std::string::npos) {
+            position += delimiter.size();
+            if (request.body.compare(position, 2, "--") == 0) {
+                break;
+            }
+            const size_t headersEnd = request.body.find("\r\n\r\n", position);
+            const size_t next = headersEnd == std::string::npos ? std::string::npos : request.body.find("\r\n" + delimiter, headersEnd);
+            if (next == std::string::npos) {
+                break;
+            }
+            const size_t contentStart = headersEnd + 4;
+            // Not .dcm, so a part left behind by a crash is never indexed at startup
+            const fs::path incoming = stowRoot_ / ("incoming-" + std::to_string(++uploads_) + ".part");
+            {
+                std::ofstream out(incoming, std::ios::binary);
+                out.write(request.body.data() + contentStart, static_cast<std::streamsize>(next - contentStart));
+            }
+
+            InstanceRecord record;
+            Uint16 failure = 0;
+            // UIDs become directory and file names under dicomweb_stow/
+            if (!ReadInstanceRecord(incoming.string(), record) || !FileSystemUtils::IsPathSafeUID(record.studyUID) ||
+                !FileSystemUtils::IsPathSafeUID(record.sopInstanceUID)) {
+                failure = 0xC000; // cannot understand
+            } else if (!studyUID.empty() && record.studyUID != studyUID) {
+                failure = 0xA900; // does not match the target study
+            } else {
+                const fs::path target = stowRoot_ / record.studyUID / (record.sopInstanceUID + ".dcm");
+                fs::create_directories(target.parent_path(), ec);
+                fs::rename(incoming, target, ec);
+                if (ec) {
+                    failure = 0x0110; // processing failure
+                } else {
+                    record.file = target.string();
+                    catalog_.Add(record);
+                    documents_.Erase("metadata/" + record.studyUID + "/" + record.seriesUID);
+                    mappings_.Erase(record.sopInstanceUID);
+                    referenced += std::string(referenced.empty() ? "" : ",") + "{" + JsonAttribute("00081150", "UI", record.sopClassUID) +
+                                  "," + JsonAttribute("00081155", "UI", record.sopInstanceUID) + "," +
+                                  JsonAttribute("00081190", "UR", baseUrl_ + "/studies/" + record.studyUID + "/series/" +
+                                                                       record.seriesUID + "/instances/" + record.sopInstanceUID) + "}";
+                }
+            }
+            if (failure != 0) {
+                fs::remove(incoming, ec);
+                failed += std::string(failed.empty() ? "" : ",") + "{" + JsonAttribute("00081155", "UI", record.sopInstanceUID) +
+                          "," + JsonAttribute("00081197", "US", std::to_string(failure)) + "}";
+            }
+            position = next + 2;
+        }
+
+        std::string json = "{";
+        if (!referenced.empty()) {
+            json += "\"00081199\":{\"vr\":\"SQ\",\"Value\":[" + referenced + "]}";
+        }
+        if (!failed.empty()) {
+            json += std::string(referenced.empty() ? "" : ",") + "\"00081198\":{\"vr\":\"SQ\",\"Value\":[" + failed + "]}";
+        }
+        json += "}";
+        const int status = failed.empty() ? (referenced.empty() ? 400 : 200) : (referenced.empty() ? 409 : 202);
+        return SendResponse(fd, status, "application/dicom+json", json, keepAlive);
+    }
+
+    Catalog& catalog_;
+    fs::path stowRoot_;
+    std::string baseUrl_;
+    LruCache<MappedInstance> mappings_;
+    LruCache<std::string> documents_;
+    std::atomic<size_t> requests_{0};
+    std::atomic<size_t> frames_{0};
+    std::atomic<size_t> uploads_{0};
+};
+
+int OpenListener(unsigned short port, bool allowRemote) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int enable = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(allowRemote ? INADDR_ANY : INADDR_LOOPBACK);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, 128) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+}
+
+int DCMTKTests::RunDicomWebServer(const std::string& path, const std::string& outputDir, unsigned short port,
+                                  unsigned int concurrency, unsigned int durationSeconds, bool allowRemote) {
+    std::cout << "--- [DCMTK] DICOMweb Server ---" << std::endl;
+    const fs::path stowRoot = fs::path(outputDir) / "dicomweb_stow";
+    std::vector<std::string> files;
+    // Earlier STOW-RS uploads are served again alongside the input series
+    for (const fs::path& root : {fs::is_directory(path) ? fs::path(path) : fs::path(path).parent_path(), stowRoot}) {
+        if (root.empty() || !fs::is_directory(root)) {
+            continue;
+        }
+        std::vector<fs::path> stale;
+        for (const auto& entry : fs::recursive_directory_iterator(root)) {
+            if (!entry.is_regular_file()) {
+                continue;
+            }
+            if (entry.path().extension() == ".dcm") {
+                files.push_back(entry.path().string());
+            } else if (root == stowRoot && entry.path().extension() == ".part") {
+                // Upload interrupted before it was validated and renamed
+                stale.push_back(entry.path());
+            }
+        }
+        std::error_code ec;
+        for (const fs::path& part : stale) {
+            fs::remove(part, ec);
+        }
+    }
+    std::vector<InstanceRecord> records(files.size());
+    std::vector<char> valid(files.size(), 0);
+    ParallelUtils::ParallelFor(files.size(), 0, [&](unsigned int, size_t i) {
+        valid[i] = ReadInstanceRecord(files[i], records[i]) ? 1 : 0;
+    });
+    Catalog catalog;
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (valid[i]) {
+            catalog.Add(records[i]);
+        }
+    }
+    std::cout << "Indexed " << catalog.Size() << " instances in " << catalog.Studies().size() << " studies." << std::endl;
+
+    const int listener = OpenListener(port, allowRemote);
+    if (listener < 0) {
+        std::cerr << "Cannot listen on " << (allowRemote ? "0.0.0.0:" : "127.0.0.1:") << port << ": "
+                  << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    DicomWebServer server(catalog, stowRoot, port);
+    const unsigned int workers = concurrency == 0 ? ParallelUtils::ResolveWorkerCount(16) : concurrency;
+    g_stopRequested = false;
+    auto previousInt = std::signal(SIGINT, HandleStopSignal);
+    // A client hanging up mid-response must not kill the server
+    auto previousPipe = std::signal(SIGPIPE, SIG_IGN);
+    std::cout << "Serving DICOMweb at http://127.0.0.1:" << port << "/studies (" << workers << " workers, "
+              << (durationSeconds > 0 ? std::to_string(durationSeconds) + " s" : "until Ctrl-C")
+              << (allowRemote ? ", all interfaces" : "") << ")" << std::endl;
+    {
+        WorkQueue<int> connections(workers * 4, workers, [&](int& fd) { server.Serve(fd); });
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(durationSeconds);
+        while (!g_stopRequested && (durationSeconds == 0 || std::chrono::steady_clock::now() < deadline)) {
+            pollfd waiter{listener, POLLIN, 0};
+            if (::poll(&waiter, 1, 1000) <= 0) {
+                continue;
+            }
+            const int client = ::accept(listener, nullptr, nullptr);
+            if (client < 0) {
+                continue;
+            }
+            // Idle keep-alive connections give their worker back after a few seconds
+            timeval timeout{5, 0};
+            ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            int noDelay = 1;
+            ::setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+            connections.Push(client);
+        }
+        g_stopRequested = true;
+    }
+    ::close(listener);
+    std::signal(SIGPIPE, previousPipe);
+    std::signal(SIGINT, previousInt);
+
+    std::cout << "Handled " << server.Requests() << " requests, " << server.FramesServed() << " frames; mapping cache "
+              << server.MappingHits() << " hits / " << server.MappingMisses() << " misses." << std::endl;
+    return 0;
+}
+
+#else
+namespace DCMTKTests {
+int RunDicomWebServer(const std::string&, const std::string&, unsigned short, unsigned int, unsigned int, bool) {
+    return 1;
+}
+} // namespace DCMTKTests
+#endif
@@ -9,23 +9,37 @@
 #include "GDCMFeatureActions.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <vector>
 #include <set>
 
+#include "utils/ImageMetrics.h"
+#include "utils/ParallelUtils.h"
+#include "utils/PixelHash.h"
+
 #ifdef USE_GDCM
 #include "gdcmAnonymizer.h"
 #include "gdcmAttribute.h"
+#include "gdcmBoxRegion.h"
 #include "gdcmDirectory.h"
 #include "gdcmDefs.h"
 #include "gdcmGlobal.h"
 #include "gdcmImageChangeTransferSyntax.h"
+#include "gdcmImageHelper.h"
 #include "gdcmImageReader.h"
+#include "gdcmImageRegionReader.h"
 #include "gdcmImageWriter.h"
+#include "gdcmJPEGLSCodec.h"
 #include "gdcmReader.h"
 #include "gdcmScanner.h"
 #include "gdcmStringFilter.h"
@@ -75,6 +89,157 @@ PixelStats CalculateStats(const std::vector<char>& buffer) {
     return stats;
 }
 
+bool CollectDicomFiles(const std::string& path, std::vector<std::string>& dicomFiles) {
+    // Resolve the scan root (a file selects its folder) and gather every .dcm underneath it
+    std::filesystem::path inputPath(path);
+    std::string searchRoot = std::filesystem::is_directory(inputPath) ? inputPath.string() : inputPath.parent_path().string();
+    if (searchRoot.empty() || !std::filesystem::exists(searchRoot)) {
+        std::cerr << "Cannot scan, path not found: " << searchRoot << std::endl;
+        return false;
+    }
+
+    gdcm::Directory dir;
+    dir.Load(searchRoot, true);
+    for (const auto& file : dir.GetFilenames()) {
+        if (std::filesystem::path(file).extension() == ".dcm") {
+            dicomFiles.push_back(file);
+        }
+    }
+
+    if (dicomFiles.empty()) {
+        std::cerr << "No DICOM files found under: " << searchRoot << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool HashFrames(const std::string& filename, std::vector<PixelHash::Hash128>& hashes, std::string& error,
+                unsigned int requestedWorkers = 0) {
+    // Decode one frame per request through ImageRegionReader so each worker only keeps a single frame resident
+    gdcm::ImageRegionReader probe;
+    probe.SetFileName(filename.c_str());
+    if (!probe.ReadInformation()) {
+        error = "could not read header of " + filename;
+        return false;
+    }
+
+    const std::vector<unsigned int> dims = gdcm::ImageHelper::GetDimensionsValue(probe.GetFile());
+    if (dims.size() < 3 || dims[0] == 0 || dims[1] == 0) {
+        error = "invalid image dimensions in " + filename;
+        return false;
+    }
+    const std::size_t frames = std::max(1u, dims[2]);
+    hashes.assign(frames, PixelHash::Hash128{});
+
+    // Every worker owns its reader and frame buffer; readers are not safe to share across threads
+    const unsigned int workers = ParallelUtils::ResolveWorkerCount(frames, requestedWorkers);
+    std::vector<std::unique_ptr<gdcm::ImageRegionReader>> readers(workers);
+    std::vector<std::vector<char>> buffers(workers);
+    std::atomic<bool> failed{false};
+
+    ParallelUtils::ParallelFor(frames, workers, [&](unsigned int worker, std::size_t frame) {
+        if (failed.load()) {
+            return;
+        }
+        auto& reader = readers[worker];
+        if (!reader) {
+            reader = std::make_unique<gdcm::ImageRegionReader>();
+            reader->SetFileName(filename.c_str());
+            if (!reader->ReadInformation()) {
+                failed.store(true);
+                return;
+            }
+        }
+
+        gdcm::BoxRegion box;
+        box.SetDomain(0, dims[0] - 1, 0, dims[1] - 1,
+                      static_cast<unsigned int>(frame), static_cast<unsigned int>(frame));
+        reader->SetRegion(box);
+        const std::size_t length = reader->ComputeBufferLength();
+        std::vector<char>& buffer = buffers[worker];
+        buffer.resize(length);
+        if (length == 0 || !reader->ReadIntoBuffer(buffer.data(), length)) {
+            failed.store(true);
+            return;
+        }
+        hashes[frame] = PixelHash::HashBuffer(buffer.data(), length);
+    });
+
+    if (failed.load()) {
+        error = "frame decode failed for " + filename;
+        return false;
+    }
+    return true;
+}
+
+bool VerifyLosslessRoundTrip(const std::string& sourceFile, const std::string& outputFile) {
+    return PixelHash::VerifyRoundTrip(sourceFile, outputFile,
+                                      [](const std::string& file, std::vector<PixelHash::Hash128>& hashes,
+                                         std::string& error) { return HashFrames(file, hashes, error); });
+}
+
+struct HashIndexEntry {
+    // One row of a previous gdcm_pixel_hashes.csv run, keyed by file path
+    std::string sopInstanceUID;
+    std::string instanceHash;
+};
+
+// Paths may contain commas or quotes, so the File column is quoted RFC 4180 style when needed
+std::string CSVField(const std::string& value) {
+    if (value.find_first_of(",\"\r\n") == std::string::npos) {
+        return value;
+    }
+    std::string quoted = "\"";
+    for (const char c : value) {
+        quoted += c == '"' ? std::string("\"\"") : std::string(1, c);
+    }
+    return quoted + "\"";
+}
+
+std::vector<std::string> SplitCSVRow(const std::string& line) {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); ++i) {
+        const char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                fields.back() += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                fields.back() += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else if (c != '\r') {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+std::map<std::string, HashIndexEntry> LoadHashIndex(const std::string& csvPath) {
+    // Parse File,SOPInstanceUID,...,InstanceHash rows written by TestPixelHashIndex; missing file means first run
+    std::map<std::string, HashIndexEntry> entries;
+    std::ifstream in(csvPath);
+    if (!in.is_open()) {
+        return entries;
+    }
+
+    std::string line;
+    std::getline(in, line); // header
+    while (std::getline(in, line)) {
+        const std::vector<std::string> fields = SplitCSVRow(line);
+        if (fields.size() >= 6 && !fields[5].empty()) {
+            entries[fields[0]] = {fields[1], fields[5]};
+        }
+    }
+    return entries;
+}
+
 template <typename T>
 bool WritePGMPreview(const gdcm::Image& image, const std::vector<char>& buffer, const std::string& outPath) {
     // Create a simple 8-bit preview from the first channel of the volume
@@ -269,7 +434,7 @@ void GDCMTests::TestDatasetDump(const std::string& filename, const std::string&
     std::cout << "Wrote verbose dataset dump to: " << outFilename << std::endl;
 }
 
-void GDCMTests::TestJPEG2000Transcode(const std::string& filename, const std::string& outputDir) {
+bool GDCMTests::TestJPEG2000Transcode(const std::string& filename, const std::string& outputDir, bool verify) {
     // Lossless JPEG2000 round-trip to exercise J2K codec support
     std::cout << "--- [GDCM] JPEG2000 Lossless Transcode ---" << std::endl;
 
@@ -277,7 +442,7 @@ void GDCMTests::TestJPEG2000Transcode(const std::string& filename, const std::st
     reader.SetFileName(filename.c_str());
     if (!reader.Read()) {
         std::cerr << "Could not read file for JPEG2000 transcode." << std::endl;
-        return;
+        return false;
     }
 
     gdcm::ImageChangeTransferSyntax change;
@@ -286,7 +451,7 @@ void GDCMTests::TestJPEG2000Transcode(const std::string& filename, const std::st
 
     if (!change.Change()) {
         std::cerr << "Transfer syntax change to JPEG2000 failed (codec support may be missing)." << std::endl;
-        return;
+        return false;
     }
 
     gdcm::ImageWriter writer;
@@ -297,12 +462,14 @@ void GDCMTests::TestJPEG2000Transcode(const std::string& filename, const std::st
 
     if (writer.Write()) {
         std::cout << "Transcoded to JPEG2000 and saved to: " << outFilename << std::endl;
+        return !verify || VerifyLosslessRoundTrip(filename, outFilename);
     } else {
         std::cerr << "Failed to write JPEG2000 transcoded file." << std::endl;
+        return false;
     }
 }
 
-void GDCMTests::TestJPEGLSTranscode(const std::string& filename, const std::string& outputDir) {
+bool GDCMTests::TestJPEGLSTranscode(const std::string& filename, const std::string& outputDir, bool verify) {
     // Lossless JPEG-LS round-trip to validate codec availability
     std::cout << "--- [GDCM] JPEG-LS Lossless Transcode ---" << std::endl;
 
@@ -310,7 +477,7 @@ void GDCMTests::TestJPEGLSTranscode(const std::string& filename, const std::stri
     reader.SetFileName(filename.c_str());
     if (!reader.Read()) {
         std::cerr << "Could not read file for JPEG-LS transcode." << std::endl;
-        return;
+        return false;
     }
 
     gdcm::ImageChangeTransferSyntax change;
@@ -319,7 +486,7 @@ void GDCMTests::TestJPEGLSTranscode(const std::string& filename, const std::stri
 
     if (!change.Change()) {
         std::cerr << "Transfer syntax change to JPEG-LS failed (codec support may be missing)." << std::endl;
-        return;
+        return false;
     }
 
     gdcm::ImageWriter writer;
@@ -330,12 +497,145 @@ void GDCMTests::TestJPEGLSTranscode(const std::string& filename, const std::stri
 
     if (writer.Write()) {
         std::cout << "Transcoded to JPEG-LS and saved to: " << outFilename << std::endl;
+        return !verify || VerifyLosslessRoundTrip(filename, outFilename);
     } else {
         std::cerr << "Failed to write JPEG-LS transcoded file." << std::endl;
+        return false;
+    }
+}
+
+void GDCMTests::TestJPEGLSNearLosslessSweep(const std::string& filename, const std::string& outputDir) {
+    // Encodes JPEG-LS at every NEAR tolerance from 0 to 10 in parallel and scores each decode against the stored source values
+    std::cout << "--- [GDCM] JPEG-LS Near-Lossless Sweep ---" << std::endl;
+
+    gdcm::ImageReader reader;
+    reader.SetFileName(filename.c_str());
+    if (!reader.Read()) {
+        std::cerr << "Could not read file for JPEG-LS sweep." << std::endl;
+        return;
+    }
+    const gdcm::Image& source = reader.GetImage();
+    const gdcm::PixelFormat& pf = source.GetPixelFormat();
+    const gdcm::PixelFormat::ScalarType scalar = pf.GetScalarType();
+    if (scalar != gdcm::PixelFormat::UINT8 && scalar != gdcm::PixelFormat::INT8 &&
+        scalar != gdcm::PixelFormat::UINT16 && scalar != gdcm::PixelFormat::INT16) {
+        std::cerr << "JPEG-LS sweep supports 8/16-bit integer pixels only." << std::endl;
+        return;
+    }
+
+    std::vector<char> referenceBuffer(source.GetBufferLength());
+    if (referenceBuffer.empty() || !source.GetBuffer(referenceBuffer.data())) {
+        std::cerr << "Failed to decode source pixels for JPEG-LS sweep." << std::endl;
+        return;
+    }
+    const unsigned int width = source.GetDimension(0) * pf.GetSamplesPerPixel();
+    const unsigned int height = source.GetDimension(1);
+    const unsigned int frames = source.GetNumberOfDimensions() > 2 ? std::max(1u, source.GetDimension(2)) : 1u;
+    const size_t frameBytes = static_cast<size_t>(width) * height * pf.GetPixelSize() / pf.GetSamplesPerPixel();
+
+    // NEAR=0 is the lossless anchor for the table; NEAR bounds the per-sample error, which MaxAbsError confirms
+    const std::vector<int> nearValues = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    struct SweepResult {
+        bool ok{false};
+        std::uintmax_t bytes{0};
+        ImageMetrics::ErrorStats stats;
+    };
+    std::vector<SweepResult> results(nearValues.size());
+    std::filesystem::path sweepDir = std::filesystem::path(outputDir) / "gdcm_jpegls_sweep";
+    std::error_code ec;
+    std::filesystem::create_directories(sweepDir, ec);
+
+    std::mutex logMutex;
+    ParallelUtils::ParallelFor(nearValues.size(), 0, [&](unsigned int, size_t i) {
+        // Readers and codecs are per worker; GDCM objects are not shared across threads
+        gdcm::ImageReader localReader;
+        localReader.SetFileName(filename.c_str());
+        gdcm::JPEGLSCodec codec;
+        codec.SetLossless(nearValues[i] == 0);
+        codec.SetLossyError(nearValues[i]);
+        gdcm::ImageChangeTransferSyntax change;
+        change.SetTransferSyntax(nearValues[i] == 0 ? gdcm::TransferSyntax::JPEGLSLossless : gdcm::TransferSyntax::JPEGLSNearLossless);
+        change.SetUserCodec(&codec);
+        if (!localReader.Read()) {
+            std::lock_guard<std::mutex> lock(logMutex);
+            std::cerr << "  NEAR " << nearValues[i] << ": could not read source" << std::endl;
+            return;
+        }
+        change.SetInput(localReader.GetImage());
+        if (!change.Change()) {
+            std::lock_guard<std::mutex> lock(logMutex);
+            std::cerr << "  NEAR " << nearValues[i] << ": encode failed (JPEG-LS codec missing?)" << std::endl;
+            return;
+        }
+
+        const std::string outFile = (sweepDir / ("near" + std::to_string(nearValues[i]) + ".dcm")).string();
+        gdcm::ImageWriter writer;
+        writer.SetFileName(outFile.c_str());
+        writer.SetFile(localReader.GetFile());
+        writer.SetImage(change.GetOutput());
+        if (!writer.Write()) {
+            std::lock_guard<std::mutex> lock(logMutex);
+            std::cerr << "  NEAR " << nearValues[i] << ": failed to write " << outFile << std::endl;
+            return;
+        }
+
+        // GetBuffer on the transcoded image runs the JPEG-LS decoder over the new stream
+        std::vector<char> decoded(change.GetOutput().GetBufferLength());
+        if (decoded.size() != referenceBuffer.size() || !change.GetOutput().GetBuffer(decoded.data())) {
+            std::lock_guard<std::mutex> lock(logMutex);
+            std::cerr << "  NEAR " << nearValues[i] << ": decode failed" << std::endl;
+            return;
+        }
+
+        ImageMetrics::Accumulator accumulator(static_cast<double>((1u << pf.GetBitsStored()) - 1));
+        for (unsigned int frame = 0; frame < frames; ++frame) {
+            const char* ref = referenceBuffer.data() + frame * frameBytes;
+            const char* out = decoded.data() + frame * frameBytes;
+            switch (scalar) {
+                case gdcm::PixelFormat::UINT8:
+                    accumulator.AddPlane(reinterpret_cast<const uint8_t*>(ref), reinterpret_cast<const uint8_t*>(out), width, height);
+                    break;
+                case gdcm::PixelFormat::INT8:
+                    accumulator.AddPlane(reinterpret_cast<const int8_t*>(ref), reinterpret_cast<const int8_t*>(out), width, height);
+                    break;
+                case gdcm::PixelFormat::UINT16:
+                    accumulator.AddPlane(reinterpret_cast<const uint16_t*>(ref), reinterpret_cast<const uint16_t*>(out), width, height);
+                    break;
+                default:
+                    accumulator.AddPlane(reinterpret_cast<const int16_t*>(ref), reinterpret_cast<const int16_t*>(out), width, height);
+                    break;
+            }
+        }
+        results[i].stats = accumulator.Result();
+        results[i].bytes = std::filesystem::file_size(outFile, ec);
+        results[i].ok = true;
+    });
+
+    const double pixels = static_cast<double>(source.GetDimension(0)) * height * frames;
+    std::string csvPath = JoinPath(outputDir, "gdcm_jpegls_sweep.csv");
+    std::ofstream csv(csvPath);
+    csv << "Codec,Setting,Bytes,BitsPerPixel,PSNR_dB,MaxAbsError,SSIM,Space\n";
+    // Format rows in a local stream so the precision/alignment flags do not leak into later std::cout output
+    std::ostringstream table;
+    table << std::left << std::fixed << std::setw(8) << "NEAR" << std::setw(12) << "Bytes" << std::setw(8) << "bpp"
+          << std::setw(10) << "PSNR" << std::setw(8) << "MaxErr" << "SSIM" << "\n";
+    for (size_t i = 0; i < nearValues.size(); ++i) {
+        if (!results[i].ok) {
+            continue;
+        }
+        const auto& r = results[i];
+        const double bpp = pixels > 0 ? (static_cast<double>(r.bytes) * 8.0) / pixels : 0.0;
+        csv << "JPEG-LS," << nearValues[i] << "," << r.bytes << "," << bpp << "," << r.stats.psnr << ","
+            << r.stats.maxAbsError << "," << r.stats.ssim << ",stored\n";
+        table << std::setw(8) << nearValues[i] << std::setw(12) << r.bytes << std::setprecision(3) << std::setw(8) << bpp
+              << std::setprecision(2) << std::setw(10) << r.stats.psnr << std::setprecision(0) << std::setw(8)
+              << r.stats.maxAbsError << std::setprecision(4) << r.stats.ssim << "\n";
     }
+    std::cout << table.str();
+    std::cout << "Rate-distortion table written to " << csvPath << std::endl;
 }
 
-void GDCMTests::TestRLETranscode(const std::string& filename, const std::string& outputDir) {
+bool GDCMTests::TestRLETranscode(const std::string& filename, const std::string& outputDir, bool verify) {
     // Convert to RLE Lossless to confirm encapsulated encoding works
     std::cout << "--- [GDCM] RLE Lossless Transcode ---" << std::endl;
 
@@ -343,7 +643,7 @@ void GDCMTests::TestRLETranscode(const std::string& filename, const std::string&
     reader.SetFileName(filename.c_str());
     if (!reader.Read()) {
         std::cerr << "Could not read file for RLE transcode." << std::endl;
-        return;
+        return false;
     }
 
     gdcm::ImageChangeTransferSyntax change;
@@ -352,7 +652,7 @@ void GDCMTests::TestRLETranscode(const std::string& filename, const std::string&
 
     if (!change.Change()) {
         std::cerr << "Transfer syntax change to RLE failed (codec support may be missing)." << std::endl;
-        return;
+        return false;
     }
 
     gdcm::ImageWriter writer;
@@ -363,8 +663,10 @@ void GDCMTests::TestRLETranscode(const std::string& filename, const std::string&
 
     if (writer.Write()) {
         std::cout << "Transcoded to RLE and saved to: " << outFilename << std::endl;
+        return !verify || VerifyLosslessRoundTrip(filename, outFilename);
     } else {
         std::cerr << "Failed to write RLE transcoded file." << std::endl;
+        return false;
     }
 }
 
@@ -437,24 +739,8 @@ void GDCMTests::TestDirectoryScan(const std::string& path, const std::string& ou
     // Recursively index DICOM files and emit a CSV catalog of series
     std::cout << "--- [GDCM] Series Scan ---" << std::endl;
 
-    std::filesystem::path inputPath(path);
-    std::string searchRoot = std::filesystem::is_directory(inputPath) ? inputPath.string() : inputPath.parent_path().string();
-    if (searchRoot.empty() || !std::filesystem::exists(searchRoot)) {
-        std::cerr << "Cannot scan, path not found: " << searchRoot << std::endl;
-        return;
-    }
-
-    gdcm::Directory dir;
-    dir.Load(searchRoot, true);
     std::vector<std::string> dicomFiles;
-    for (const auto& file : dir.GetFilenames()) {
-        if (std::filesystem::path(file).extension() == ".dcm") {
-            dicomFiles.push_back(file);
-        }
-    }
-
-    if (dicomFiles.empty()) {
-        std::cerr << "No DICOM files found under: " << searchRoot << std::endl;
+    if (!CollectDicomFiles(path, dicomFiles)) {
         return;
     }
 
@@ -509,6 +795,184 @@ void GDCMTests::TestDirectoryScan(const std::string& path, const std::string& ou
               << " series. CSV saved to: " << outPath << std::endl;
 }
 
+void GDCMTests::TestPixelHashIndex(const std::string& path, const std::string& outputDir) {
+    // Hash decoded pixels of every instance under the scan root, then report duplicates and bit-rot
+    std::cout << "--- [GDCM] Pixel Hash Index ---" << std::endl;
+
+    std::vector<std::string> dicomFiles;
+    if (!CollectDicomFiles(path, dicomFiles)) {
+        return;
+    }
+
+    const gdcm::Tag sopTag(0x0008, 0x0018);
+    const gdcm::Tag studyTag(0x0020, 0x000D);
+    const gdcm::Tag seriesTag(0x0020, 0x000E);
+    gdcm::Scanner scanner;
+    scanner.AddTag(sopTag);
+    scanner.AddTag(studyTag);
+    scanner.AddTag(seriesTag);
+    if (!scanner.Scan(dicomFiles)) {
+        std::cerr << "Scanner failed to read metadata." << std::endl;
+        return;
+    }
+
+    struct InstanceRecord {
+        std::string file;
+        std::string sopInstanceUID;
+        std::string studyInstanceUID;
+        std::string seriesInstanceUID;
+        std::vector<PixelHash::Hash128> frameHashes;
+        PixelHash::Hash128 instanceHash;
+        bool decoded{false};
+        std::string error;
+    };
+
+    std::vector<InstanceRecord> records(dicomFiles.size());
+    for (std::size_t i = 0; i < dicomFiles.size(); ++i) {
+        auto fetch = [&](const gdcm::Tag& tag) -> std::string {
+            const char* val = scanner.GetValue(dicomFiles[i].c_str(), tag);
+            return val ? val : "";
+        };
+        records[i].file = dicomFiles[i];
+        records[i].sopInstanceUID = fetch(sopTag);
+        records[i].studyInstanceUID = fetch(studyTag);
+        records[i].seriesInstanceUID = fetch(seriesTag);
+    }
+
+    // Files are the unit of parallelism; frames inside a file decode serially to avoid nested pools
+    ParallelUtils::ParallelFor(records.size(), 0, [&](unsigned int, std::size_t i) {
+        InstanceRecord& record = records[i];
+        record.decoded = HashFrames(record.file, record.frameHashes, record.error, 1);
+        if (record.decoded) {
+            // Instance digest chains the frame digests, so it is independent of the transfer syntax too
+            PixelHash::Hasher hasher;
+            for (const auto& frame : record.frameHashes) {
+                hasher.Update(&frame.low, sizeof(frame.low));
+                hasher.Update(&frame.high, sizeof(frame.high));
+            }
+            record.instanceHash = hasher.Finalize();
+        }
+    });
+
+    // Read the previous run before overwriting it so changed pixels can be detected
+    const std::string indexPath = JoinPath(outputDir, "gdcm_pixel_hashes.csv");
+    const std::map<std::string, HashIndexEntry> previous = LoadHashIndex(indexPath);
+
+    std::ofstream out(indexPath, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Failed to open output CSV at: " << indexPath << std::endl;
+        return;
+    }
+    out << "File,SOPInstanceUID,StudyInstanceUID,SeriesInstanceUID,Frames,InstanceHash,FrameHashes\n";
+    for (const auto& record : records) {
+        out << CSVField(record.file) << "," << record.sopInstanceUID << "," << record.studyInstanceUID << ","
+            << record.seriesInstanceUID << "," << record.frameHashes.size() << ",";
+        if (record.decoded) {
+            out << PixelHash::ToHex(record.instanceHash) << ",";
+            for (std::size_t f = 0; f < record.frameHashes.size(); ++f) {
+                out << (f ? ";" : "") << PixelHash::ToHex(record.frameHashes[f]);
+            }
+        } else {
+            out << ",";
+        }
+        out << "\n";
+    }
+    out.close();
+
+    // Group by SOP UID and by pixel payload to surface the two kinds of duplicates
+    std::map<std::string, std::vector<const InstanceRecord*>> bySop;
+    std::map<PixelHash::Hash128, std::vector<const InstanceRecord*>> byPayload;
+    std::set<std::string> seenFiles;
+    for (const auto& record : records) {
+        seenFiles.insert(record.file);
+        if (!record.sopInstanceUID.empty()) {
+            bySop[record.sopInstanceUID].push_back(&record);
+        }
+        if (record.decoded) {
+            byPayload[record.instanceHash].push_back(&record);
+        }
+    }
+
+    const std::string reportPath = JoinPath(outputDir, "gdcm_pixel_hash_report.txt");
+    std::ofstream report(reportPath, std::ios::out | std::ios::trunc);
+    if (!report.is_open()) {
+        std::cerr << "Failed to open hash report at: " << reportPath << std::endl;
+        return;
+    }
+
+    std::size_t duplicateSops = 0;
+    report << "[Duplicate SOP Instance UIDs]\n";
+    for (const auto& [sop, instances] : bySop) {
+        if (instances.size() < 2) {
+            continue;
+        }
+        ++duplicateSops;
+        report << sop << "\n";
+        for (const InstanceRecord* record : instances) {
+            report << "  " << record->file << " "
+                   << (record->decoded ? PixelHash::ToHex(record->instanceHash) : std::string("(decode failed)")) << "\n";
+        }
+    }
+
+    std::size_t duplicatePayloads = 0;
+    report << "\n[Identical pixel data under different SOP Instance UIDs]\n";
+    for (const auto& [hash, instances] : byPayload) {
+        std::set<std::string> uids;
+        for (const InstanceRecord* record : instances) {
+            uids.insert(record->sopInstanceUID);
+        }
+        if (uids.size() < 2) {
+            continue;
+        }
+        ++duplicatePayloads;
+        report << PixelHash::ToHex(hash) << "\n";
+        for (const InstanceRecord* record : instances) {
+            report << "  " << record->file << " " << record->sopInstanceUID << "\n";
+        }
+    }
+
+    std::size_t changed = 0;
+    std::size_t missing = 0;
+    report << "\n[Changes since previous run]\n";
+    if (previous.empty()) {
+        report << "(no previous index found)\n";
+    }
+    for (const auto& record : records) {
+        auto it = previous.find(record.file);
+        if (it == previous.end() || it->second.sopInstanceUID != record.sopInstanceUID) {
+            continue;
+        }
+        const std::string current = record.decoded ? PixelHash::ToHex(record.instanceHash) : std::string();
+        if (current != it->second.instanceHash) {
+            ++changed;
+            report << "PIXELS CHANGED " << record.file << " " << it->second.instanceHash << " -> "
+                   << (current.empty() ? "(decode failed)" : current) << "\n";
+        }
+    }
+    for (const auto& [file, entry] : previous) {
+        if (seenFiles.count(file) == 0) {
+            ++missing;
+            report << "MISSING " << file << " " << entry.sopInstanceUID << "\n";
+        }
+    }
+
+    std::size_t failures = 0;
+    report << "\n[Decode failures]\n";
+    for (const auto& record : records) {
+        if (!record.decoded) {
+            ++failures;
+            report << record.file << ": " << record.error << "\n";
+        }
+    }
+    report.close();
+
+    std::cout << "Hashed " << records.size() << " instances (" << failures << " decode failures). "
+              << duplicateSops << " duplicate SOP UIDs, " << duplicatePayloads << " duplicate payloads, "
+              << changed << " changed and " << missing << " missing since last run." << std::endl;
+    std::cout << "Index: " << indexPath << std::endl;
+    std::cout << "Report: " << reportPath << std::endl;
+}
+
 void GDCMTests::TestPreviewExport(const std::string& filename, const std::string& outputDir) {
     // Convert the first slice to an 8-bit PGM preview for quick visualization
     std::cout << "--- [GDCM] Preview Export (PGM) ---" << std::endl;
@@ -568,11 +1032,13 @@ void TestAnonymization(const std::string&, const std::string&) {}
 void TestDecompression(const std::string&, const std::string&) {}
 void TestUIDRewrite(const std::string&, const std::string&) {}
 void TestDatasetDump(const std::string&, const std::string&) {}
-void TestJPEG2000Transcode(const std::string&, const std::string&) {}
-void TestRLETranscode(const std::string&, const std::string&) {}
+bool TestJPEG2000Transcode(const std::string&, const std::string&, bool) { return false; }
+bool TestRLETranscode(const std::string&, const std::string&, bool) { return false; }
 void TestPixelStatistics(const std::string&, const std::string&) {}
-void TestJPEGLSTranscode(const std::string&, const std::string&) {}
+bool TestJPEGLSTranscode(const std::string&, const std::string&, bool) { return false; }
 void TestDirectoryScan(const std::string&, const std::string&) {}
+void TestPixelHashIndex(const std::string&, const std::string&) {}
+void TestJPEGLSNearLosslessSweep(const std::string&, const std::string&) {}
 void TestPreviewExport(const std::string&, const std::string&) {}
 } // namespace GDCMTests
 #endif
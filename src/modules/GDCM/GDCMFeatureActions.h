@@ -11,16 +11,19 @@
 #include <string>
 
 namespace GDCMTests {
-    // Self-contained demonstrations of core GDCM capabilities
+    // Self-contained demonstrations of core GDCM capabilities; lossless transcodes can re-verify decoded pixels and
+    // return false when the output could not be written or the verification found a difference
     void TestTagInspection(const std::string& filename, const std::string& outputDir);
     void TestAnonymization(const std::string& filename, const std::string& outputDir);
     void TestDecompression(const std::string& filename, const std::string& outputDir);
     void TestUIDRewrite(const std::string& filename, const std::string& outputDir);
     void TestDatasetDump(const std::string& filename, const std::string& outputDir);
-    void TestJPEG2000Transcode(const std::string& filename, const std::string& outputDir);
-    void TestRLETranscode(const std::string& filename, const std::string& outputDir);
+    bool TestJPEG2000Transcode(const std::string& filename, const std::string& outputDir, bool verify = false);
+    bool TestRLETranscode(const std::string& filename, const std::string& outputDir, bool verify = false);
     void TestPixelStatistics(const std::string& filename, const std::string& outputDir);
-    void TestJPEGLSTranscode(const std::string& filename, const std::string& outputDir);
+    bool TestJPEGLSTranscode(const std::string& filename, const std::string& outputDir, bool verify = false);
+    void TestJPEGLSNearLosslessSweep(const std::string& filename, const std::string& outputDir);
     void TestDirectoryScan(const std::string& path, const std::string& outputDir);
+    void TestPixelHashIndex(const std::string& path, const std::string& outputDir);
     void TestPreviewExport(const std::string& filename, const std::string& outputDir);
 }
@@ -25,13 +25,15 @@ void GDCMTests::RegisterCommands(CommandRegistry& registry) {
             TestDecompression(ctx.inputPath, ctx.outputDir);
             TestUIDRewrite(ctx.inputPath, ctx.outputDir);
             TestDatasetDump(ctx.inputPath, ctx.outputDir);
-            TestJPEG2000Transcode(ctx.inputPath, ctx.outputDir);
-            TestRLETranscode(ctx.inputPath, ctx.outputDir);
-            TestJPEGLSTranscode(ctx.inputPath, ctx.outputDir);
+            bool transcoded = TestJPEG2000Transcode(ctx.inputPath, ctx.outputDir, ctx.verify);
+            transcoded = TestRLETranscode(ctx.inputPath, ctx.outputDir, ctx.verify) && transcoded;
+            transcoded = TestJPEGLSTranscode(ctx.inputPath, ctx.outputDir, ctx.verify) && transcoded;
             TestPixelStatistics(ctx.inputPath, ctx.outputDir);
             TestDirectoryScan(ctx.inputPath, ctx.outputDir);
+            TestPixelHashIndex(ctx.inputPath, ctx.outputDir);
             TestPreviewExport(ctx.inputPath, ctx.outputDir);
-            return 0;
+            // Without --verify the suite stays best-effort; with it a failed round-trip fails the run
+            return ctx.verify && !transcoded ? 1 : 0;
         }
     });
 
@@ -60,8 +62,7 @@ void GDCMTests::RegisterCommands(CommandRegistry& registry) {
         "GDCM",
         "Transcode to JPEG2000 (lossless) to validate codec support",
         [](const CommandContext& ctx) {
-            TestJPEG2000Transcode(ctx.inputPath, ctx.outputDir);
-            return 0;
+            return TestJPEG2000Transcode(ctx.inputPath, ctx.outputDir, ctx.verify) ? 0 : 1;
         }
     });
 
@@ -70,7 +71,16 @@ void GDCMTests::RegisterCommands(CommandRegistry& registry) {
         "GDCM",
         "Transcode to JPEG-LS Lossless to validate codec support",
         [](const CommandContext& ctx) {
-            TestJPEGLSTranscode(ctx.inputPath, ctx.outputDir);
+            return TestJPEGLSTranscode(ctx.inputPath, ctx.outputDir, ctx.verify) ? 0 : 1;
+        }
+    });
+
+    registry.Register({
+        "gdcm:jpegls-sweep",
+        "GDCM",
+        "Encode JPEG-LS at NEAR 0-10 and tabulate PSNR/MaxErr/SSIM vs size",
+        [](const CommandContext& ctx) {
+            TestJPEGLSNearLosslessSweep(ctx.inputPath, ctx.outputDir);
             return 0;
         }
     });
@@ -100,8 +110,7 @@ void GDCMTests::RegisterCommands(CommandRegistry& registry) {
         "GDCM",
         "Transcode to RLE Lossless for encapsulated transfer syntax validation",
         [](const CommandContext& ctx) {
-            TestRLETranscode(ctx.inputPath, ctx.outputDir);
-            return 0;
+            return TestRLETranscode(ctx.inputPath, ctx.outputDir, ctx.verify) ? 0 : 1;
         }
     });
 
@@ -125,6 +134,16 @@ void GDCMTests::RegisterCommands(CommandRegistry& registry) {
         }
     });
 
+    registry.Register({
+        "gdcm:hash-index",
+        "GDCM",
+        "Hash decoded pixels per frame/instance and report duplicates and bit-rot",
+        [](const CommandContext& ctx) {
+            TestPixelHashIndex(ctx.inputPath, ctx.outputDir);
+            return 0;
+        }
+    });
+
     registry.Register({
         "gdcm:preview",
         "GDCM",
@@ -8,20 +8,64 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 namespace ITKTests {
+    // Time every ITK stage at 1, 2, 4, ... maxThreads (0 = all cores) and write speedup/efficiency to a report
+    void RunScalingBenchmark(const std::string& filename, const std::string& outputDir, unsigned int maxThreads);
+    // Time the three Gaussian engines at sigma 1-5 mm and report their difference from the discrete kernel
+    void RunGaussianBenchmark(const std::string& filename, const std::string& outputDir);
+    // Time both median engines at radius 1-5 and count voxels where they disagree
+    void RunMedianBenchmark(const std::string& filename, const std::string& outputDir);
+    // Time the ITK and separable resamplers per kernel and report their difference where both have input
+    void RunResampleBenchmark(const std::string& filename, const std::string& outputDir);
+    // Time ITK's equalizer on the middle slice against tiled CLAHE on that slice and on the whole volume
+    void RunEqualizeBenchmark(const std::string& filename, const std::string& outputDir);
+    // Time axial max/mean cine stacks at 5-20 mm against ITK projecting each slab on its own
+    void RunSlabBenchmark(const std::string& filename, const std::string& outputDir);
+    // Time ITK's binary dilate/erode (radius 1-3) and fill-hole filters against the packed engine on an Otsu mask,
+    // counting mismatched voxels, and the Maurer distance map against the exact EDT over background voxels
+    void RunMorphologyBenchmark(const std::string& filename, const std::string& outputDir);
+    // Decode the input once and run every demo below over it, writing outputs in the background
+    void RunITKSession(const std::string& filename, const std::string& outputDir);
     // Individual ITK processing demos exposed as CLI commands
     void TestCannyEdgeDetection(const std::string& filename, const std::string& outputDir);
-    void TestGaussianSmoothing(const std::string& filename, const std::string& outputDir);
+    // engine: discrete (ITK kernel), recursive (ITK IIR) or separable (in-house SIMD FIR); sigma in mm
+    void TestGaussianSmoothing(const std::string& filename, const std::string& outputDir,
+                               const std::string& engine = "discrete", double sigma = 1.0);
     void TestBinaryThresholding(const std::string& filename, const std::string& outputDir);
-    void TestResampling(const std::string& filename, const std::string& outputDir);
-    void TestAdaptiveHistogram(const std::string& filename, const std::string& outputDir);
+    // engine: separable (in-house per-axis tables) or itk (ResampleImageFilter); interpolation: linear, bspline, lanczos
+    void TestResampling(const std::string& filename, const std::string& outputDir, const std::string& engine = "separable",
+                        const std::string& interpolation = "linear", bool antialias = false);
+    // engine: clahe2d / clahe3d (in-house tiled CLAHE per slice or in 3-D tiles) or itk (per-voxel neighbourhood
+    // histograms); tiles and clipLimit apply to CLAHE, alpha to ITK, beta (input blended back in) to both
+    void TestAdaptiveHistogram(const std::string& filename, const std::string& outputDir,
+                               const std::string& engine = "clahe2d", unsigned int tiles = 8, double clipLimit = 2.0,
+                               double alpha = 0.3, double beta = 0.3);
     void TestSliceExtraction(const std::string& filename, const std::string& outputDir);
-    void TestMedianFilter(const std::string& filename, const std::string& outputDir);
+    // engine: histogram (in-house sliding histogram) or itk (MedianImageFilter); radius in voxels
+    void TestMedianFilter(const std::string& filename, const std::string& outputDir,
+                          const std::string& engine = "histogram", unsigned int radius = 1);
     void TestNRRDExport(const std::string& filename, const std::string& outputDir);
     void TestOtsuSegmentation(const std::string& filename, const std::string& outputDir);
-    void TestAnisotropicDenoise(const std::string& filename, const std::string& outputDir);
+    // Label the nonzero voxels of a mask (6/18/26-connected), largest first, dropping components under minVoxels.
+    // Writes the label image (NRRD) and per-label size, bounds, centroid and intensity stats (CSV, JSON); the
+    // intensities come from intensityPath when given, else from the mask
+    void TestConnectedComponents(const std::string& filename, const std::string& outputDir,
+                                 const std::string& intensityPath = "", unsigned int connectivity = 6,
+                                 std::uint64_t minVoxels = 0);
+    // operation: dilate, erode, open, close (ball of radius voxels), fill (holes) or distance (signed EDT in mm,
+    // written as NRRD). Any nonzero voxel is foreground; morphology results keep the mask's value and go to DICOM
+    void TestMaskMorphology(const std::string& filename, const std::string& outputDir,
+                            const std::string& operation = "dilate", unsigned int radius = 1);
+    // precision: fp32 (ITK filter, in place) or fp16 (in-house port with a half-float working volume)
+    void TestAnisotropicDenoise(const std::string& filename, const std::string& outputDir,
+                                const std::string& precision = "fp32");
     void TestMaximumIntensityProjection(const std::string& filename, const std::string& outputDir);
+    // Stack of slab projections (max, min, mean, sum) along x, y, z or an oblique "dx,dy,dz" axis, written as NRRD.
+    // thicknessMm 0 projects the whole depth; stepMm 0 starts a slab at every sample (cine)
+    void TestSlabProjection(const std::string& filename, const std::string& outputDir, const std::string& projection = "max",
+                            const std::string& axis = "z", double thicknessMm = 0.0, double stepMm = 0.0);
     void TestNiftiExport(const std::string& filename, const std::string& outputDir);
 }
@@ -0,0 +1,286 @@
+//
+// ITKSeriesLoader.cpp
+// DicomToolsCpp
+//
+// Implements the parallel series loader: GDCM-sorted file list, one header pass per slice, and direct decode into the volume.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#include "ITKSeriesLoader.h"
+
+#ifdef USE_ITK
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+#include "itkGDCMSeriesFileNames.h"
+#include "itkImageFileReader.h"
+#include "itkMultiThreaderBase.h"
+
+#include "utils/ParallelUtils.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+// Gaps may differ from the mean by this fraction before the series is reported as non-uniform
+constexpr double kSpacingTolerance = 0.01;
+
+// Clamp into the volume's 16-bit range; narrower types convert directly
+template <typename T>
+void ConvertSlice(const void* source, ITKTests::VolumePixelType* target, std::size_t count) {
+    const T* input = static_cast<const T*>(source);
+    using Limits = std::numeric_limits<ITKTests::VolumePixelType>;
+    if constexpr (std::is_integral_v<T> && sizeof(T) < sizeof(ITKTests::VolumePixelType)) {
+        std::copy(input, input + count, target);
+    } else {
+        for (std::size_t i = 0; i < count; ++i) {
+            const double value = std::clamp(static_cast<double>(input[i]), static_cast<double>(Limits::min()),
+                                            static_cast<double>(Limits::max()));
+            target[i] = static_cast<ITKTests::VolumePixelType>(std::nearbyint(value));
+        }
+    }
+}
+
+bool ConvertToVolume(itk::IOComponentEnum type, const void* source, ITKTests::VolumePixelType* target, std::size_t count) {
+    switch (type) {
+        case itk::IOComponentEnum::UCHAR: ConvertSlice<unsigned char>(source, target, count); return true;
+        case itk::IOComponentEnum::CHAR: ConvertSlice<signed char>(source, target, count); return true;
+        case itk::IOComponentEnum::USHORT: ConvertSlice<unsigned short>(source, target, count); return true;
+        case itk::IOComponentEnum::SHORT: ConvertSlice<short>(source, target, count); return true;
+        case itk::IOComponentEnum::UINT: ConvertSlice<unsigned int>(source, target, count); return true;
+        case itk::IOComponentEnum::INT: ConvertSlice<int>(source, target, count); return true;
+        case itk::IOComponentEnum::ULONG: ConvertSlice<unsigned long>(source, target, count); return true;
+        case itk::IOComponentEnum::LONG: ConvertSlice<long>(source, target, count); return true;
+        case itk::IOComponentEnum::ULONGLONG: ConvertSlice<unsigned long long>(source, target, count); return true;
+        case itk::IOComponentEnum::LONGLONG: ConvertSlice<long long>(source, target, count); return true;
+        case itk::IOComponentEnum::FLOAT: ConvertSlice<float>(source, target, count); return true;
+        case itk::IOComponentEnum::DOUBLE: ConvertSlice<double>(source, target, count); return true;
+        default: return false;
+    }
+}
+
+bool LoadSingleFile(const std::string& filename, ITKTests::LoadedVolume& volume) {
+    // Single files (including multi-frame) go through the stock reader, which already handles every pixel layout
+    using ReaderType = itk::ImageFileReader<ITKTests::VolumeImageType>;
+    ReaderType::Pointer reader = ReaderType::New();
+    itk::GDCMImageIO::Pointer gdcmIO = itk::GDCMImageIO::New();
+    reader->SetFileName(filename);
+    reader->SetImageIO(gdcmIO);
+    try {
+        reader->Update();
+    } catch (itk::ExceptionObject& err) {
+        std::cerr << "ITK Exception: " << err << std::endl;
+        return false;
+    }
+    volume.image = reader->GetOutput();
+    volume.image->DisconnectPipeline();
+    volume.io = gdcmIO;
+    volume.slices = volume.image->GetLargestPossibleRegion().GetSize()[2];
+    volume.spacingDeviation = 0.0;
+    return true;
+}
+} // namespace
+
+bool ITKTests::FindLargestSeries(const std::string& directory, std::vector<std::string>& files) {
+    // GDCM groups files by series and orders each group along the slice normal by Image Position (Patient)
+    files.clear();
+    try {
+        itk::GDCMSeriesFileNames::Pointer names = itk::GDCMSeriesFileNames::New();
+        names->SetUseSeriesDetails(true);
+        names->SetDirectory(directory);
+        for (const auto& uid : names->GetSeriesUIDs()) {
+            const auto& series = names->GetFileNames(uid);
+            if (series.size() > files.size()) {
+                files = series;
+            }
+        }
+    } catch (itk::ExceptionObject& err) {
+        std::cerr << "ITK Exception: " << err << std::endl;
+        return false;
+    }
+    if (files.empty()) {
+        std::cerr << "No DICOM series found in " << directory << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ITKTests::LoadVolume(const std::string& path, LoadedVolume& volume, unsigned int workers) {
+    std::error_code ec;
+    if (!fs::is_directory(path, ec)) {
+        return LoadSingleFile(path, volume);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> files;
+    if (!FindLargestSeries(path, files)) {
+        return false;
+    }
+    if (files.size() == 1) {
+        return LoadSingleFile(files.front(), volume);
+    }
+
+    // The first header fixes the slice layout; reading it serially also warms GDCM's global dictionaries
+    itk::GDCMImageIO::Pointer firstIO = itk::GDCMImageIO::New();
+    try {
+        firstIO->SetFileName(files.front());
+        firstIO->ReadImageInformation();
+    } catch (itk::ExceptionObject& err) {
+        std::cerr << "ITK Exception: " << err << std::endl;
+        return false;
+    }
+    if (firstIO->GetNumberOfComponents() != 1) {
+        std::cerr << "Series loader supports scalar images only; pass a single file for color data." << std::endl;
+        return false;
+    }
+    const itk::SizeValueType columns = firstIO->GetDimensions(0);
+    const itk::SizeValueType rows = firstIO->GetDimensions(1);
+    const std::size_t sliceVoxels = static_cast<std::size_t>(columns) * rows;
+
+    VolumeImageType::SizeType size;
+    size[0] = columns;
+    size[1] = rows;
+    size[2] = files.size();
+    VolumeImageType::Pointer image = VolumeImageType::New();
+    image->SetRegions(size);
+    image->Allocate();
+    VolumePixelType* buffer = image->GetBufferPointer();
+
+    // Decode pass: each worker owns an ImageIO and a scratch buffer for slices that are not stored as int16
+    // Default to ITK's global thread count so --threads caps decoding as well as filtering
+    if (workers == 0) {
+        workers = itk::MultiThreaderBase::GetGlobalDefaultNumberOfThreads();
+    }
+    const unsigned int threads = ParallelUtils::ResolveWorkerCount(files.size(), workers);
+    std::vector<itk::GDCMImageIO::Pointer> workerIO(threads);
+    std::vector<std::vector<char>> scratch(threads);
+    std::vector<std::array<double, 3>> positions(files.size());
+    std::atomic<bool> failed{false};
+    std::mutex errorMutex;
+    std::string firstError;
+    auto fail = [&](const std::string& message) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!failed.exchange(true)) {
+            firstError = message;
+        }
+    };
+
+    ParallelUtils::ParallelFor(files.size(), threads, [&](unsigned int worker, std::size_t index) {
+        if (failed.load()) {
+            return;
+        }
+        if (workerIO[worker].IsNull()) {
+            workerIO[worker] = itk::GDCMImageIO::New();
+        }
+        itk::GDCMImageIO* io = workerIO[worker];
+        try {
+            io->SetFileName(files[index]);
+            io->ReadImageInformation();
+            if (io->GetDimensions(0) != columns || io->GetDimensions(1) != rows ||
+                (io->GetNumberOfDimensions() > 2 && io->GetDimensions(2) > 1) || io->GetNumberOfComponents() != 1) {
+                fail(files[index] + " does not match the " + std::to_string(columns) + "x" + std::to_string(rows) +
+                     " single-frame layout of the series");
+                return;
+            }
+            for (unsigned int axis = 0; axis < 3; ++axis) {
+                positions[index][axis] = io->GetOrigin(axis);
+            }
+            VolumePixelType* slice = buffer + index * sliceVoxels;
+            if (io->GetComponentType() == itk::IOComponentEnum::SHORT) {
+                io->Read(slice);
+            } else {
+                auto& bytes = scratch[worker];
+                bytes.resize(io->GetImageSizeInBytes());
+                io->Read(bytes.data());
+                if (!ConvertToVolume(io->GetComponentType(), bytes.data(), slice, sliceVoxels)) {
+                    fail(files[index] + " has an unsupported pixel component type");
+                }
+            }
+        } catch (itk::ExceptionObject& err) {
+            std::ostringstream message;
+            message << files[index] << ": " << err;
+            fail(message.str());
+        }
+    });
+    if (failed.load()) {
+        std::cerr << "Series load failed: " << firstError << std::endl;
+        return false;
+    }
+
+    // Geometry: in-plane axes from the first header, slice axis from the projected position gaps
+    VolumeImageType::DirectionType direction;
+    VolumeImageType::SpacingType spacing;
+    VolumeImageType::PointType origin;
+    for (unsigned int axis = 0; axis < 3; ++axis) {
+        const std::vector<double> cosines = firstIO->GetDirection(axis);
+        for (unsigned int row = 0; row < 3; ++row) {
+            direction[row][axis] = row < cosines.size() ? cosines[row] : (row == axis ? 1.0 : 0.0);
+        }
+        origin[axis] = positions.front()[axis];
+    }
+    auto project = [&](std::size_t from, std::size_t to) {
+        double distance = 0.0;
+        for (unsigned int row = 0; row < 3; ++row) {
+            distance += (positions[to][row] - positions[from][row]) * direction[row][2];
+        }
+        return distance;
+    };
+    double meanGap = project(0, files.size() - 1) / static_cast<double>(files.size() - 1);
+    if (meanGap < 0.0) {
+        // Positions run against the computed normal; flip the axis so spacing stays positive
+        for (unsigned int row = 0; row < 3; ++row) {
+            direction[row][2] = -direction[row][2];
+        }
+        meanGap = -meanGap;
+    }
+
+    double maxDeviation = 0.0;
+    std::size_t nonIncreasing = 0;
+    for (std::size_t i = 0; i + 1 < files.size(); ++i) {
+        const double gap = project(i, i + 1);
+        if (gap <= 0.0) {
+            ++nonIncreasing;
+        }
+        maxDeviation = std::max(maxDeviation, std::abs(gap - meanGap));
+    }
+    if (meanGap <= 0.0) {
+        // No usable positions (e.g. stripped headers): fall back to the slice thickness GDCM reported
+        meanGap = firstIO->GetSpacing(2);
+        std::cerr << "Warning: slices share one position; using " << meanGap << " mm slice spacing." << std::endl;
+    } else if (nonIncreasing > 0) {
+        std::cerr << "Warning: " << nonIncreasing << " duplicate or out-of-order slice positions in series." << std::endl;
+    } else if (maxDeviation > kSpacingTolerance * meanGap) {
+        std::cerr << "Warning: non-uniform slice spacing (gaps deviate up to " << maxDeviation << " mm from the "
+                  << meanGap << " mm mean); the volume uses the mean." << std::endl;
+    }
+    spacing[0] = firstIO->GetSpacing(0);
+    spacing[1] = firstIO->GetSpacing(1);
+    spacing[2] = meanGap;
+    image->SetSpacing(spacing);
+    image->SetOrigin(origin);
+    image->SetDirection(direction);
+
+    volume.image = image;
+    volume.io = firstIO;
+    volume.slices = files.size();
+    volume.spacingDeviation = maxDeviation;
+
+    const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Loaded " << files.size() << "-slice series (" << columns << "x" << rows << ", " << std::fixed
+              << std::setprecision(3) << spacing[0] << "x" << spacing[1] << "x" << spacing[2] << " mm) on " << threads
+              << " threads in " << std::setprecision(1) << elapsedMs << " ms" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    return true;
+}
+
+#endif
@@ -0,0 +1,41 @@
+//
+// ITKSeriesLoader.h
+// DicomToolsCpp
+//
+// Declares the shared ITK volume loader that orders a DICOM series by slice position and decodes slices in parallel.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#ifdef USE_ITK
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "itkGDCMImageIO.h"
+#include "itkImage.h"
+
+namespace ITKTests {
+    // Every ITK action starts from a signed 16-bit volume and casts from there when a filter wants floats
+    using VolumePixelType = signed short;
+    using VolumeImageType = itk::Image<VolumePixelType, 3>;
+
+    struct LoadedVolume {
+        VolumeImageType::Pointer image;
+        // IO that parsed the first slice; DICOM writers reuse it so outputs keep the source patient/study tags
+        itk::GDCMImageIO::Pointer io;
+        std::size_t slices{0};
+        // Largest distance between a slice gap and the mean gap in mm (0 for single files)
+        double spacingDeviation{0.0};
+    };
+
+    // File names of the largest series in a directory, ordered along the slice normal. Prints its own errors.
+    bool FindLargestSeries(const std::string& directory, std::vector<std::string>& files);
+
+    // Load a DICOM file (multi-frame included) or the largest series in a directory.
+    // Series slices are ordered by Image Position (Patient), checked for uniform spacing, and decoded on
+    // `workers` threads (0 = ITK's global default) straight into the preallocated volume. Prints its own errors.
+    bool LoadVolume(const std::string& path, LoadedVolume& volume, unsigned int workers = 0);
+}
+#endif
@@ -0,0 +1,58 @@
+//
+// ITKSession.cpp
+// DicomToolsCpp
+//
+// Implements the session's single background writer so encoding and disk I/O overlap with the next filter stage.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#include "ITKSession.h"
+
+#ifdef USE_ITK
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <utility>
+
+namespace ITKTests {
+
+ITKSession::ITKSession(LoadedVolume volume, std::string outputDir, bool writeOutputs)
+    : volume_(std::move(volume)),
+      outputDir_(std::move(outputDir)),
+      writeOutputs_(writeOutputs),
+      // One writer keeps the shared GDCM IO single-threaded; two pending outputs are enough to hide most writes
+      writes_(2, 1, [this](WriteJob& job) {
+          const auto start = std::chrono::steady_clock::now();
+          try {
+              job();
+          } catch (const std::exception& err) {
+              std::cerr << "ITK write failed: " << err.what() << std::endl;
+          }
+          const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+          std::lock_guard<std::mutex> lock(timeMutex_);
+          writeMs_ += elapsed;
+      }) {}
+
+ITKSession::~ITKSession() {
+    writes_.Close();
+}
+
+double ITKSession::Finish() {
+    writes_.Close();
+    std::lock_guard<std::mutex> lock(timeMutex_);
+    return writeMs_;
+}
+
+std::string ITKSession::OutputPath(const std::string& filename) const {
+    return (std::filesystem::path(outputDir_) / filename).string();
+}
+
+void ITKSession::Enqueue(WriteJob job) {
+    if (!writes_.Push(std::move(job))) {
+        std::cerr << "ITK session already finished; output dropped." << std::endl;
+    }
+}
+
+} // namespace ITKTests
+
+#endif
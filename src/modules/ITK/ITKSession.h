@@ -0,0 +1,90 @@
+//
+// ITKSession.h
+// DicomToolsCpp
+//
+// Declares the ITK processing session: one decoded volume shared by filter stages, with outputs written in the background.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#ifdef USE_ITK
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+#include "ITKSeriesLoader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageIOBase.h"
+#include "utils/WorkQueue.h"
+
+namespace ITKTests {
+    class ITKSession {
+    public:
+        // writeOutputs=false runs stages for timing only; Write() then drops results without touching disk
+        ITKSession(LoadedVolume volume, std::string outputDir, bool writeOutputs = true);
+        ~ITKSession();
+
+        ITKSession(const ITKSession&) = delete;
+        ITKSession& operator=(const ITKSession&) = delete;
+
+        // Read-only input shared by every stage; filters that could overwrite it must run out of place
+        VolumeImageType* Input() const { return volume_.image; }
+        const LoadedVolume& Volume() const { return volume_; }
+        // GDCM IO holding the source tags, for stages that write .dcm outputs
+        itk::ImageIOBase* DicomIO() const { return volume_.io; }
+        bool WritesOutputs() const { return writeOutputs_; }
+
+        // Detach a computed image from its pipeline and queue it for the writer thread.
+        // Blocks only while two earlier outputs are still being written, which bounds the extra memory held.
+        template <typename TImage>
+        void Write(TImage* image, const std::string& filename, itk::ImageIOBase* io, bool compress = false,
+                   const std::string& message = "Saved to");
+
+        // Wait for queued writes and return the milliseconds the writer thread spent on them
+        double Finish();
+
+    private:
+        using WriteJob = std::function<void()>;
+
+        std::string OutputPath(const std::string& filename) const;
+        void Enqueue(WriteJob job);
+
+        LoadedVolume volume_;
+        std::string outputDir_;
+        bool writeOutputs_{true};
+        std::mutex timeMutex_;
+        double writeMs_{0.0};
+        // Declared last so it is joined before the members its handler touches go away
+        WorkQueue<WriteJob> writes_;
+    };
+
+    template <typename TImage>
+    void ITKSession::Write(TImage* image, const std::string& filename, itk::ImageIOBase* io, bool compress,
+                           const std::string& message) {
+        if (!writeOutputs_) {
+            return;
+        }
+        typename TImage::Pointer output = image;
+        // The stage's filters are released when it returns; the detached output lives on in the job
+        output->DisconnectPipeline();
+        itk::ImageIOBase::Pointer imageIO = io;
+        const std::string path = OutputPath(filename);
+        Enqueue([output, imageIO, path, compress, message]() {
+            using WriterType = itk::ImageFileWriter<TImage>;
+            typename WriterType::Pointer writer = WriterType::New();
+            writer->SetFileName(path);
+            writer->SetInput(output);
+            writer->SetImageIO(imageIO);
+            writer->SetUseCompression(compress);
+            try {
+                writer->Update();
+                std::cout << (message + " '" + path + "'") << std::endl;
+            } catch (itk::ExceptionObject& err) {
+                std::cerr << "ITK Write Exception: " << err << std::endl;
+            }
+        });
+    }
+}
+#endif
@@ -0,0 +1,31 @@
+//
+// ITKStreaming.h
+// DicomToolsCpp
+//
+// Declares the memory-bounded ITK path that filters a volume slab by slab and appends each slab to an NRRD/MetaImage file.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace ITKTests {
+    // Settings the in-memory commands take, honoured slab by slab: gaussianEngine discrete or separable (recursive
+    // has no finite halo and is refused) with sigma in mm, medianEngine histogram or itk with radius in voxels,
+    // and anisotropic precision fp32 or fp16. Each halo is sized from the kernel reach.
+    struct StreamSettings {
+        std::string gaussianEngine{"discrete"};
+        double sigma{1.0};
+        std::string medianEngine{"histogram"};
+        unsigned int radius{1};
+        std::string precision{"fp32"};
+    };
+
+    // Run the named filter (gaussian, median, threshold, aniso) in z slabs sized so the pipeline stays within
+    // maxMemoryBytes, writing the result to itk_<filter>.nrrd or .mha (format "nrrd"/"mha"). Prints its own errors.
+    bool RunStreamedFilter(const std::string& filename, const std::string& outputDir, const std::string& filter,
+                           std::uint64_t maxMemoryBytes, const std::string& format,
+                           const StreamSettings& settings = StreamSettings());
+}
@@ -14,4 +14,6 @@ class CommandRegistry;
 namespace ITKTests {
     // Registers ITK feature demos with the CLI registry
     void RegisterCommands(CommandRegistry& registry);
+    // Apply --threads/--itk-backend to ITK's global multithreader; false for an unknown backend name
+    bool ConfigureThreading(unsigned int threads, const std::string& backend);
 }
@@ -9,151 +9,279 @@
 #include "ITKTestInterface.h"
 
 #include "ITKFeatureActions.h"
+#include "ITKStreaming.h"
 #include "cli/CommandRegistry.h"
 
 #ifdef USE_ITK
 
+#include <functional>
+
+namespace {
+// Every ITK command honours --threads/--itk-backend before it builds a filter; in a shared process the caller has
+// already applied them once, and changing the global threader under concurrently running filters is unsafe
+std::function<int(const CommandContext&)> WithThreading(std::function<int(const CommandContext&)> action) {
+    return [action](const CommandContext& ctx) {
+        if (!ctx.sharedProcess && !ITKTests::ConfigureThreading(ctx.threads, ctx.itkBackend)) {
+            return 1;
+        }
+        return action(ctx);
+    };
+}
+
+// --max-memory runs the same engine and parameters as the in-memory path, just slab by slab
+ITKTests::StreamSettings StreamSettingsFrom(const CommandContext& ctx) {
+    return {ctx.gaussianEngine, ctx.sigma, ctx.medianEngine, ctx.radius, ctx.precision};
+}
+}
+
 void ITKTests::RegisterCommands(CommandRegistry& registry) {
     // Composite command that exercises every ITK demonstration in sequence
     registry.Register({
         "test-itk",
         "ITK",
-        "Run all ITK feature tests",
-        [](const CommandContext& ctx) {
-            TestCannyEdgeDetection(ctx.inputPath, ctx.outputDir);
-            TestGaussianSmoothing(ctx.inputPath, ctx.outputDir);
-            TestMedianFilter(ctx.inputPath, ctx.outputDir);
-            TestBinaryThresholding(ctx.inputPath, ctx.outputDir);
-            TestOtsuSegmentation(ctx.inputPath, ctx.outputDir);
-            TestResampling(ctx.inputPath, ctx.outputDir);
-            TestAnisotropicDenoise(ctx.inputPath, ctx.outputDir);
-            TestAdaptiveHistogram(ctx.inputPath, ctx.outputDir);
-            TestSliceExtraction(ctx.inputPath, ctx.outputDir);
-            TestMaximumIntensityProjection(ctx.inputPath, ctx.outputDir);
-            TestNRRDExport(ctx.inputPath, ctx.outputDir);
-            TestNiftiExport(ctx.inputPath, ctx.outputDir);
+        "Run all ITK feature tests on one decoded volume",
+        WithThreading([](const CommandContext& ctx) {
+            RunITKSession(ctx.inputPath, ctx.outputDir);
             return 0;
-        }
+        })
     });
 
     registry.Register({
         "itk:canny",
         "ITK",
         "Run 3D canny edge detection and write DICOM",
-        [](const CommandContext& ctx) {
+        WithThreading([](const CommandContext& ctx) {
             TestCannyEdgeDetection(ctx.inputPath, ctx.outputDir);
             return 0;
-        }
+        })
     });
 
     registry.Register({
         "itk:gaussian",
         "ITK",
         "3D Gaussian smoothing",
-        [](const CommandContext& ctx) {
-            TestGaussianSmoothing(ctx.inputPath, ctx.outputDir);
+        WithThreading([](const CommandContext& ctx) {
+            if (ctx.maxMemory > 0) {
+                return RunStreamedFilter(ctx.inputPath, ctx.outputDir, "gaussian", ctx.maxMemory, ctx.streamFormat,
+                                         StreamSettingsFrom(ctx)) ? 0 : 1;
+            }
+            TestGaussianSmoothing(ctx.inputPath, ctx.outputDir, ctx.gaussianEngine, ctx.sigma);
             return 0;
-        }
+        })
+    });
+
+    registry.Register({
+        "bench:gaussian",
+        "ITK",
+        "Compare discrete, recursive and separable Gaussian engines across sigma 1-5 mm",
+        WithThreading([](const CommandContext& ctx) {
+            RunGaussianBenchmark(ctx.inputPath, ctx.outputDir);
+            return 0;
+        })
     });
 
     registry.Register({
         "itk:threshold",
         "ITK",
         "Binary threshold segmentation",
-        [](const CommandContext& ctx) {
+        WithThreading([](const CommandContext& ctx) {
+            if (ctx.maxMemory > 0) {
+                return RunStreamedFilter(ctx.inputPath, ctx.outputDir, "threshold", ctx.maxMemory, ctx.streamFormat,
+                                         StreamSettingsFrom(ctx)) ? 0 : 1;
+            }
             TestBinaryThresholding(ctx.inputPath, ctx.outputDir);
             return 0;
-        }
+        })
     });
 
     registry.Register({
         "itk:otsu",
         "ITK",
         "Automatic Otsu segmentation",
-        [](const CommandContext& ctx) {
+        WithThreading([](const CommandContext& ctx) {
             TestOtsuSegmentation(ctx.inputPath, ctx.outputDir);
             return 0;
-        }
+        })
+    });
+
+    registry.Register({
+        "itk:label",
+        "ITK",
+        "Connected components of a mask with per-label stats to CSV/JSON (--connectivity, --min-size, --intensity)",
+        WithThreading([](const CommandContext& ctx) {
+            TestConnectedComponents(ctx.inputPath, ctx.outputDir, ctx.intensityPath, ctx.connectivity, ctx.minSize);
+            return 0;
+        })
+    });
+
+    registry.Register({
+        "itk:mask",
+        "ITK",
+        "Bit-packed mask dilate/erode/open/close/fill or signed distance map (--mask-op, --radius)",
+        WithThreading([](const CommandContext& ctx) {
+            TestMaskMorphology(ctx.inputPath, ctx.outputDir, ctx.maskOp, ctx.radius);
+            return 0;
+        })
+    });
+
+    registry.Register({
+        "bench:morphology",
+        "ITK",
+        "Compare ITK binary morphology and Maurer distance with the packed engine and exact EDT",
+        WithThreading([](const CommandContext& ctx) {
+            RunMorphologyBenchmark(ctx.inputPath, ctx.outputDir);
+            return 0;
+        })
     });
 
     registry.Register({
         "itk:resample",
         "ITK",
-        "Resample to isotropic spacing (1mm) using linear interpolation",
-        [](const CommandContext& ctx) {
-            TestResampling(ctx.inputPath, ctx.outputDir);
+        "Resample to isotropic spacing (1mm) with the chosen engine and interpolation",
+        WithThreading([](const CommandContext& ctx) {
+            TestResampling(ctx.inputPath, ctx.outputDir, ctx.resampleEngine.empty() ? "separable" : ctx.resampleEngine,
+                           ctx.interpolation, ctx.antialias);
             return 0;
-        }
+        })
+    });
+
+    registry.Register({
+        "bench:resample",
+        "ITK",
+        "Compare ITK and separable 1mm resampling for linear, B-spline and Lanczos kernels",
+        WithThreading([](const CommandContext& ctx) {
+            RunResampleBenchmark(ctx.inputPath, ctx.outputDir);
+            return 0;
+        })
     });
 
     registry.Register({
         "itk:aniso",
         "ITK",
         "Curvature anisotropic diffusion denoising",
-        [](const CommandContext& ctx) {
-            TestAnisotropicDenoise(ctx.inputPath, ctx.outputDir);
+        WithThreading([](const CommandContext& ctx) {
+            if (ctx.maxMemory > 0) {
+                return RunStreamedFilter(ctx.inputPath, ctx.outputDir, "aniso", ctx.maxMemory, ctx.streamFormat,
+                                         StreamSettingsFrom(ctx)) ? 0 : 1;
+            }
+            TestAnisotropicDenoise(ctx.inputPath, ctx.outputDir, ctx.precision);
             return 0;
-        }
+        })
     });
 
     registry.Register({
         "itk:histogram",
         "ITK",
-        "Adaptive histogram equalization for contrast boost",
-        [](const CommandContext& ctx) {
-            TestAdaptiveHistogram(ctx.inputPath, ctx.outputDir);
+        "Adaptive histogram equalization (tiled CLAHE 2D/3D or ITK) for contrast boost",
+        WithThreading([](const CommandContext& ctx) {
+            TestAdaptiveHistogram(ctx.inputPath, ctx.outputDir, ctx.equalizeEngine, ctx.tiles, ctx.clipLimit, ctx.alpha,
+                                  ctx.beta);
             return 0;
-        }
+        })
+    });
+
+    registry.Register({
+        "bench:equalize",
+        "ITK",
+        "Compare ITK adaptive histogram equalization with tiled CLAHE per slice and per volume",
+        WithThreading([](const CommandContext& ctx) {
+            RunEqualizeBenchmark(ctx.inputPath, ctx.outputDir);
+            return 0;
+        })
     });
 
     registry.Register({
         "itk:mip",
         "ITK",
         "Axial maximum intensity projection saved as PNG",
-        [](const CommandContext& ctx) {
+        WithThreading([](const CommandContext& ctx) {
             TestMaximumIntensityProjection(ctx.inputPath, ctx.outputDir);
             return 0;
-        }
+        })
+    });
+
+    registry.Register({
+        "itk:slab",
+        "ITK",
+        "Thin-slab MIP/MinIP/AvgIP cine stack along any axis (--projection, --axis, --slab, --slab-step)",
+        WithThreading([](const CommandContext& ctx) {
+            TestSlabProjection(ctx.inputPath, ctx.outputDir, ctx.projection, ctx.axis, ctx.slabThickness, ctx.slabStep);
+            return 0;
+        })
+    });
+
+    registry.Register({
+        "bench:slab",
+        "ITK",
+        "Compare axial max/mean cine stacks against ITK per-slab projection",
+        WithThreading([](const CommandContext& ctx) {
+            RunSlabBenchmark(ctx.inputPath, ctx.outputDir);
+            return 0;
+        })
     });
 
     registry.Register({
         "itk:slice",
         "ITK",
         "Extract middle axial slice to PNG",
-        [](const CommandContext& ctx) {
+        WithThreading([](const CommandContext& ctx) {
             TestSliceExtraction(ctx.inputPath, ctx.outputDir);
             return 0;
-        }
+        })
     });
 
     registry.Register({
         "itk:median",
         "ITK",
         "Median smoothing for salt-and-pepper noise removal",
-        [](const CommandContext& ctx) {
-            TestMedianFilter(ctx.inputPath, ctx.outputDir);
+        WithThreading([](const CommandContext& ctx) {
+            if (ctx.maxMemory > 0) {
+                return RunStreamedFilter(ctx.inputPath, ctx.outputDir, "median", ctx.maxMemory, ctx.streamFormat,
+                                         StreamSettingsFrom(ctx)) ? 0 : 1;
+            }
+            TestMedianFilter(ctx.inputPath, ctx.outputDir, ctx.medianEngine, ctx.radius);
             return 0;
-        }
+        })
+    });
+
+    registry.Register({
+        "bench:median",
+        "ITK",
+        "Compare ITK and sliding-histogram median engines at radius 1-5",
+        WithThreading([](const CommandContext& ctx) {
+            RunMedianBenchmark(ctx.inputPath, ctx.outputDir);
+            return 0;
+        })
     });
 
     registry.Register({
         "itk:nrrd",
         "ITK",
         "Export the volume to NRRD for interchange",
-        [](const CommandContext& ctx) {
+        WithThreading([](const CommandContext& ctx) {
             TestNRRDExport(ctx.inputPath, ctx.outputDir);
             return 0;
-        }
+        })
     });
 
     registry.Register({
         "itk:nifti",
         "ITK",
         "Export the volume to NIfTI (.nii.gz)",
-        [](const CommandContext& ctx) {
+        WithThreading([](const CommandContext& ctx) {
             TestNiftiExport(ctx.inputPath, ctx.outputDir);
             return 0;
-        }
+        })
+    });
+
+    registry.Register({
+        "bench:itk-scaling",
+        "ITK",
+        "Time each ITK filter at 1, 2, 4, ... --threads threads and report speedup/efficiency",
+        WithThreading([](const CommandContext& ctx) {
+            RunScalingBenchmark(ctx.inputPath, ctx.outputDir, ctx.threads);
+            return 0;
+        })
     });
 }
 
@@ -19,6 +19,10 @@ namespace VTKTests {
     void TestMetadataExport(const std::string& filename, const std::string& outputDir);
     void TestNiftiExport(const std::string& filename, const std::string& outputDir);
     void TestVolumeStatistics(const std::string& filename, const std::string& outputDir);
-    void TestIsotropicResample(const std::string& filename, const std::string& outputDir);
+    // engine: vtk (vtkImageResample) or separable (in-house per-axis tables on the ITK grid, which can differ in
+    // size from vtkImageResample's); interpolation: linear, bspline, lanczos
+    void TestIsotropicResample(const std::string& filename, const std::string& outputDir,
+                               const std::string& engine = "vtk", const std::string& interpolation = "linear",
+                               bool antialias = false);
     void TestMaximumIntensityProjection(const std::string& filename, const std::string& outputDir);
 }
@@ -66,9 +66,11 @@ void VTKTests::RegisterCommands(CommandRegistry& registry) {
     registry.Register({
         "vtk:resample",
         "VTK",
-        "Resample to isotropic spacing (1mm)",
+        "Resample to isotropic spacing (1mm) with the chosen engine and interpolation",
         [](const CommandContext& ctx) {
-            TestIsotropicResample(ctx.inputPath, ctx.outputDir);
+            // vtkImageResample stays the default so existing output shapes do not change; separable is opt-in
+            TestIsotropicResample(ctx.inputPath, ctx.outputDir, ctx.resampleEngine.empty() ? "vtk" : ctx.resampleEngine,
+                                  ctx.interpolation, ctx.antialias);
             return 0;
         }
     });
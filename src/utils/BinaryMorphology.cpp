@@ -0,0 +1,259 @@
+//
+// BinaryMorphology.cpp
+// DicomToolsCpp
+//
+// Implements packed-mask morphology: ball dilation as ORs of word-shifted rows, erosion by duality, and hole
+// filling through the connected-component labeler.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#include "BinaryMorphology.h"
+
+#include <algorithm>
+
+#include "ConnectedComponents.h"
+#include "ParallelUtils.h"
+
+namespace BinaryMorphology {
+namespace {
+// One row of the ball: source row (y + dy, z + dz), widened by `width` voxels either side along x
+struct DiskRow {
+    int dy;
+    int dz;
+    unsigned int width;
+};
+
+std::vector<DiskRow> BallRows(unsigned int radius) {
+    // Offsets within radius + 0.5, as itk::BinaryBallStructuringElement; doubled to stay in integers
+    const long long limit = (2LL * radius + 1) * (2LL * radius + 1);
+    const int r = static_cast<int>(radius);
+    std::vector<DiskRow> rows;
+    for (int dz = -r; dz <= r; ++dz) {
+        for (int dy = -r; dy <= r; ++dy) {
+            const long long remaining = limit - 4LL * (dy * dy + dz * dz);
+            if (remaining < 0) {
+                continue;
+            }
+            unsigned int width = 0;
+            while (4LL * (width + 1) * (width + 1) <= remaining) {
+                ++width;
+            }
+            rows.push_back({dy, dz, width});
+        }
+    }
+    return rows;
+}
+
+std::uint64_t TailMask(std::size_t width) {
+    const std::size_t bits = width % 64;
+    return bits == 0 ? ~std::uint64_t{0} : (std::uint64_t{1} << bits) - 1;
+}
+
+PackedMask Empty(const VolumeExtent& extent) {
+    PackedMask mask;
+    mask.extent = extent;
+    mask.rowWords = (extent.x + 63) / 64;
+    mask.words.assign(mask.rowWords * extent.y * extent.z, 0);
+    return mask;
+}
+
+// OR `source` widened by `width` voxels either side into `target`. Bits shifted out of one word carry into its
+// neighbour; the loop body is branch-free so the compiler can run several words per vector instruction.
+void OrWidened(const std::uint64_t* source, std::size_t words, unsigned int width, std::uint64_t* target) {
+    if (width == 0) {
+        for (std::size_t i = 0; i < words; ++i) {
+            target[i] |= source[i];
+        }
+        return;
+    }
+    for (std::size_t i = 0; i < words; ++i) {
+        const std::uint64_t word = source[i];
+        const std::uint64_t previous = i > 0 ? source[i - 1] : 0;
+        const std::uint64_t next = i + 1 < words ? source[i + 1] : 0;
+        std::uint64_t widened = word;
+        for (unsigned int shift = 1; shift <= width; ++shift) {
+            widened |= (word << shift) | (previous >> (64 - shift)) | (word >> shift) | (next << (64 - shift));
+        }
+        target[i] |= widened;
+    }
+}
+
+PackedMask Dilate(const PackedMask& input, unsigned int radius, unsigned int workers) {
+    const VolumeExtent& extent = input.extent;
+    PackedMask output = Empty(extent);
+    if (output.words.empty()) {
+        return output;
+    }
+    const std::vector<DiskRow> rows = BallRows(radius);
+    const std::uint64_t tail = TailMask(extent.x);
+    const unsigned int threads = ParallelUtils::ResolveWorkerCount(extent.z, workers);
+    ParallelUtils::ParallelFor(extent.z, threads, [&](unsigned int, std::size_t z) {
+        for (std::size_t y = 0; y < extent.y; ++y) {
+            std::uint64_t* target = output.Row(y, z);
+            for (const DiskRow& row : rows) {
+                const long long sy = static_cast<long long>(y) + row.dy;
+                const long long sz = static_cast<long long>(z) + row.dz;
+                if (sy < 0 || sz < 0 || sy >= static_cast<long long>(extent.y) ||
+                    sz >= static_cast<long long>(extent.z)) {
+                    continue;
+                }
+                OrWidened(input.Row(static_cast<std::size_t>(sy), static_cast<std::size_t>(sz)), input.rowWords,
+                          row.width, target);
+            }
+            target[output.rowWords - 1] &= tail;
+        }
+    });
+    return output;
+}
+
+void Complement(PackedMask& mask, unsigned int workers) {
+    const VolumeExtent& extent = mask.extent;
+    if (mask.words.empty()) {
+        return;
+    }
+    const std::uint64_t tail = TailMask(extent.x);
+    const unsigned int threads = ParallelUtils::ResolveWorkerCount(extent.z, workers);
+    ParallelUtils::ParallelFor(extent.z, threads, [&](unsigned int, std::size_t z) {
+        for (std::size_t y = 0; y < extent.y; ++y) {
+            std::uint64_t* row = mask.Row(y, z);
+            for (std::size_t i = 0; i < mask.rowWords; ++i) {
+                row[i] = ~row[i];
+            }
+            row[mask.rowWords - 1] &= tail;
+        }
+    });
+}
+
+// Erosion is the complement of dilating the complement; outside voxels are background to that dilation, which
+// makes them foreground to the erosion
+PackedMask Erode(const PackedMask& input, unsigned int radius, unsigned int workers) {
+    PackedMask complement = input;
+    Complement(complement, workers);
+    PackedMask output = Dilate(complement, radius, workers);
+    Complement(output, workers);
+    return output;
+}
+
+PackedMask FillHoles(const PackedMask& input, unsigned int workers) {
+    const VolumeExtent& extent = input.extent;
+    const std::size_t voxels = extent.Voxels();
+    PackedMask output = input;
+    if (voxels == 0) {
+        return output;
+    }
+    const unsigned int threads = ParallelUtils::ResolveWorkerCount(extent.z, workers);
+    std::vector<short> background(voxels);
+    ParallelUtils::ParallelFor(extent.z, threads, [&](unsigned int, std::size_t z) {
+        for (std::size_t y = 0; y < extent.y; ++y) {
+            short* row = background.data() + (z * extent.y + y) * extent.x;
+            for (std::size_t x = 0; x < extent.x; ++x) {
+                row[x] = input.Test(x, y, z) ? 0 : 1;
+            }
+        }
+    });
+    std::vector<std::uint32_t> labels(voxels);
+    std::size_t removed = 0;
+    const std::vector<ConnectedComponents::Component> components =
+        ConnectedComponents::Label(background.data(), nullptr, extent, 6, 0, labels.data(), removed, threads);
+    background = std::vector<short>();
+
+    // A background component is a hole unless its bounding box reaches a face of the volume
+    const std::size_t last[3] = {extent.x - 1, extent.y - 1, extent.z - 1};
+    std::vector<char> hole(components.size() + 1, 0);
+    for (std::size_t k = 0; k < components.size(); ++k) {
+        bool border = false;
+        for (unsigned int a = 0; a < 3; ++a) {
+            border = border || components[k].min[a] == 0 || components[k].max[a] == last[a];
+        }
+        hole[k + 1] = border ? 0 : 1;
+    }
+    ParallelUtils::ParallelFor(extent.z, threads, [&](unsigned int, std::size_t z) {
+        for (std::size_t y = 0; y < extent.y; ++y) {
+            const std::uint32_t* row = labels.data() + (z * extent.y + y) * extent.x;
+            std::uint64_t* target = output.Row(y, z);
+            for (std::size_t x = 0; x < extent.x; ++x) {
+                if (hole[row[x]]) {
+                    target[x / 64] |= std::uint64_t{1} << (x % 64);
+                }
+            }
+        }
+    });
+    return output;
+}
+} // namespace
+
+bool OperationFromName(const std::string& name, Operation& operation) {
+    if (name == "dilate") {
+        operation = Operation::Dilate;
+    } else if (name == "erode") {
+        operation = Operation::Erode;
+    } else if (name == "open") {
+        operation = Operation::Open;
+    } else if (name == "close") {
+        operation = Operation::Close;
+    } else if (name == "fill") {
+        operation = Operation::FillHoles;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+PackedMask Pack(const short* mask, const VolumeExtent& extent, unsigned int workers) {
+    PackedMask packed = Empty(extent);
+    if (packed.words.empty()) {
+        return packed;
+    }
+    const unsigned int threads = ParallelUtils::ResolveWorkerCount(extent.z, workers);
+    ParallelUtils::ParallelFor(extent.z, threads, [&](unsigned int, std::size_t z) {
+        for (std::size_t y = 0; y < extent.y; ++y) {
+            const short* source = mask + (z * extent.y + y) * extent.x;
+            std::uint64_t* target = packed.Row(y, z);
+            for (std::size_t word = 0; word < packed.rowWords; ++word) {
+                const std::size_t first = word * 64;
+                const std::size_t count = std::min<std::size_t>(64, extent.x - first);
+                std::uint64_t bits = 0;
+                for (std::size_t b = 0; b < count; ++b) {
+                    bits |= static_cast<std::uint64_t>(source[first + b] != 0) << b;
+                }
+                target[word] = bits;
+            }
+        }
+    });
+    return packed;
+}
+
+void Unpack(const PackedMask& mask, short insideValue, short* output, unsigned int workers) {
+    const VolumeExtent& extent = mask.extent;
+    if (mask.words.empty()) {
+        return;
+    }
+    const unsigned int threads = ParallelUtils::ResolveWorkerCount(extent.z, workers);
+    ParallelUtils::ParallelFor(extent.z, threads, [&](unsigned int, std::size_t z) {
+        for (std::size_t y = 0; y < extent.y; ++y) {
+            const std::uint64_t* source = mask.Row(y, z);
+            short* target = output + (z * extent.y + y) * extent.x;
+            for (std::size_t x = 0; x < extent.x; ++x) {
+                target[x] = (source[x / 64] >> (x % 64)) & 1u ? insideValue : 0;
+            }
+        }
+    });
+}
+
+PackedMask Apply(const PackedMask& mask, Operation operation, unsigned int radius, unsigned int workers) {
+    switch (operation) {
+    case Operation::Dilate:
+        return Dilate(mask, radius, workers);
+    case Operation::Erode:
+        return Erode(mask, radius, workers);
+    case Operation::Open:
+        return Dilate(Erode(mask, radius, workers), radius, workers);
+    case Operation::Close:
+        return Erode(Dilate(mask, radius, workers), radius, workers);
+    case Operation::FillHoles:
+        return FillHoles(mask, workers);
+    }
+    return mask;
+}
+
+} // namespace BinaryMorphology
@@ -0,0 +1,49 @@
+//
+// BinaryMorphology.h
+// DicomToolsCpp
+//
+// Declares bit-packed binary masks and the morphology operations that run on them 64 voxels per word.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "VolumeExtent.h"
+
+namespace BinaryMorphology {
+    // One bit per voxel; every x row starts on a fresh word, bit b of word k is x = 64k + b, and bits past the row
+    // end stay clear
+    struct PackedMask {
+        VolumeExtent extent;
+        std::size_t rowWords{0};
+        std::vector<std::uint64_t> words;
+
+        std::uint64_t* Row(std::size_t y, std::size_t z) { return words.data() + (z * extent.y + y) * rowWords; }
+        const std::uint64_t* Row(std::size_t y, std::size_t z) const {
+            return words.data() + (z * extent.y + y) * rowWords;
+        }
+        bool Test(std::size_t x, std::size_t y, std::size_t z) const { return (Row(y, z)[x / 64] >> (x % 64)) & 1u; }
+    };
+
+    enum class Operation { Dilate, Erode, Open, Close, FillHoles };
+
+    // dilate, erode, open, close or fill; false for anything else
+    bool OperationFromName(const std::string& name, Operation& operation);
+
+    // Nonzero voxels become set bits
+    PackedMask Pack(const short* mask, const VolumeExtent& extent, unsigned int workers = 0);
+    // Set bits become insideValue, the rest 0
+    void Unpack(const PackedMask& mask, short insideValue, short* output, unsigned int workers = 0);
+
+    // Dilate/erode use the same ball as itk::BinaryBallStructuringElement (offsets within radius + 0.5 voxels), so
+    // results match ITK's binary filters: voxels outside the volume count as background when dilating and as
+    // foreground when eroding. Each output row ORs the source rows of the ball's (dy, dz) disk, each widened along x
+    // by shifts of whole words; rows run in parallel. radius must be below 64.
+    // Open/close chain the two. FillHoles sets every background voxel that no face-connected background path links
+    // to the volume border (radius unused).
+    PackedMask Apply(const PackedMask& mask, Operation operation, unsigned int radius, unsigned int workers = 0);
+}
@@ -0,0 +1,348 @@
+//
+// ConnectedComponents.cpp
+// DicomToolsCpp
+//
+// Implements block-based union-find labelling: per-slab scans in parallel, a serial join over slab borders, then
+// one parallel pass that resolves labels and gathers statistics.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#include "ConnectedComponents.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "ParallelUtils.h"
+
+namespace ConnectedComponents {
+namespace {
+// Neighbour already visited by a scan in x, then y, then z order
+struct Offset {
+    int dx;
+    int dy;
+    int dz;
+};
+
+std::vector<Offset> BackwardNeighbours(unsigned int connectivity) {
+    std::vector<Offset> offsets;
+    for (int dz = -1; dz <= 0; ++dz) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (dz == 0 && (dy > 0 || (dy == 0 && dx >= 0))) {
+                    continue;
+                }
+                const unsigned int distance = static_cast<unsigned int>(std::abs(dx) + std::abs(dy) + std::abs(dz));
+                // 6: faces only; 18: faces and edges; 26: everything
+                if (distance == 1 || (distance == 2 && connectivity >= 18) || connectivity == 26) {
+                    offsets.push_back({dx, dy, dz});
+                }
+            }
+        }
+    }
+    return offsets;
+}
+
+// Path halving keeps parent[label] <= label, since sets are always joined under their smaller root
+std::uint32_t Find(std::vector<std::uint32_t>& parent, std::uint32_t label) {
+    while (parent[label] != label) {
+        parent[label] = parent[parent[label]];
+        label = parent[label];
+    }
+    return label;
+}
+
+std::uint32_t Unite(std::vector<std::uint32_t>& parent, std::uint32_t a, std::uint32_t b) {
+    a = Find(parent, a);
+    b = Find(parent, b);
+    if (a < b) {
+        parent[b] = a;
+        return a;
+    }
+    parent[a] = b;
+    return b;
+}
+
+// With every parent at or below its label, one ascending sweep points each label straight at its root
+void Flatten(std::vector<std::uint32_t>& parent, std::size_t first) {
+    for (std::size_t label = first; label < parent.size(); ++label) {
+        parent[label] = parent[parent[label]];
+    }
+}
+
+struct Accumulator {
+    std::uint64_t voxels{0};
+    std::size_t min[3]{std::numeric_limits<std::size_t>::max(), std::numeric_limits<std::size_t>::max(),
+                       std::numeric_limits<std::size_t>::max()};
+    std::size_t max[3]{0, 0, 0};
+    double sum[3]{0.0, 0.0, 0.0};
+    double intensity{0.0};
+    double intensitySquared{0.0};
+    short minimum{std::numeric_limits<short>::max()};
+    short maximum{std::numeric_limits<short>::min()};
+
+    // Voxels [x, end) of row (y, z); `row` points at that row's intensities
+    void AddRun(std::size_t x, std::size_t end, std::size_t y, std::size_t z, const short* row) {
+        const std::size_t count = end - x;
+        voxels += count;
+        const std::size_t first[3] = {x, y, z};
+        const std::size_t last[3] = {end - 1, y, z};
+        for (unsigned int a = 0; a < 3; ++a) {
+            min[a] = std::min(min[a], first[a]);
+            max[a] = std::max(max[a], last[a]);
+        }
+        sum[0] += 0.5 * static_cast<double>(x + end - 1) * static_cast<double>(count);
+        sum[1] += static_cast<double>(y) * static_cast<double>(count);
+        sum[2] += static_cast<double>(z) * static_cast<double>(count);
+        double runSum = 0.0;
+        double runSquared = 0.0;
+        for (std::size_t i = x; i < end; ++i) {
+            const short value = row[i];
+            runSum += value;
+            runSquared += static_cast<double>(value) * value;
+            minimum = std::min(minimum, value);
+            maximum = std::max(maximum, value);
+        }
+        intensity += runSum;
+        intensitySquared += runSquared;
+    }
+
+    void Merge(const Accumulator& other) {
+        voxels += other.voxels;
+        for (unsigned int a = 0; a < 3; ++a) {
+            min[a] = std::min(min[a], other.min[a]);
+            max[a] = std::max(max[a], other.max[a]);
+            sum[a] += other.sum[a];
+        }
+        intensity += other.intensity;
+        intensitySquared += other.intensitySquared;
+        minimum = std::min(minimum, other.minimum);
+        maximum = std::max(maximum, other.maximum);
+    }
+};
+
+// Slices [firstSlice, endSlice) with provisional labels 1..parent.size()-1 and their union-find
+struct Slab {
+    std::size_t firstSlice{0};
+    std::size_t endSlice{0};
+    std::vector<std::uint32_t> parent;
+    std::vector<Accumulator> stats;
+    // Global index of local label 1
+    std::size_t base{0};
+};
+} // namespace
+
+std::vector<Component> Label(const short* mask, const short* intensity, const VolumeExtent& extent,
+                             unsigned int connectivity, std::uint64_t minVoxels, std::uint32_t* labels,
+                             std::size_t& removed, unsigned int workers) {
+    removed = 0;
+    const std::size_t voxels = extent.Voxels();
+    if (voxels == 0) {
+        return {};
+    }
+    if (!intensity) {
+        intensity = mask;
+    }
+    const std::vector<Offset> offsets = BackwardNeighbours(connectivity);
+    const std::size_t sliceVoxels = extent.SliceVoxels();
+    const unsigned int threads = ParallelUtils::ResolveWorkerCount(extent.z, workers);
+    // A few slabs per worker balance uneven masks; each extra slab only adds one border slice to the serial join
+    const std::size_t slabCount = std::min<std::size_t>(extent.z, static_cast<std::size_t>(threads) * 4);
+    std::vector<Slab> slabs(slabCount);
+    for (std::size_t s = 0; s < slabCount; ++s) {
+        slabs[s].firstSlice = s * extent.z / slabCount;
+        slabs[s].endSlice = (s + 1) * extent.z / slabCount;
+    }
+
+    std::vector<std::ptrdiff_t> deltas;
+    for (const Offset& offset : offsets) {
+        deltas.push_back((static_cast<std::ptrdiff_t>(offset.dz) * static_cast<std::ptrdiff_t>(extent.y) + offset.dy) *
+                             static_cast<std::ptrdiff_t>(extent.x) + offset.dx);
+    }
+    // When the voxel to the left is labelled, every neighbour it shares with us has already been joined to it, so
+    // only the rest need checking (4 of 13 at 26-connectivity)
+    std::vector<std::size_t> everyNeighbour;
+    std::vector<std::size_t> afterLeft;
+    for (std::size_t n = 0; n < offsets.size(); ++n) {
+        everyNeighbour.push_back(n);
+        const Offset& offset = offsets[n];
+        if (offset.dx == -1 && offset.dy == 0 && offset.dz == 0) {
+            continue;
+        }
+        const bool sharedWithLeft = std::any_of(offsets.begin(), offsets.end(), [&](const Offset& other) {
+            return other.dx == offset.dx + 1 && other.dy == offset.dy && other.dz == offset.dz;
+        });
+        if (!sharedWithLeft) {
+            afterLeft.push_back(n);
+        }
+    }
+    // Visit the labelled neighbours in `candidates` of voxel (x, y, z), skipping those before slice `firstSlice`
+    // and, when onlyDz is -1, those in the same slice, and any equal to `known`. Interior voxels skip the bounds
+    // tests.
+    auto forEachNeighbour = [&](std::size_t x, std::size_t y, std::size_t z, std::size_t firstSlice, int onlyDz,
+                                const std::vector<std::size_t>& candidates, std::uint32_t known, auto&& visit) {
+        const std::uint32_t* here = labels + (z * extent.y + y) * extent.x + x;
+        const bool interior = onlyDz == 0 && z > firstSlice && y > 0 && y + 1 < extent.y && x > 0 && x + 1 < extent.x;
+        std::uint32_t previous = known;
+        for (std::size_t n : candidates) {
+            if (!interior) {
+                const Offset& offset = offsets[n];
+                if ((onlyDz != 0 && offset.dz != onlyDz) || (offset.dz < 0 && z == firstSlice) ||
+                    (offset.dy < 0 && y == 0) || (offset.dy > 0 && y + 1 == extent.y) ||
+                    (offset.dx < 0 && x == 0) || (offset.dx > 0 && x + 1 == extent.x)) {
+                    continue;
+                }
+            }
+            const std::uint32_t neighbour = here[deltas[n]];
+            // Neighbours mostly share one label; repeats need no second union
+            if (neighbour != 0 && neighbour != previous) {
+                visit(neighbour);
+                previous = neighbour;
+            }
+        }
+    };
+
+    // 1. Provisional labels per slab, joined with the slab's own union-find
+    ParallelUtils::ParallelFor(slabCount, threads, [&](unsigned int, std::size_t s) {
+        Slab& slab = slabs[s];
+        std::vector<std::uint32_t>& parent = slab.parent;
+        parent.assign(1, 0);
+        for (std::size_t z = slab.firstSlice; z < slab.endSlice; ++z) {
+            for (std::size_t y = 0; y < extent.y; ++y) {
+                const std::size_t row = (z * extent.y + y) * extent.x;
+                for (std::size_t x = 0; x < extent.x; ++x) {
+                    if (mask[row + x] == 0) {
+                        labels[row + x] = 0;
+                        continue;
+                    }
+                    std::uint32_t current = x > 0 ? labels[row + x - 1] : 0;
+                    forEachNeighbour(x, y, z, slab.firstSlice, 0, current != 0 ? afterLeft : everyNeighbour,
+                                     current, [&](std::uint32_t neighbour) {
+                                         current = current != 0 ? Unite(parent, current, neighbour)
+                                                                : Find(parent, neighbour);
+                                     });
+                    if (current == 0) {
+                        current = static_cast<std::uint32_t>(parent.size());
+                        parent.push_back(current);
+                    }
+                    labels[row + x] = current;
+                }
+            }
+        }
+        Flatten(parent, 1);
+    });
+
+    // 2. One global union-find over every slab's labels, seeded with the slab roots, joined across slab borders
+    std::size_t total = 0;
+    for (Slab& slab : slabs) {
+        slab.base = total;
+        total += slab.parent.size() - 1;
+    }
+    std::vector<std::uint32_t> global(total);
+    for (const Slab& slab : slabs) {
+        for (std::size_t label = 1; label < slab.parent.size(); ++label) {
+            global[slab.base + label - 1] = static_cast<std::uint32_t>(slab.base + slab.parent[label] - 1);
+        }
+    }
+    for (std::size_t s = 1; s < slabCount; ++s) {
+        const Slab& slab = slabs[s];
+        const Slab& previous = slabs[s - 1];
+        const std::size_t z = slab.firstSlice;
+        for (std::size_t y = 0; y < extent.y; ++y) {
+            for (std::size_t x = 0; x < extent.x; ++x) {
+                const std::uint32_t label = labels[(z * extent.y + y) * extent.x + x];
+                if (label == 0) {
+                    continue;
+                }
+                const auto own = static_cast<std::uint32_t>(slab.base + label - 1);
+                forEachNeighbour(x, y, z, 0, -1, everyNeighbour, 0, [&](std::uint32_t neighbour) {
+                    Unite(global, own, static_cast<std::uint32_t>(previous.base + neighbour - 1));
+                });
+            }
+        }
+    }
+    Flatten(global, 0);
+    std::vector<std::uint32_t> component(total);
+    std::size_t componentCount = 0;
+    for (std::size_t label = 0; label < total; ++label) {
+        component[label] =
+            global[label] == label ? static_cast<std::uint32_t>(componentCount++) : component[global[label]];
+    }
+    global.clear();
+    global.shrink_to_fit();
+
+    // 3. Resolve every voxel to its component (1-based for now) and accumulate statistics per slab root, one run
+    //    of equal labels along x at a time
+    ParallelUtils::ParallelFor(slabCount, threads, [&](unsigned int, std::size_t s) {
+        Slab& slab = slabs[s];
+        slab.stats.assign(slab.parent.size(), Accumulator());
+        for (std::size_t z = slab.firstSlice; z < slab.endSlice; ++z) {
+            for (std::size_t y = 0; y < extent.y; ++y) {
+                const std::size_t row = (z * extent.y + y) * extent.x;
+                std::size_t x = 0;
+                while (x < extent.x) {
+                    const std::uint32_t label = labels[row + x];
+                    std::size_t end = x + 1;
+                    while (end < extent.x && labels[row + end] == label) {
+                        ++end;
+                    }
+                    if (label != 0) {
+                        const std::uint32_t root = slab.parent[label];
+                        slab.stats[root].AddRun(x, end, y, z, intensity + row);
+                        std::fill(labels + row + x, labels + row + end, component[slab.base + root - 1] + 1);
+                    }
+                    x = end;
+                }
+            }
+        }
+    });
+    std::vector<Accumulator> totals(componentCount);
+    for (Slab& slab : slabs) {
+        for (std::size_t label = 1; label < slab.parent.size(); ++label) {
+            if (slab.parent[label] == label) {
+                totals[component[slab.base + label - 1]].Merge(slab.stats[label]);
+            }
+        }
+        slab.stats = std::vector<Accumulator>();
+        slab.parent = std::vector<std::uint32_t>();
+    }
+
+    // 4. Largest first; components under minVoxels go back to background
+    std::vector<std::uint32_t> order(componentCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::uint32_t a, std::uint32_t b) { return totals[a].voxels > totals[b].voxels; });
+    std::vector<std::uint32_t> finalLabel(componentCount + 1, 0);
+    std::vector<Component> components;
+    for (std::uint32_t index : order) {
+        const Accumulator& accumulator = totals[index];
+        if (accumulator.voxels < minVoxels) {
+            ++removed;
+            continue;
+        }
+        Component result;
+        result.voxels = accumulator.voxels;
+        const double count = static_cast<double>(accumulator.voxels);
+        for (unsigned int a = 0; a < 3; ++a) {
+            result.min[a] = accumulator.min[a];
+            result.max[a] = accumulator.max[a];
+            result.centroid[a] = accumulator.sum[a] / count;
+        }
+        result.mean = accumulator.intensity / count;
+        result.stddev = std::sqrt(std::max(0.0, accumulator.intensitySquared / count - result.mean * result.mean));
+        result.minimum = accumulator.minimum;
+        result.maximum = accumulator.maximum;
+        components.push_back(result);
+        finalLabel[index + 1] = static_cast<std::uint32_t>(components.size());
+    }
+    ParallelUtils::ParallelFor(extent.z, threads, [&](unsigned int, std::size_t z) {
+        std::uint32_t* slice = labels + z * sliceVoxels;
+        for (std::size_t i = 0; i < sliceVoxels; ++i) {
+            slice[i] = finalLabel[slice[i]];
+        }
+    });
+    return components;
+}
+
+} // namespace ConnectedComponents
@@ -0,0 +1,38 @@
+//
+// ConnectedComponents.h
+// DicomToolsCpp
+//
+// Declares the parallel connected-component labeler for binary masks, with per-label statistics.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "VolumeExtent.h"
+
+namespace ConnectedComponents {
+    // One labelled component; positions are voxel indices
+    struct Component {
+        std::uint64_t voxels{0};
+        std::size_t min[3]{0, 0, 0};
+        std::size_t max[3]{0, 0, 0};
+        double centroid[3]{0.0, 0.0, 0.0};
+        // Over the intensity volume's voxels inside the component
+        double mean{0.0};
+        double stddev{0.0};
+        short minimum{0};
+        short maximum{0};
+    };
+
+    // Label the nonzero voxels of `mask` with 6, 18 or 26 connectivity into `labels` (extent.Voxels() entries).
+    // Slabs of slices are labelled in parallel with their own union-find, then joined across slab borders; the pass
+    // that resolves the final labels also accumulates the statistics, read from `intensity` (the mask itself when
+    // null). Components are relabelled 1..N from largest to smallest, and those under `minVoxels` become background.
+    // Returns the kept components, in label order; `removed` receives how many were dropped. workers 0 = auto.
+    std::vector<Component> Label(const short* mask, const short* intensity, const VolumeExtent& extent,
+                                 unsigned int connectivity, std::uint64_t minVoxels, std::uint32_t* labels,
+                                 std::size_t& removed, unsigned int workers = 0);
+}
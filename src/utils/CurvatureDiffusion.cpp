@@ -0,0 +1,378 @@
+//
+// CurvatureDiffusion.cpp
+// DicomToolsCpp
+//
+// Implements modified curvature diffusion over an in-place fp16/fp32 working volume with per-chunk rolling slice windows.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#include "CurvatureDiffusion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "ParallelUtils.h"
+
+namespace CurvatureDiffusion {
+namespace {
+// Same regulariser ITK adds under the gradient-magnitude square roots
+constexpr float kMinNorm = 1.0e-10f;
+// binary16 holds every integer in [-2048, 2048], so an integer-centred span up to this size is stored exactly
+constexpr int kHalfExactSpan = 4096;
+
+const std::vector<float>& HalfTable() {
+    // 256 KiB table: decoding is a load instead of bit twiddling on every neighbour read
+    static const std::vector<float> table = [] {
+        std::vector<float> values(65536);
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            values[i] = HalfToFloat(static_cast<std::uint16_t>(i));
+        }
+        return values;
+    }();
+    return table;
+}
+
+struct HalfCodec {
+    using Stored = std::uint16_t;
+    static Stored Encode(float value) { return FloatToHalf(value); }
+    static float Decode(Stored value, const float* table) { return table[value]; }
+};
+
+struct FloatCodec {
+    using Stored = float;
+    static Stored Encode(float value) { return value; }
+    static float Decode(Stored value, const float*) { return value; }
+};
+
+// Old values of the slice below, at, and above the one being updated; at the volume edges a neighbour repeats
+// the centre slice, which is the zero-flux boundary along z
+struct SliceWindow {
+    std::vector<float> below;
+    std::vector<float> centre;
+    std::vector<float> above;
+};
+
+class Stencil {
+public:
+    Stencil(const SliceWindow& window, std::size_t nx, std::size_t ny, std::size_t x, std::size_t y)
+        : planes_{window.below.data(), window.centre.data(), window.above.data()},
+          xs_{x > 0 ? x - 1 : 0, x, std::min(x + 1, nx - 1)},
+          ys_{y > 0 ? y - 1 : 0, y, std::min(y + 1, ny - 1)},
+          nx_(nx) {}
+
+    // Value at centre + offset, offsets in {-1, 0, 1}, each axis clamped independently (zero-flux borders)
+    float At(int ox, int oy, int oz) const { return planes_[oz + 1][ys_[oy + 1] * nx_ + xs_[ox + 1]]; }
+
+    float Shifted(unsigned int axis, int step, const int base[3]) const {
+        int offset[3] = {base[0], base[1], base[2]};
+        offset[axis] += step;
+        return At(offset[0], offset[1], offset[2]);
+    }
+
+private:
+    const float* planes_[3];
+    std::size_t xs_[3];
+    std::size_t ys_[3];
+    std::size_t nx_;
+};
+
+// Port of itk::CurvatureNDAnisotropicDiffusionFunction::ComputeUpdate for one voxel, in fp32
+float ComputeUpdate(const Stencil& stencil, const float scale[3], float k) {
+    const int origin[3] = {0, 0, 0};
+    const float centre = stencil.At(0, 0, 0);
+    float forward[3];
+    float backward[3];
+    float central[3];
+    for (unsigned int i = 0; i < 3; ++i) {
+        const float plus = stencil.Shifted(i, 1, origin);
+        const float minus = stencil.Shifted(i, -1, origin);
+        forward[i] = (plus - centre) * scale[i];
+        backward[i] = (centre - minus) * scale[i];
+        central[i] = 0.5f * (plus - minus) * scale[i];
+    }
+
+    float speed = 0.0f;
+    for (unsigned int i = 0; i < 3; ++i) {
+        float gradSq = forward[i] * forward[i];
+        float gradSqBack = backward[i] * backward[i];
+        for (unsigned int j = 0; j < 3; ++j) {
+            if (j == i) {
+                continue;
+            }
+            // Central difference along j, taken one voxel forward and one voxel back along i
+            int ahead[3] = {0, 0, 0};
+            ahead[i] = 1;
+            int behind[3] = {0, 0, 0};
+            behind[i] = -1;
+            const float aug = 0.5f * (stencil.Shifted(j, 1, ahead) - stencil.Shifted(j, -1, ahead)) * scale[j];
+            const float dim = 0.5f * (stencil.Shifted(j, 1, behind) - stencil.Shifted(j, -1, behind)) * scale[j];
+            gradSq += 0.25f * (central[j] + aug) * (central[j] + aug);
+            gradSqBack += 0.25f * (central[j] + dim) * (central[j] + dim);
+        }
+        const float gradMag = std::sqrt(kMinNorm + gradSq);
+        const float gradMagBack = std::sqrt(kMinNorm + gradSqBack);
+        const float conductance = k == 0.0f ? 0.0f : std::exp(gradSq / k);
+        const float conductanceBack = k == 0.0f ? 0.0f : std::exp(gradSqBack / k);
+        speed += (forward[i] / gradMag) * conductance - (backward[i] / gradMagBack) * conductanceBack;
+    }
+
+    // Upwind gradient magnitude, as in ITK
+    auto square = [](float value) { return value * value; };
+    float propagation = 0.0f;
+    for (unsigned int i = 0; i < 3; ++i) {
+        if (speed > 0.0f) {
+            propagation += square(std::min(backward[i], 0.0f)) + square(std::max(forward[i], 0.0f));
+        } else {
+            propagation += square(std::max(backward[i], 0.0f)) + square(std::min(forward[i], 0.0f));
+        }
+    }
+    return std::sqrt(propagation) * speed;
+}
+
+template <typename Codec>
+void DiffuseWith(const short* input, short* output, const VolumeExtent& extent, const Parameters& parameters,
+                 float offset, unsigned int workers) {
+    using Stored = typename Codec::Stored;
+    const std::size_t nx = extent.x;
+    const std::size_t ny = extent.y;
+    const std::size_t nz = extent.z;
+    const std::size_t sliceVoxels = extent.SliceVoxels();
+    const std::size_t voxels = extent.Voxels();
+    if (voxels == 0) {
+        return;
+    }
+    const float* table = HalfTable().data();
+
+    const unsigned int threads = ParallelUtils::ResolveWorkerCount(nz, workers);
+    std::vector<Stored> volume(voxels);
+    ParallelUtils::ParallelFor(nz, threads, [&](unsigned int, std::size_t z) {
+        for (std::size_t i = z * sliceVoxels; i < (z + 1) * sliceVoxels; ++i) {
+            volume[i] = Codec::Encode(static_cast<float>(input[i]) - offset);
+        }
+    });
+    auto decodeSlice = [&](std::size_t z, std::vector<float>& into) {
+        into.resize(sliceVoxels);
+        const Stored* source = volume.data() + z * sliceVoxels;
+        for (std::size_t i = 0; i < sliceVoxels; ++i) {
+            into[i] = Codec::Decode(source[i], table);
+        }
+    };
+
+    // Contiguous z chunks, one per worker; each walks its chunk bottom to top with a rolling window
+    const std::size_t chunkSlices = (nz + threads - 1) / threads;
+    const std::size_t chunks = (nz + chunkSlices - 1) / chunkSlices;
+    struct ChunkState {
+        SliceWindow window;
+        std::vector<float> updated;
+        // Old values of the slices just outside the chunk; neighbours may overwrite them first
+        std::vector<float> before;
+        std::vector<float> after;
+    };
+    std::vector<ChunkState> states(std::max<std::size_t>(chunks, threads));
+
+    const float scale[3] = {static_cast<float>(1.0 / parameters.spacing[0]), static_cast<float>(1.0 / parameters.spacing[1]),
+                            static_cast<float>(1.0 / parameters.spacing[2])};
+    const float timeStep = static_cast<float>(parameters.timeStep);
+
+    for (unsigned int iteration = 0; iteration < parameters.iterations; ++iteration) {
+        // Conductance scale: ITK recomputes the mean squared gradient magnitude before every iteration
+        std::vector<double> sums(threads, 0.0);
+        ParallelUtils::ParallelFor(nz, threads, [&](unsigned int worker, std::size_t z) {
+            SliceWindow& window = states[worker].window;
+            decodeSlice(z > 0 ? z - 1 : z, window.below);
+            decodeSlice(z, window.centre);
+            decodeSlice(std::min(z + 1, nz - 1), window.above);
+            double sum = 0.0;
+            for (std::size_t y = 0; y < ny; ++y) {
+                for (std::size_t x = 0; x < nx; ++x) {
+                    const Stencil stencil(window, nx, ny, x, y);
+                    const float dx = 0.5f * (stencil.At(1, 0, 0) - stencil.At(-1, 0, 0)) * scale[0];
+                    const float dy = 0.5f * (stencil.At(0, 1, 0) - stencil.At(0, -1, 0)) * scale[1];
+                    const float dz = 0.5f * (stencil.At(0, 0, 1) - stencil.At(0, 0, -1)) * scale[2];
+                    sum += static_cast<double>(dx * dx + dy * dy + dz * dz);
+                }
+            }
+            sums[worker] += sum;
+        });
+        double total = 0.0;
+        for (double sum : sums) {
+            total += sum;
+        }
+        const float k = static_cast<float>(total / static_cast<double>(voxels) * parameters.conductance *
+                                           parameters.conductance * -2.0);
+
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+            const std::size_t start = chunk * chunkSlices;
+            const std::size_t end = std::min(nz, start + chunkSlices);
+            if (start > 0) {
+                decodeSlice(start - 1, states[chunk].before);
+            }
+            if (end < nz) {
+                decodeSlice(end, states[chunk].after);
+            }
+        }
+
+        ParallelUtils::ParallelFor(chunks, static_cast<unsigned int>(chunks), [&](unsigned int, std::size_t chunk) {
+            ChunkState& state = states[chunk];
+            SliceWindow& window = state.window;
+            const std::size_t start = chunk * chunkSlices;
+            const std::size_t end = std::min(nz, start + chunkSlices);
+            // Old value of slice z (z >= the slice being written); the chunk above may already have rewritten `end`
+            auto loadOld = [&](std::size_t z, std::vector<float>& into) {
+                if (z == end) {
+                    into = state.after;
+                } else {
+                    decodeSlice(z, into);
+                }
+            };
+
+            decodeSlice(start, window.centre);
+            if (start > 0) {
+                window.below = state.before;
+            } else {
+                window.below = window.centre;
+            }
+            if (start + 1 < nz) {
+                loadOld(start + 1, window.above);
+            } else {
+                window.above = window.centre;
+            }
+
+            state.updated.resize(sliceVoxels);
+            for (std::size_t z = start; z < end; ++z) {
+                for (std::size_t y = 0; y < ny; ++y) {
+                    for (std::size_t x = 0; x < nx; ++x) {
+                        const Stencil stencil(window, nx, ny, x, y);
+                        const std::size_t index = y * nx + x;
+                        state.updated[index] = window.centre[index] + timeStep * ComputeUpdate(stencil, scale, k);
+                    }
+                }
+                Stored* target = volume.data() + z * sliceVoxels;
+                for (std::size_t i = 0; i < sliceVoxels; ++i) {
+                    target[i] = Codec::Encode(state.updated[i]);
+                }
+                if (z + 1 == end) {
+                    break;
+                }
+                std::swap(window.below, window.centre);
+                std::swap(window.centre, window.above);
+                if (z + 2 < nz) {
+                    loadOld(z + 2, window.above);
+                } else {
+                    window.above = window.centre;
+                }
+            }
+        });
+    }
+
+    ParallelUtils::ParallelFor(nz, threads, [&](unsigned int, std::size_t z) {
+        for (std::size_t i = z * sliceVoxels; i < (z + 1) * sliceVoxels; ++i) {
+            const float value = std::clamp(Codec::Decode(volume[i], table) + offset,
+                                           static_cast<float>(std::numeric_limits<short>::min()),
+                                           static_cast<float>(std::numeric_limits<short>::max()));
+            output[i] = static_cast<short>(std::lround(value));
+        }
+    });
+}
+} // namespace
+
+Storage EffectiveStorage(const short* input, const VolumeExtent& extent, Storage requested) {
+    if (requested != Storage::Float16 || extent.Voxels() == 0) {
+        return requested;
+    }
+    const auto range = std::minmax_element(input, input + extent.Voxels());
+    return static_cast<int>(*range.second) - static_cast<int>(*range.first) <= kHalfExactSpan ? Storage::Float16
+                                                                                               : Storage::Float32;
+}
+
+void Diffuse(const short* input, short* output, const VolumeExtent& extent, const Parameters& parameters,
+             Storage storage, unsigned int workers) {
+    if (extent.Voxels() == 0) {
+        return;
+    }
+    // Centre the stored values on the input range so fp16 spends its precision on the data's own span. The
+    // offset is a whole number: a half-integer one would put every stored integer halfway between fp16 steps.
+    const auto range = std::minmax_element(input, input + extent.Voxels());
+    const float offset = std::floor(0.5f * (static_cast<float>(*range.first) + static_cast<float>(*range.second)));
+    if (storage == Storage::Float16 &&
+        static_cast<int>(*range.second) - static_cast<int>(*range.first) <= kHalfExactSpan) {
+        DiffuseWith<HalfCodec>(input, output, extent, parameters, offset, workers);
+    } else {
+        DiffuseWith<FloatCodec>(input, output, extent, parameters, offset, workers);
+    }
+}
+
+unsigned int StorageBytes(Storage storage) {
+    return storage == Storage::Float16 ? 2 : 4;
+}
+
+std::uint16_t FloatToHalf(float value) {
+    std::uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const std::uint32_t sign = (bits >> 16) & 0x8000u;
+    const std::uint32_t rawExponent = (bits >> 23) & 0xffu;
+    std::uint32_t mantissa = bits & 0x007fffffu;
+    if (rawExponent == 0xffu) {
+        // Infinity stays infinity; NaN keeps a quiet payload bit
+        return static_cast<std::uint16_t>(sign | 0x7c00u | (mantissa != 0 ? 0x0200u : 0u));
+    }
+    const int exponent = static_cast<int>(rawExponent) - 127 + 15;
+    if (exponent >= 31) {
+        return static_cast<std::uint16_t>(sign | 0x7c00u);
+    }
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return static_cast<std::uint16_t>(sign);
+        }
+        // Subnormal half: shift the full significand down, rounding to nearest even
+        mantissa |= 0x00800000u;
+        const unsigned int shift = static_cast<unsigned int>(14 - exponent);
+        std::uint32_t half = mantissa >> shift;
+        const std::uint32_t remainder = mantissa & ((1u << shift) - 1u);
+        const std::uint32_t halfway = 1u << (shift - 1u);
+        if (remainder > halfway || (remainder == halfway && (half & 1u) != 0)) {
+            ++half;
+        }
+        return static_cast<std::uint16_t>(sign | half);
+    }
+    std::uint32_t half = sign | (static_cast<std::uint32_t>(exponent) << 10) | (mantissa >> 13);
+    const std::uint32_t remainder = mantissa & 0x1fffu;
+    // A carry out of the mantissa correctly bumps the exponent (and overflows to infinity)
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u) != 0)) {
+        ++half;
+    }
+    return static_cast<std::uint16_t>(half);
+}
+
+float HalfToFloat(std::uint16_t value) {
+    const std::uint32_t sign = (static_cast<std::uint32_t>(value) & 0x8000u) << 16;
+    int exponent = (value >> 10) & 0x1f;
+    std::uint32_t mantissa = value & 0x03ffu;
+    std::uint32_t bits = 0;
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // Subnormal: renormalise into a float exponent
+            exponent = 1;
+            while ((mantissa & 0x0400u) == 0) {
+                mantissa <<= 1;
+                --exponent;
+            }
+            mantissa &= 0x03ffu;
+            bits = sign | (static_cast<std::uint32_t>(exponent + 112) << 23) | (mantissa << 13);
+        }
+    } else if (exponent == 31) {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    } else {
+        bits = sign | (static_cast<std::uint32_t>(exponent + 112) << 23) | (mantissa << 13);
+    }
+    float result = 0.0f;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+} // namespace CurvatureDiffusion
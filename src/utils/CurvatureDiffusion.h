@@ -0,0 +1,48 @@
+//
+// CurvatureDiffusion.h
+// DicomToolsCpp
+//
+// Declares the in-house curvature anisotropic diffusion that keeps its working volume in fp16 and computes in fp32.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include <cstdint>
+
+#include "VolumeExtent.h"
+
+namespace CurvatureDiffusion {
+    struct Parameters {
+        unsigned int iterations{5};
+        double timeStep{0.0625};
+        double conductance{2.0};
+        // mm per voxel; derivatives are scaled by 1/spacing as ITK does with image spacing enabled
+        double spacing[3]{1.0, 1.0, 1.0};
+    };
+
+    enum class Storage {
+        Float32,
+        // Values are stored relative to the (whole-number) middle of the input range. fp16 is exact for integers in
+        // [-2048, 2048], so inputs spanning at most 4096 values are stored without loss; wider inputs fall back to
+        // Float32 (see EffectiveStorage), since fp16 steps grow to 2 and beyond past that.
+        Float16,
+    };
+
+    // Same update as itk::CurvatureAnisotropicDiffusionImageFilter (modified curvature diffusion equation,
+    // conductance rescaled by the mean squared gradient every iteration, zero-flux borders). The working volume
+    // is updated in place: z chunks run in parallel, each sliding a window of three fp32 slices through it.
+    // Peak memory is the working volume plus a few slices per worker. `output` must not alias `input`.
+    void Diffuse(const short* input, short* output, const VolumeExtent& extent, const Parameters& parameters,
+                 Storage storage, unsigned int workers = 0);
+
+    // Storage Diffuse actually uses for this input: Float16 becomes Float32 when the value span exceeds 4096
+    Storage EffectiveStorage(const short* input, const VolumeExtent& extent, Storage requested);
+
+    // Bytes per voxel of the working volume for a storage mode
+    unsigned int StorageBytes(Storage storage);
+
+    // IEEE 754 binary16 conversions (round to nearest even)
+    std::uint16_t FloatToHalf(float value);
+    float HalfToFloat(std::uint16_t value);
+}
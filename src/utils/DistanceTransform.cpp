@@ -0,0 +1,185 @@
+//
+// DistanceTransform.cpp
+// DicomToolsCpp
+//
+// Implements the separable exact EDT: squared distances along x come from a two-way scan of the packed rows, then
+// the y and z passes replace every line with the lower envelope of parabolas rooted at its samples.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#include "DistanceTransform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "ParallelUtils.h"
+
+namespace DistanceTransform {
+namespace {
+// Stands in for "no feature yet"; finite so the envelope arithmetic stays well defined
+constexpr double kFar = 1e20;
+// Anything this large is still unreached; the float round trip moves kFar by a few ulps either way
+constexpr double kUnreached = kFar * 0.5;
+
+// Columns gathered per task in the y and z passes, so each strided read pulls a run of adjacent floats
+constexpr std::size_t kBlock = 16;
+
+struct LineBuffers {
+    std::vector<double> f;
+    std::vector<double> d;
+    std::vector<double> boundaries;
+    std::vector<std::size_t> roots;
+};
+
+// Felzenszwalb-Huttenlocher: d[q] = min_p (q - p)^2 h^2 + f[p] in O(n)
+void EnvelopeLine(const double* f, std::size_t n, double h, LineBuffers& line) {
+    double* boundaries = line.boundaries.data();
+    std::size_t* roots = line.roots.data();
+    std::size_t k = 0;
+    roots[0] = 0;
+    boundaries[0] = -std::numeric_limits<double>::infinity();
+    boundaries[1] = std::numeric_limits<double>::infinity();
+    for (std::size_t q = 1; q < n; ++q) {
+        const double position = static_cast<double>(q) * h;
+        double crossing = 0.0;
+        while (true) {
+            const double root = static_cast<double>(roots[k]) * h;
+            crossing = ((f[q] + position * position) - (f[roots[k]] + root * root)) / (2.0 * (position - root));
+            // boundaries[0] is -infinity, so this always stops at the first parabola
+            if (crossing > boundaries[k]) {
+                break;
+            }
+            --k;
+        }
+        ++k;
+        roots[k] = q;
+        boundaries[k] = crossing;
+        boundaries[k + 1] = std::numeric_limits<double>::infinity();
+    }
+    k = 0;
+    for (std::size_t q = 0; q < n; ++q) {
+        const double position = static_cast<double>(q) * h;
+        while (boundaries[k + 1] < position) {
+            ++k;
+        }
+        const double offset = position - static_cast<double>(roots[k]) * h;
+        line.d[q] = offset * offset + f[roots[k]];
+    }
+}
+
+// First pass: along x the nearest voxel whose bit equals `feature` is found by one scan each way, which is cheaper
+// than the envelope; writes squared distances
+void SeedRows(const BinaryMorphology::PackedMask& mask, bool feature, double spacing, float* field,
+              unsigned int threads) {
+    const VolumeExtent& extent = mask.extent;
+    const float far = static_cast<float>(kFar);
+    ParallelUtils::ParallelFor(extent.z, threads, [&](unsigned int, std::size_t z) {
+        for (std::size_t y = 0; y < extent.y; ++y) {
+            float* row = field + (z * extent.y + y) * extent.x;
+            const std::uint64_t* bits = mask.Row(y, z);
+            const std::uint64_t flip = feature ? 0 : ~std::uint64_t{0};
+            std::size_t last = extent.x;
+            for (std::size_t x = 0; x < extent.x; ++x) {
+                if (((bits[x / 64] ^ flip) >> (x % 64)) & 1u) {
+                    last = x;
+                    row[x] = 0.0f;
+                } else if (last == extent.x) {
+                    row[x] = far;
+                } else {
+                    const double offset = static_cast<double>(x - last) * spacing;
+                    row[x] = static_cast<float>(offset * offset);
+                }
+            }
+            last = extent.x;
+            for (std::size_t x = extent.x; x-- > 0;) {
+                if (row[x] == 0.0f) {
+                    last = x;
+                } else if (last != extent.x) {
+                    const double offset = static_cast<double>(last - x) * spacing;
+                    row[x] = std::min(row[x], static_cast<float>(offset * offset));
+                }
+            }
+        }
+    });
+}
+
+// y or z pass: each task owns one index of the other slow axis and walks x in blocks of adjacent columns
+void Pass(float* field, const VolumeExtent& extent, unsigned int axis, double spacing,
+          std::vector<LineBuffers>& buffers, unsigned int threads) {
+    const std::size_t n = axis == 1 ? extent.y : extent.z;
+    const std::size_t stride = axis == 1 ? extent.x : extent.SliceVoxels();
+    const std::size_t outerCount = axis == 1 ? extent.z : extent.y;
+    const std::size_t outerStride = axis == 1 ? extent.SliceVoxels() : extent.x;
+    ParallelUtils::ParallelFor(outerCount, threads, [&](unsigned int worker, std::size_t outer) {
+        LineBuffers& line = buffers[worker];
+        for (std::size_t x0 = 0; x0 < extent.x; x0 += kBlock) {
+            const std::size_t width = std::min(kBlock, extent.x - x0);
+            float* base = field + outer * outerStride + x0;
+            // Lines with no finite sample, or nothing but features, are already final
+            bool reached[kBlock] = {};
+            bool open[kBlock] = {};
+            for (std::size_t q = 0; q < n; ++q) {
+                const float* source = base + q * stride;
+                for (std::size_t b = 0; b < width; ++b) {
+                    line.f[b * n + q] = source[b];
+                    reached[b] = reached[b] || source[b] < kUnreached;
+                    open[b] = open[b] || source[b] > 0.0f;
+                }
+            }
+            for (std::size_t b = 0; b < width; ++b) {
+                if (!reached[b] || !open[b]) {
+                    continue;
+                }
+                EnvelopeLine(line.f.data() + b * n, n, spacing, line);
+                for (std::size_t q = 0; q < n; ++q) {
+                    base[q * stride + b] = static_cast<float>(std::min(line.d[q], kFar));
+                }
+            }
+        }
+    });
+}
+
+void SquaredDistance(const BinaryMorphology::PackedMask& mask, bool feature, const double spacing[3], float* field,
+                     std::vector<LineBuffers>& buffers, unsigned int threads) {
+    SeedRows(mask, feature, spacing[0], field, threads);
+    Pass(field, mask.extent, 1, spacing[1], buffers, threads);
+    Pass(field, mask.extent, 2, spacing[2], buffers, threads);
+}
+} // namespace
+
+void Signed(const BinaryMorphology::PackedMask& mask, const double spacing[3], float* output, unsigned int workers) {
+    const VolumeExtent& extent = mask.extent;
+    const std::size_t voxels = extent.Voxels();
+    if (voxels == 0) {
+        return;
+    }
+    const std::size_t longest = std::max({extent.x, extent.y, extent.z});
+    const unsigned int threads = ParallelUtils::ResolveWorkerCount(std::max(extent.y, extent.z), workers);
+    std::vector<LineBuffers> buffers(threads);
+    for (LineBuffers& line : buffers) {
+        line.f.resize(longest * kBlock);
+        line.d.resize(longest);
+        line.boundaries.resize(longest + 1);
+        line.roots.resize(longest);
+    }
+
+    SquaredDistance(mask, true, spacing, output, buffers, threads);
+    std::vector<float> inside(voxels);
+    SquaredDistance(mask, false, spacing, inside.data(), buffers, threads);
+
+    const float far = static_cast<float>(kUnreached);
+    const float infinity = std::numeric_limits<float>::infinity();
+    ParallelUtils::ParallelFor(extent.z, threads, [&](unsigned int, std::size_t z) {
+        const std::size_t first = z * extent.SliceVoxels();
+        for (std::size_t i = first; i < first + extent.SliceVoxels(); ++i) {
+            if (output[i] == 0.0f) {
+                output[i] = inside[i] >= far ? -infinity : -std::sqrt(inside[i]);
+            } else {
+                output[i] = output[i] >= far ? infinity : std::sqrt(output[i]);
+            }
+        }
+    });
+}
+
+} // namespace DistanceTransform
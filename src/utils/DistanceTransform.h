@@ -0,0 +1,21 @@
+//
+// DistanceTransform.h
+// DicomToolsCpp
+//
+// Declares the exact separable Euclidean distance transform for packed binary masks.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include "BinaryMorphology.h"
+
+namespace DistanceTransform {
+    // Signed Euclidean distance in mm between voxel centres, written to `output` (extent.Voxels() entries):
+    // background voxels get the distance to the nearest foreground voxel, foreground voxels minus the distance to
+    // the nearest background voxel. Exact, via the Felzenszwalb-Huttenlocher lower envelope of parabolas run along
+    // x, then y, then z, with the lines of each pass spread across workers (0 = auto). A mask with no foreground
+    // (or no background) leaves infinity on that side.
+    void Signed(const BinaryMorphology::PackedMask& mask, const double spacing[3], float* output,
+                unsigned int workers = 0);
+}
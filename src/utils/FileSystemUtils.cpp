@@ -8,9 +8,20 @@
 
 #include "FileSystemUtils.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <filesystem>
 #include <iostream>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace fs = std::filesystem;
 
 namespace FileSystemUtils {
@@ -45,4 +56,92 @@ bool EnsureOutputDir(const std::string& path) {
     return true;
 }
 
+bool IsPathSafeUID(const std::string& uid) {
+    return !uid.empty() && uid.size() <= 64 &&
+           std::all_of(uid.begin(), uid.end(), [](char c) { return c == '.' || (c >= '0' && c <= '9'); });
+}
+
+const char* StageMethodName(StageMethod method) {
+    switch (method) {
+        case StageMethod::Reflink: return "reflink";
+        case StageMethod::Hardlink: return "hardlink";
+        case StageMethod::CopyRange: return "copy_file_range";
+        case StageMethod::Copy: return "copy";
+    }
+    return "unknown";
+}
+
+bool StageFile(const std::string& source, const std::string& dest, StageMethod& method, std::string& error) {
+    std::error_code ec;
+    fs::remove(dest, ec);
+
+#ifdef __linux__
+    int in = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+    struct stat info {};
+    if (::fstat(in, &info) != 0) {
+        error = std::strerror(errno);
+        ::close(in);
+        return false;
+    }
+
+#ifdef FICLONE
+    // Reflink shares extents copy-on-write (btrfs, XFS with reflink=1): no data is duplicated
+    int out = ::open(dest.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, info.st_mode & 0777);
+    if (out >= 0) {
+        const bool cloned = ::ioctl(out, FICLONE, in) == 0;
+        ::close(out);
+        if (cloned) {
+            ::close(in);
+            method = StageMethod::Reflink;
+            return true;
+        }
+        ::unlink(dest.c_str());
+    }
+#endif
+
+    // A hardlink is free on the same filesystem; media consumers only read the staged files
+    if (::link(source.c_str(), dest.c_str()) == 0) {
+        ::close(in);
+        method = StageMethod::Hardlink;
+        return true;
+    }
+
+    // copy_file_range keeps the copy in the kernel (and is server-side on NFS/SMB)
+    int target = ::open(dest.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, info.st_mode & 0777);
+    if (target >= 0) {
+        off_t remaining = info.st_size;
+        bool ok = true;
+        while (remaining > 0) {
+            const ssize_t written = ::copy_file_range(in, nullptr, target, nullptr, static_cast<size_t>(remaining), 0);
+            if (written <= 0) {
+                ok = false;
+                break;
+            }
+            remaining -= written;
+        }
+        ::close(target);
+        if (ok) {
+            ::close(in);
+            method = StageMethod::CopyRange;
+            return true;
+        }
+        ::unlink(dest.c_str());
+    }
+    ::close(in);
+#endif
+
+    // Portable fallback (also covers cross-device moves where copy_file_range reports EXDEV)
+    fs::copy_file(source, dest, fs::copy_options::overwrite_existing, ec);
+    if (ec) {
+        error = ec.message();
+        return false;
+    }
+    method = StageMethod::Copy;
+    return true;
+}
+
 } // namespace FileSystemUtils
@@ -15,4 +15,15 @@ namespace FileSystemUtils {
     std::string FindFirstDicom(const std::string& inputDir);
     // Ensure the destination directory exists and is a folder
     bool EnsureOutputDir(const std::string& path);
+    // True when a UID received from a peer is safe to use as a file or directory name: 1-64 digits and dots only,
+    // so separators, ".." and absolute paths cannot escape the folder it is joined to
+    bool IsPathSafeUID(const std::string& uid);
+
+    // How a file ended up in a staging tree, cheapest first
+    enum class StageMethod { Reflink, Hardlink, CopyRange, Copy };
+    const char* StageMethodName(StageMethod method);
+    // Place source at dest without duplicating data when the filesystem allows it:
+    // FICLONE reflink, then a hardlink, then in-kernel copy_file_range, then a plain copy.
+    // Overwrites dest; the parent directory must already exist. Safe to call from several threads.
+    bool StageFile(const std::string& source, const std::string& dest, StageMethod& method, std::string& error);
 }
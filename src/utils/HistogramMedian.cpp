@@ -0,0 +1,188 @@
+//
+// HistogramMedian.cpp
+// DicomToolsCpp
+//
+// Implements Huang's running-median scheme in 3D over rank-compressed int16 values with a two-level histogram.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#include "HistogramMedian.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "ParallelUtils.h"
+
+namespace HistogramMedian {
+namespace {
+// Fine bins are grouped in blocks of 256 so the median can jump over empty stretches a block at a time
+constexpr std::size_t kBlockBits = 8;
+constexpr std::size_t kBlockSize = std::size_t{1} << kBlockBits;
+
+// Window histogram that tracks its median incrementally: `median` is the bin holding the target rank and
+// `below` counts the samples in lower bins, so adds and removes only adjust `below` and Seek walks from there.
+class RunningHistogram {
+public:
+    explicit RunningHistogram(std::size_t bins)
+        : fine_(((bins + kBlockSize - 1) / kBlockSize) * kBlockSize, 0), coarse_(fine_.size() / kBlockSize, 0) {}
+
+    void Add(std::uint16_t bin) {
+        ++fine_[bin];
+        ++coarse_[bin >> kBlockBits];
+        below_ += bin < median_ ? 1 : 0;
+    }
+
+    void Remove(std::uint16_t bin) {
+        --fine_[bin];
+        --coarse_[bin >> kBlockBits];
+        below_ -= bin < median_ ? 1 : 0;
+    }
+
+    // Bin holding the sample of 0-based rank `target`
+    std::size_t Seek(std::size_t target) {
+        while (below_ > target) {
+            if ((median_ & (kBlockSize - 1)) == 0 && below_ - coarse_[(median_ >> kBlockBits) - 1] > target) {
+                below_ -= coarse_[(median_ >> kBlockBits) - 1];
+                median_ -= kBlockSize;
+                continue;
+            }
+            --median_;
+            below_ -= fine_[median_];
+        }
+        while (below_ + fine_[median_] <= target) {
+            if ((median_ & (kBlockSize - 1)) == 0 && below_ + coarse_[median_ >> kBlockBits] <= target) {
+                below_ += coarse_[median_ >> kBlockBits];
+                median_ += kBlockSize;
+                continue;
+            }
+            below_ += fine_[median_];
+            ++median_;
+        }
+        return median_;
+    }
+
+    // Only valid once every sample has been removed again
+    void Rewind() {
+        median_ = 0;
+        below_ = 0;
+    }
+
+private:
+    std::vector<std::uint32_t> fine_;
+    std::vector<std::uint32_t> coarse_;
+    std::size_t median_{0};
+    std::size_t below_{0};
+};
+} // namespace
+
+void Filter(const short* input, short* output, const VolumeExtent& extent, const unsigned int radius[3],
+            unsigned int workers) {
+    const std::size_t voxels = extent.Voxels();
+    if (voxels == 0) {
+        return;
+    }
+
+    // Rank compression: the median commutes with any order-preserving map, and CT volumes use a few thousand of the
+    // 65536 possible values, so ranks keep the histogram dense and the median walk short.
+    std::vector<std::uint8_t> present(65536, 0);
+    for (std::size_t i = 0; i < voxels; ++i) {
+        present[static_cast<std::uint16_t>(input[i] + 32768)] = 1;
+    }
+    std::vector<std::uint16_t> rankOf(65536, 0);
+    std::vector<short> valueOf;
+    for (std::size_t v = 0; v < present.size(); ++v) {
+        if (present[v]) {
+            rankOf[v] = static_cast<std::uint16_t>(valueOf.size());
+            valueOf.push_back(static_cast<short>(static_cast<int>(v) - 32768));
+        }
+    }
+    std::vector<std::uint16_t> ranks(voxels);
+    const std::size_t sliceVoxels = extent.SliceVoxels();
+    const unsigned int threads = ParallelUtils::ResolveWorkerCount(extent.z, workers);
+    ParallelUtils::ParallelFor(extent.z, threads, [&](unsigned int, std::size_t z) {
+        const std::size_t begin = z * sliceVoxels;
+        for (std::size_t i = begin; i < begin + sliceVoxels; ++i) {
+            ranks[i] = rankOf[static_cast<std::uint16_t>(input[i] + 32768)];
+        }
+    });
+
+    const std::ptrdiff_t rx = radius[0];
+    const std::ptrdiff_t ry = radius[1];
+    const std::ptrdiff_t rz = radius[2];
+    const std::size_t windowVoxels = static_cast<std::size_t>((2 * rx + 1) * (2 * ry + 1) * (2 * rz + 1));
+    const std::size_t target = windowVoxels / 2;
+    const std::ptrdiff_t nx = static_cast<std::ptrdiff_t>(extent.x);
+    const std::ptrdiff_t ny = static_cast<std::ptrdiff_t>(extent.y);
+    const std::ptrdiff_t nz = static_cast<std::ptrdiff_t>(extent.z);
+    auto clampTo = [](std::ptrdiff_t index, std::ptrdiff_t size) { return std::clamp<std::ptrdiff_t>(index, 0, size - 1); };
+
+    struct Scratch {
+        std::vector<RunningHistogram> histogram;
+        std::vector<const std::uint16_t*> rows;
+    };
+    std::vector<Scratch> scratch(threads);
+
+    ParallelUtils::ParallelFor(extent.z, threads, [&](unsigned int worker, std::size_t sliceIndex) {
+        Scratch& local = scratch[worker];
+        if (local.histogram.empty()) {
+            local.histogram.emplace_back(valueOf.size());
+        }
+        RunningHistogram& histogram = local.histogram.front();
+        const std::ptrdiff_t z = static_cast<std::ptrdiff_t>(sliceIndex);
+
+        for (std::ptrdiff_t y = 0; y < ny; ++y) {
+            // The window's rows (y, z neighbours, edge-replicated) stay fixed while it slides along x
+            local.rows.clear();
+            for (std::ptrdiff_t dz = -rz; dz <= rz; ++dz) {
+                const std::uint16_t* slice = ranks.data() + static_cast<std::size_t>(clampTo(z + dz, nz)) * sliceVoxels;
+                for (std::ptrdiff_t dy = -ry; dy <= ry; ++dy) {
+                    local.rows.push_back(slice + static_cast<std::size_t>(clampTo(y + dy, ny) * nx));
+                }
+            }
+            auto addColumn = [&](std::ptrdiff_t x) {
+                const std::ptrdiff_t column = clampTo(x, nx);
+                for (const std::uint16_t* row : local.rows) {
+                    histogram.Add(row[column]);
+                }
+            };
+            auto removeColumn = [&](std::ptrdiff_t x) {
+                const std::ptrdiff_t column = clampTo(x, nx);
+                for (const std::uint16_t* row : local.rows) {
+                    histogram.Remove(row[column]);
+                }
+            };
+            // One step along x swaps the trailing face for the leading one; near the edges both clamp to the same
+            // column and the window does not change
+            auto slideColumn = [&](std::ptrdiff_t leaving, std::ptrdiff_t entering) {
+                const std::ptrdiff_t from = clampTo(leaving, nx);
+                const std::ptrdiff_t to = clampTo(entering, nx);
+                if (from == to) {
+                    return;
+                }
+                for (const std::uint16_t* row : local.rows) {
+                    histogram.Remove(row[from]);
+                    histogram.Add(row[to]);
+                }
+            };
+
+            for (std::ptrdiff_t dx = -rx; dx <= rx; ++dx) {
+                addColumn(dx);
+            }
+            short* outRow = output + static_cast<std::size_t>(z) * sliceVoxels + static_cast<std::size_t>(y * nx);
+            for (std::ptrdiff_t x = 0; x < nx; ++x) {
+                outRow[x] = valueOf[histogram.Seek(target)];
+                if (x + 1 < nx) {
+                    slideColumn(x - rx, x + 1 + rx);
+                }
+            }
+            // Empty the histogram by removing the last window rather than clearing every bin
+            for (std::ptrdiff_t dx = -rx; dx <= rx; ++dx) {
+                removeColumn(nx - 1 + dx);
+            }
+            histogram.Rewind();
+        }
+    });
+}
+
+} // namespace HistogramMedian
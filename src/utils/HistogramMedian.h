@@ -0,0 +1,20 @@
+//
+// HistogramMedian.h
+// DicomToolsCpp
+//
+// Declares the sliding-histogram median filter for 16-bit volumes, whose cost grows with the window face, not its volume.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include "VolumeExtent.h"
+
+namespace HistogramMedian {
+    // Median over a (2rx+1) x (2ry+1) x (2rz+1) box with replicated edge voxels, matching itk::MedianImageFilter
+    // voxel for voxel. Each output row slides one histogram along x, so a step adds and removes one box face
+    // instead of re-sorting the box. Slices run in parallel on `workers` threads (0 = auto).
+    // `output` must not alias `input`.
+    void Filter(const short* input, short* output, const VolumeExtent& extent, const unsigned int radius[3],
+                unsigned int workers = 0);
+}
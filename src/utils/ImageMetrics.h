@@ -0,0 +1,57 @@
+//
+// ImageMetrics.h
+// DicomToolsCpp
+//
+// Declares PSNR, max-abs-error and SSIM scoring used to compare lossy encodes against their source pixels.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace ImageMetrics {
+    struct ErrorStats {
+        // Aggregated over every plane fed to the accumulator
+        double mse{0.0};
+        double psnr{0.0};          // dB; infinity when the planes are identical
+        double maxAbsError{0.0};
+        double ssim{1.0};          // mean over 8x8 windows (stride 4)
+        std::size_t samples{0};
+    };
+
+    // Scores a multi-frame object one plane at a time so callers never need every decoded frame in memory
+    class Accumulator {
+    public:
+        // peak is the largest representable sample value (255 for 8-bit, 2^bits-1 for stored values)
+        explicit Accumulator(double peak);
+
+        void AddPlane(const float* reference, const float* test, std::size_t width, std::size_t height);
+
+        // Convenience for integer pixel buffers; converts through reused float scratch
+        template <typename T>
+        void AddPlane(const T* reference, const T* test, std::size_t width, std::size_t height) {
+            const std::size_t count = width * height;
+            referenceScratch_.resize(count);
+            testScratch_.resize(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                referenceScratch_[i] = static_cast<float>(reference[i]);
+                testScratch_[i] = static_cast<float>(test[i]);
+            }
+            AddPlane(referenceScratch_.data(), testScratch_.data(), width, height);
+        }
+
+        ErrorStats Result() const;
+
+    private:
+        double peak_;
+        double squaredError_{0.0};
+        double maxAbsError_{0.0};
+        double ssimSum_{0.0};
+        std::size_t ssimWindows_{0};
+        std::size_t samples_{0};
+        std::vector<float> referenceScratch_;
+        std::vector<float> testScratch_;
+    };
+}
@@ -0,0 +1,167 @@
+//
+// ParallelDeflate.cpp
+// DicomToolsCpp
+//
+// Implements block-parallel raw deflate on top of zlib, following the pigz approach of dictionary-primed, sync-flushed chunks.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#include "ParallelDeflate.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+
+#include "ParallelUtils.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace ParallelDeflate {
+
+#ifdef HAVE_ZLIB
+
+namespace {
+// Deflate's window: the most history a block can reference, so the most a dictionary needs to carry
+constexpr std::size_t kWindowSize = 32 * 1024;
+
+bool DeflateBlock(const std::uint8_t* data, std::size_t size, const std::uint8_t* dictionary, std::size_t dictionarySize,
+                  int level, bool last, std::vector<std::uint8_t>& out) {
+    z_stream stream{};
+    // Negative window bits = raw deflate, which is what DICOM wraps (PS3.5 A.5)
+    if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    if (dictionarySize > 0 &&
+        deflateSetDictionary(&stream, dictionary, static_cast<uInt>(dictionarySize)) != Z_OK) {
+        deflateEnd(&stream);
+        return false;
+    }
+
+    // Bound covers a Z_FINISH in one call; the extra bytes cover the empty stored block a sync flush appends
+    out.resize(deflateBound(&stream, static_cast<uLong>(size)) + 16);
+    stream.next_in = const_cast<Bytef*>(data);
+    stream.avail_in = static_cast<uInt>(size);
+    const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    int status = Z_OK;
+    std::size_t produced = 0;
+    for (;;) {
+        if (produced == out.size()) {
+            out.resize(out.size() * 2);
+        }
+        stream.next_out = out.data() + produced;
+        stream.avail_out = static_cast<uInt>(out.size() - produced);
+        status = deflate(&stream, flush);
+        produced = out.size() - stream.avail_out;
+        if (status == Z_STREAM_ERROR) {
+            break;
+        }
+        // A flush is complete once deflate leaves output space unused; Z_FINISH reports it explicitly
+        if (last ? status == Z_STREAM_END : (stream.avail_in == 0 && stream.avail_out != 0)) {
+            break;
+        }
+    }
+    deflateEnd(&stream);
+    out.resize(produced);
+    return last ? status == Z_STREAM_END : status != Z_STREAM_ERROR;
+}
+} // namespace
+
+bool Available() {
+    return true;
+}
+
+bool Compress(const std::uint8_t* data, std::size_t size, int level, unsigned int workers,
+              std::vector<std::uint8_t>& out, std::size_t blockSize) {
+    level = std::clamp(level, 0, 9);
+    // Keep chunks comfortably above the window so the dictionary overlap stays a small fraction of the work,
+    // and below uInt range so every chunk fits in a single deflate call
+    blockSize = std::clamp<std::size_t>(blockSize, 2 * kWindowSize, static_cast<std::size_t>(UINT_MAX / 2));
+    const std::size_t blockCount = std::max<std::size_t>(1, (size + blockSize - 1) / blockSize);
+
+    std::vector<std::vector<std::uint8_t>> blocks(blockCount);
+    std::atomic<bool> failed{false};
+    ParallelUtils::ParallelFor(blockCount, workers,
+                               [&](unsigned int, std::size_t index) {
+        const std::size_t begin = index * blockSize;
+        const std::size_t length = std::min(blockSize, size - std::min(size, begin));
+        const std::size_t dictionarySize = std::min(begin, kWindowSize);
+        if (!DeflateBlock(data + begin, length, data + begin - dictionarySize, dictionarySize, level,
+                          index + 1 == blockCount, blocks[index])) {
+            failed.store(true);
+        }
+    });
+    if (failed.load()) {
+        return false;
+    }
+
+    // Sync-flushed blocks end byte-aligned without BFINAL, so plain concatenation is one stream
+    std::size_t total = 0;
+    for (const auto& block : blocks) {
+        total += block.size();
+    }
+    out.clear();
+    out.reserve(total);
+    for (const auto& block : blocks) {
+        out.insert(out.end(), block.begin(), block.end());
+    }
+    return true;
+}
+
+bool Decompress(const std::uint8_t* data, std::size_t size, std::vector<std::uint8_t>& out) {
+    z_stream stream{};
+    if (inflateInit2(&stream, -15) != Z_OK) {
+        return false;
+    }
+    out.clear();
+    // DICOM datasets deflate well; start at 4x and double as needed
+    out.resize(std::max<std::size_t>(64 * 1024, size * 4));
+    std::size_t consumed = 0;
+    std::size_t produced = 0;
+    int status = Z_OK;
+    while (status == Z_OK) {
+        if (produced == out.size()) {
+            out.resize(out.size() * 2);
+        }
+        const std::size_t inChunk = std::min<std::size_t>(size - consumed, UINT_MAX);
+        const std::size_t outChunk = std::min<std::size_t>(out.size() - produced, UINT_MAX);
+        stream.next_in = const_cast<Bytef*>(data + consumed);
+        stream.avail_in = static_cast<uInt>(inChunk);
+        stream.next_out = out.data() + produced;
+        stream.avail_out = static_cast<uInt>(outChunk);
+        status = inflate(&stream, Z_NO_FLUSH);
+        consumed += inChunk - stream.avail_in;
+        produced += outChunk - stream.avail_out;
+        if (status == Z_BUF_ERROR && stream.avail_out != 0) {
+            // No progress possible with output space left: the input ended before the final block
+            break;
+        }
+        if (status == Z_BUF_ERROR) {
+            status = Z_OK;
+        }
+    }
+    inflateEnd(&stream);
+    out.resize(produced);
+    return status == Z_STREAM_END;
+}
+
+#else
+
+bool Available() {
+    return false;
+}
+
+bool Compress(const std::uint8_t*, std::size_t, int, unsigned int, std::vector<std::uint8_t>& out, std::size_t) {
+    out.clear();
+    return false;
+}
+
+bool Decompress(const std::uint8_t*, std::size_t, std::vector<std::uint8_t>& out) {
+    out.clear();
+    return false;
+}
+
+#endif
+
+} // namespace ParallelDeflate
@@ -0,0 +1,25 @@
+//
+// ParallelDeflate.h
+// DicomToolsCpp
+//
+// Declares a pigz-style block-parallel raw deflate compressor and the matching inflater used for Deflated Explicit VR files.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ParallelDeflate {
+    // False when the build did not find zlib; Compress/Decompress then always fail
+    bool Available();
+    // Produce one raw RFC 1951 stream (no zlib/gzip wrapper, as DICOM requires) from `size` bytes.
+    // Input is cut into blockSize chunks deflated on up to `workers` threads; every chunk is primed with the
+    // previous 32 KiB as a dictionary and closed with a sync flush, so the concatenation is a single valid stream.
+    bool Compress(const std::uint8_t* data, std::size_t size, int level, unsigned int workers,
+                  std::vector<std::uint8_t>& out, std::size_t blockSize = 128 * 1024);
+    // Inflate a raw deflate stream; trailing bytes after the final block (e.g. a pad byte) are ignored
+    bool Decompress(const std::uint8_t* data, std::size_t size, std::vector<std::uint8_t>& out);
+}
@@ -0,0 +1,80 @@
+//
+// ParallelUtils.cpp
+// DicomToolsCpp
+//
+// Implements the shared-counter parallel loop used by hashing, staging, and batch commands.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#include "ParallelUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ParallelUtils {
+
+unsigned int ResolveWorkerCount(std::size_t workItems, unsigned int requested) {
+    unsigned int workers = requested;
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (workItems < workers) {
+        workers = static_cast<unsigned int>(std::max<std::size_t>(1, workItems));
+    }
+    return workers;
+}
+
+void ParallelFor(std::size_t count, unsigned int workers, const std::function<void(unsigned int, std::size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+    workers = ResolveWorkerCount(count, workers);
+
+    // Single worker: run inline so callers get plain serial behavior (and debuggable stacks)
+    if (workers == 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            fn(0, i);
+        }
+        return;
+    }
+
+    // Dynamic scheduling keeps threads busy when items have very different costs (e.g. compressed frames)
+    std::atomic<std::size_t> next{0};
+    std::exception_ptr firstError;
+    std::mutex errorMutex;
+
+    auto run = [&](unsigned int worker) {
+        try {
+            for (std::size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+                fn(worker, i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!firstError) {
+                firstError = std::current_exception();
+            }
+            // Drain the counter so the other workers stop early
+            next.store(count);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (unsigned int w = 1; w < workers; ++w) {
+        threads.emplace_back(run, w);
+    }
+    run(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+}
+
+} // namespace ParallelUtils
@@ -0,0 +1,20 @@
+//
+// ParallelUtils.h
+// DicomToolsCpp
+//
+// Declares a minimal work-sharing helper used to spread per-frame and per-file jobs across threads.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace ParallelUtils {
+    // Pick a worker count for a job: 0 means "use the hardware", and we never exceed the number of items
+    unsigned int ResolveWorkerCount(std::size_t workItems, unsigned int requested = 0);
+    // Run fn(worker, index) for every index in [0, count) on up to `workers` threads pulling from a shared counter.
+    // The worker id is stable per thread so callers can keep per-thread readers/buffers in a vector.
+    void ParallelFor(std::size_t count, unsigned int workers, const std::function<void(unsigned int, std::size_t)>& fn);
+}
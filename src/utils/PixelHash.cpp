@@ -0,0 +1,211 @@
+//
+// PixelHash.cpp
+// DicomToolsCpp
+//
+// Implements an incremental MurmurHash3 x64/128 used to fingerprint decoded pixel frames.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#include "PixelHash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+constexpr std::uint64_t kC1 = 0x87c37b91114253d5ULL;
+constexpr std::uint64_t kC2 = 0x4cf5ad432745937fULL;
+
+inline std::uint64_t Rotl(std::uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline std::uint64_t Load64(const unsigned char* p) {
+    // memcpy keeps unaligned loads legal; the digest assumes little-endian lanes like the reference code
+    std::uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline std::uint64_t FinalMix(std::uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+}
+
+namespace PixelHash {
+
+Hasher::Hasher(std::uint64_t seed) : h1_(seed), h2_(seed) {}
+
+void Hasher::ProcessBlock(const unsigned char* block) {
+    std::uint64_t k1 = Load64(block);
+    std::uint64_t k2 = Load64(block + 8);
+
+    k1 *= kC1;
+    k1 = Rotl(k1, 31);
+    k1 *= kC2;
+    h1_ ^= k1;
+    h1_ = Rotl(h1_, 27);
+    h1_ += h2_;
+    h1_ = h1_ * 5 + 0x52dce729;
+
+    k2 *= kC2;
+    k2 = Rotl(k2, 33);
+    k2 *= kC1;
+    h2_ ^= k2;
+    h2_ = Rotl(h2_, 31);
+    h2_ += h1_;
+    h2_ = h2_ * 5 + 0x38495ab5;
+}
+
+void Hasher::Update(const void* data, std::size_t length) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    totalLength_ += length;
+
+    // Top up a partially filled block left over from the previous call
+    if (tailLength_ > 0) {
+        const std::size_t take = std::min<std::size_t>(16 - tailLength_, length);
+        std::memcpy(tail_ + tailLength_, bytes, take);
+        tailLength_ += take;
+        bytes += take;
+        length -= take;
+        if (tailLength_ < 16) {
+            return;
+        }
+        ProcessBlock(tail_);
+        tailLength_ = 0;
+    }
+
+    const std::size_t blocks = length / 16;
+    for (std::size_t i = 0; i < blocks; ++i) {
+        ProcessBlock(bytes + i * 16);
+    }
+
+    tailLength_ = length - blocks * 16;
+    if (tailLength_ > 0) {
+        std::memcpy(tail_, bytes + blocks * 16, tailLength_);
+    }
+}
+
+Hash128 Hasher::Finalize() const {
+    std::uint64_t h1 = h1_;
+    std::uint64_t h2 = h2_;
+    std::uint64_t k1 = 0;
+    std::uint64_t k2 = 0;
+
+    // Same tail mixing as the reference implementation, expressed as loops instead of a fallthrough switch
+    if (tailLength_ > 8) {
+        for (std::size_t i = tailLength_; i > 8; --i) {
+            k2 ^= static_cast<std::uint64_t>(tail_[i - 1]) << ((i - 9) * 8);
+        }
+        k2 *= kC2;
+        k2 = Rotl(k2, 33);
+        k2 *= kC1;
+        h2 ^= k2;
+    }
+    if (tailLength_ > 0) {
+        for (std::size_t i = std::min<std::size_t>(tailLength_, 8); i > 0; --i) {
+            k1 ^= static_cast<std::uint64_t>(tail_[i - 1]) << ((i - 1) * 8);
+        }
+        k1 *= kC1;
+        k1 = Rotl(k1, 31);
+        k1 *= kC2;
+        h1 ^= k1;
+    }
+
+    h1 ^= totalLength_;
+    h2 ^= totalLength_;
+    h1 += h2;
+    h2 += h1;
+    h1 = FinalMix(h1);
+    h2 = FinalMix(h2);
+    h1 += h2;
+    h2 += h1;
+    return {h1, h2};
+}
+
+Hash128 HashBuffer(const void* data, std::size_t length, std::uint64_t seed) {
+    Hasher hasher(seed);
+    hasher.Update(data, length);
+    return hasher.Finalize();
+}
+
+std::string ToHex(const Hash128& hash) {
+    static const char digits[] = "0123456789abcdef";
+    std::string text(32, '0');
+    for (int i = 0; i < 16; ++i) {
+        text[15 - i] = digits[(hash.high >> (i * 4)) & 0xF];
+        text[31 - i] = digits[(hash.low >> (i * 4)) & 0xF];
+    }
+    return text;
+}
+
+bool FromHex(const std::string& text, Hash128& hash) {
+    if (text.size() != 32) {
+        return false;
+    }
+    std::uint64_t lanes[2] = {0, 0};
+    for (std::size_t i = 0; i < 32; ++i) {
+        const char c = text[i];
+        std::uint64_t nibble = 0;
+        if (c >= '0' && c <= '9') {
+            nibble = static_cast<std::uint64_t>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            nibble = static_cast<std::uint64_t>(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            nibble = static_cast<std::uint64_t>(c - 'A' + 10);
+        } else {
+            return false;
+        }
+        lanes[i / 16] = (lanes[i / 16] << 4) | nibble;
+    }
+    hash.high = lanes[0];
+    hash.low = lanes[1];
+    return true;
+}
+
+bool CompareFrames(const std::vector<Hash128>& source, const std::vector<Hash128>& output) {
+    if (source.size() != output.size()) {
+        std::cerr << "  Verification failed: frame count differs (" << source.size() << " vs " << output.size() << ")"
+                  << std::endl;
+        return false;
+    }
+
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < source.size(); ++i) {
+        if (source[i] != output[i]) {
+            if (mismatches < 10) {
+                std::cerr << "  Frame " << i << " differs: " << ToHex(source[i]) << " != " << ToHex(output[i])
+                          << std::endl;
+            }
+            ++mismatches;
+        }
+    }
+
+    if (mismatches > 0) {
+        std::cerr << "  Verification FAILED: " << mismatches << " of " << source.size() << " frames differ."
+                  << std::endl;
+        return false;
+    }
+    std::cout << "  Verified " << source.size() << " frame(s): decoded pixels are identical." << std::endl;
+    return true;
+}
+
+bool VerifyRoundTrip(const std::string& sourceFile, const std::string& outputFile, const FrameHasher& hashFrames) {
+    // Compare decoded pixels frame by frame through hashes instead of holding both full buffers
+    std::cout << "Verifying lossless round-trip (per-frame pixel hashes)..." << std::endl;
+    std::vector<Hash128> sourceHashes;
+    std::vector<Hash128> outputHashes;
+    std::string error;
+    if (!hashFrames(sourceFile, sourceHashes, error) || !hashFrames(outputFile, outputHashes, error)) {
+        std::cerr << "  Verification failed: " << error << std::endl;
+        return false;
+    }
+    return CompareFrames(sourceHashes, outputHashes);
+}
+
+} // namespace PixelHash
@@ -0,0 +1,63 @@
+//
+// PixelHash.h
+// DicomToolsCpp
+//
+// Declares a fast 128-bit non-cryptographic hash for comparing decoded pixel buffers across transfer syntaxes.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace PixelHash {
+    struct Hash128 {
+        // Two 64-bit lanes; compared as a pair so collisions need both halves to agree
+        std::uint64_t low{0};
+        std::uint64_t high{0};
+
+        bool operator==(const Hash128& other) const { return low == other.low && high == other.high; }
+        bool operator!=(const Hash128& other) const { return !(*this == other); }
+        bool operator<(const Hash128& other) const {
+            return high < other.high || (high == other.high && low < other.low);
+        }
+    };
+
+    // Incremental MurmurHash3 x64/128 so large frames can be fed in pieces without changing the digest
+    class Hasher {
+    public:
+        explicit Hasher(std::uint64_t seed = 0);
+        void Update(const void* data, std::size_t length);
+        Hash128 Finalize() const;
+
+    private:
+        void ProcessBlock(const unsigned char* block);
+
+        std::uint64_t h1_;
+        std::uint64_t h2_;
+        std::uint64_t totalLength_{0};
+        unsigned char tail_[16]{};
+        std::size_t tailLength_{0};
+    };
+
+    // One-shot convenience for a contiguous frame buffer
+    Hash128 HashBuffer(const void* data, std::size_t length, std::uint64_t seed = 0);
+    // 32 lowercase hex digits (high lane first) for CSV/report output
+    std::string ToHex(const Hash128& hash);
+    // Parse the ToHex representation back; returns false on malformed input
+    bool FromHex(const std::string& text, Hash128& hash);
+
+    // Decodes a file and hashes each frame; false with `error` set when it cannot
+    using FrameHasher = std::function<bool(const std::string& filename, std::vector<Hash128>& hashes,
+                                           std::string& error)>;
+
+    // Compare per-frame hashes of a source and its re-encoding, listing up to 10 differing frames on stderr and the
+    // verdict on stdout; true only when the frame counts and every frame agree
+    bool CompareFrames(const std::vector<Hash128>& source, const std::vector<Hash128>& output);
+    // Lossless round-trip check behind --verify: hash both files with the module's decoder and compare the frames
+    bool VerifyRoundTrip(const std::string& sourceFile, const std::string& outputFile, const FrameHasher& hashFrames);
+}
@@ -0,0 +1,23 @@
+//
+// SeparableGaussian.h
+// DicomToolsCpp
+//
+// Declares the in-house separable Gaussian used as a fast smoothing engine for int16 and float volumes.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include <vector>
+
+#include "VolumeExtent.h"
+
+namespace SeparableGaussian {
+    // Sampled Gaussian truncated at 4 sigma and normalised to sum 1; sigma in voxels, <= 0 gives the identity {1}
+    std::vector<float> MakeKernel(double sigma);
+
+    // Smooth with per-axis sigmas given in voxels, replicating edge voxels (zero-flux borders, like ITK).
+    // Sums run in float; int16 results are rounded and clamped. `output` must not alias `input`. workers 0 = auto.
+    void Smooth(const short* input, short* output, const VolumeExtent& extent, const double sigma[3], unsigned int workers = 0);
+    void Smooth(const float* input, float* output, const VolumeExtent& extent, const double sigma[3], unsigned int workers = 0);
+}
@@ -0,0 +1,37 @@
+//
+// SeparableResample.h
+// DicomToolsCpp
+//
+// Declares the in-house axis-aligned resampler used as a fast engine for isotropic resampling of int16 volumes.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include <string>
+
+#include "VolumeExtent.h"
+
+namespace SeparableResample {
+    enum class Kernel {
+        // Tent over the two nearest samples, as itk::LinearInterpolateImageFunction
+        Linear,
+        // Interpolating cubic B-spline: samples are prefiltered into coefficients first, mirror boundaries
+        BSpline,
+        // Lanczos-windowed sinc with three lobes, weights normalised to sum 1
+        Lanczos,
+    };
+
+    // linear, bspline or lanczos; false for anything else
+    bool KernelFromName(const std::string& name, Kernel& kernel);
+
+    // Resample onto an axis-aligned grid that shares the input's origin and direction: output voxel i along an axis
+    // sits at i * outputSpacing from the first input voxel. Weights and source indices are tabulated once per axis
+    // and applied as x, y and z passes over float rows. Taps beyond the input replicate the edge voxels (B-spline
+    // mirrors them).
+    // With `antialias`, axes that are downsampled widen the kernel by the reduction factor so it also low-passes.
+    // `output` must hold outputExtent.Voxels() samples. workers 0 = auto.
+    void Resample(const short* input, const VolumeExtent& inputExtent, const double inputSpacing[3], short* output,
+                  const VolumeExtent& outputExtent, const double outputSpacing[3], Kernel kernel, bool antialias,
+                  unsigned int workers = 0);
+}
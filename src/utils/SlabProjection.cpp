@@ -0,0 +1,356 @@
+//
+// SlabProjection.cpp
+// DicomToolsCpp
+//
+// Implements slab projections as per-row strips of ray samples reduced with running extremes or prefix sums.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#include "SlabProjection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+#include "ParallelUtils.h"
+
+namespace SlabProjection {
+namespace {
+struct MaxOp {
+    float operator()(float a, float b) const { return a > b ? a : b; }
+};
+
+struct MinOp {
+    float operator()(float a, float b) const { return a < b ? a : b; }
+};
+
+double Dot(const double a[3], const double b[3]) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// Running extremes over blocks of `thickness` samples: forward holds the extreme from the block start up to c,
+// backward from c to the block end, so any window of `thickness` samples is one op of one entry from each.
+// Every row update is a whole-row elementwise op, which compilers pack into SIMD min/max.
+template <typename Op>
+void ReduceExtremes(const float* strip, float* forward, float* backward, const Layout& layout, float* output,
+                    std::size_t planeSize, Op op) {
+    const std::size_t width = layout.width;
+    const std::size_t samples = layout.samples;
+    const std::size_t thickness = layout.thickness;
+    for (std::size_t c = 0; c < samples; ++c) {
+        const float* in = strip + c * width;
+        float* out = forward + c * width;
+        if (c % thickness == 0) {
+            std::copy(in, in + width, out);
+        } else {
+            const float* previous = out - width;
+            for (std::size_t i = 0; i < width; ++i) {
+                out[i] = op(previous[i], in[i]);
+            }
+        }
+    }
+    for (std::size_t c = samples; c-- > 0;) {
+        const float* in = strip + c * width;
+        float* out = backward + c * width;
+        if (c + 1 == samples || c % thickness == thickness - 1) {
+            std::copy(in, in + width, out);
+        } else {
+            const float* next = out + width;
+            for (std::size_t i = 0; i < width; ++i) {
+                out[i] = op(next[i], in[i]);
+            }
+        }
+    }
+    for (std::size_t k = 0; k < layout.slabs; ++k) {
+        const std::size_t start = k * layout.step;
+        const float* head = backward + start * width;
+        const float* tail = forward + (start + thickness - 1) * width;
+        float* target = output + k * planeSize;
+        for (std::size_t i = 0; i < width; ++i) {
+            target[i] = op(head[i], tail[i]);
+        }
+    }
+}
+
+void ReduceSums(const float* strip, std::vector<double>& prefix, const Layout& layout, float* output,
+                std::size_t planeSize, bool mean) {
+    const std::size_t width = layout.width;
+    prefix.assign((layout.samples + 1) * width, 0.0);
+    for (std::size_t c = 0; c < layout.samples; ++c) {
+        const float* in = strip + c * width;
+        const double* previous = prefix.data() + c * width;
+        double* out = prefix.data() + (c + 1) * width;
+        for (std::size_t i = 0; i < width; ++i) {
+            out[i] = previous[i] + static_cast<double>(in[i]);
+        }
+    }
+    const double scale = mean ? 1.0 / static_cast<double>(layout.thickness) : 1.0;
+    for (std::size_t k = 0; k < layout.slabs; ++k) {
+        const std::size_t start = k * layout.step;
+        const double* head = prefix.data() + start * width;
+        const double* tail = prefix.data() + (start + layout.thickness) * width;
+        float* target = output + k * planeSize;
+        for (std::size_t i = 0; i < width; ++i) {
+            target[i] = static_cast<float>((tail[i] - head[i]) * scale);
+        }
+    }
+}
+
+// Row `row` of every sample plane, plane-major: strip[c * width + i]
+void LoadStrip(const short* input, const VolumeExtent& extent, const double spacing[3], const Layout& layout,
+               std::size_t row, float outside, float* strip) {
+    const std::size_t width = layout.width;
+    const std::size_t sliceVoxels = extent.SliceVoxels();
+    if (layout.volumeAxis == 2) {
+        for (std::size_t c = 0; c < layout.samples; ++c) {
+            const short* source = input + c * sliceVoxels + row * extent.x;
+            std::copy(source, source + width, strip + c * width);
+        }
+        return;
+    }
+    if (layout.volumeAxis == 1) {
+        for (std::size_t c = 0; c < layout.samples; ++c) {
+            const short* source = input + row * sliceVoxels + c * extent.x;
+            std::copy(source, source + width, strip + c * width);
+        }
+        return;
+    }
+    if (layout.volumeAxis == 0) {
+        for (std::size_t i = 0; i < width; ++i) {
+            const short* source = input + row * sliceVoxels + i * extent.x;
+            for (std::size_t c = 0; c < layout.samples; ++c) {
+                strip[c * width + i] = static_cast<float>(source[c]);
+            }
+        }
+        return;
+    }
+
+    // Oblique: trilinear samples, stepping each ray's continuous index by a constant increment
+    const std::size_t size[3] = {extent.x, extent.y, extent.z};
+    double rowStart[3];
+    double alongRow[3];
+    double alongRay[3];
+    for (unsigned int a = 0; a < 3; ++a) {
+        rowStart[a] = (layout.origin[a] + static_cast<double>(row) * layout.pixel[1] * layout.v[a]) / spacing[a];
+        alongRow[a] = layout.pixel[0] * layout.u[a] / spacing[a];
+        alongRay[a] = layout.sampleSpacing * layout.axis[a] / spacing[a];
+    }
+    auto at = [&](std::size_t x, std::size_t y, std::size_t z) {
+        return static_cast<float>(input[z * sliceVoxels + y * extent.x + x]);
+    };
+    for (std::size_t c = 0; c < layout.samples; ++c) {
+        float* target = strip + c * width;
+        for (std::size_t i = 0; i < width; ++i) {
+            double p[3];
+            bool inside = true;
+            std::size_t base[3];
+            std::size_t next[3];
+            float frac[3];
+            for (unsigned int a = 0; a < 3; ++a) {
+                p[a] = rowStart[a] + static_cast<double>(i) * alongRow[a] + static_cast<double>(c) * alongRay[a];
+                const double last = static_cast<double>(size[a] - 1);
+                // A hair of tolerance keeps rays that graze a face from dropping their edge samples
+                if (p[a] < -1e-6 || p[a] > last + 1e-6) {
+                    inside = false;
+                    break;
+                }
+                const double clamped = std::clamp(p[a], 0.0, last);
+                base[a] = static_cast<std::size_t>(clamped);
+                next[a] = std::min(base[a] + 1, size[a] - 1);
+                frac[a] = static_cast<float>(clamped - static_cast<double>(base[a]));
+            }
+            if (!inside) {
+                target[i] = outside;
+                continue;
+            }
+            const float c00 = at(base[0], base[1], base[2]) * (1.0f - frac[0]) + at(next[0], base[1], base[2]) * frac[0];
+            const float c10 = at(base[0], next[1], base[2]) * (1.0f - frac[0]) + at(next[0], next[1], base[2]) * frac[0];
+            const float c01 = at(base[0], base[1], next[2]) * (1.0f - frac[0]) + at(next[0], base[1], next[2]) * frac[0];
+            const float c11 = at(base[0], next[1], next[2]) * (1.0f - frac[0]) + at(next[0], next[1], next[2]) * frac[0];
+            const float c0 = c00 * (1.0f - frac[1]) + c10 * frac[1];
+            const float c1 = c01 * (1.0f - frac[1]) + c11 * frac[1];
+            target[i] = c0 * (1.0f - frac[2]) + c1 * frac[2];
+        }
+    }
+}
+} // namespace
+
+bool ModeFromName(const std::string& name, Mode& mode) {
+    if (name == "max") {
+        mode = Mode::Max;
+    } else if (name == "min") {
+        mode = Mode::Min;
+    } else if (name == "mean") {
+        mode = Mode::Mean;
+    } else if (name == "sum") {
+        mode = Mode::Sum;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool DirectionFromName(const std::string& name, double direction[3]) {
+    if (name == "x" || name == "y" || name == "z") {
+        for (unsigned int a = 0; a < 3; ++a) {
+            direction[a] = 0.0;
+        }
+        direction[name[0] - 'x'] = 1.0;
+        return true;
+    }
+    std::istringstream stream(name);
+    char comma1 = 0;
+    char comma2 = 0;
+    double parsed[3];
+    if (!(stream >> parsed[0] >> comma1 >> parsed[1] >> comma2 >> parsed[2]) || comma1 != ',' || comma2 != ',') {
+        return false;
+    }
+    if (Dot(parsed, parsed) <= 0.0) {
+        return false;
+    }
+    std::copy(parsed, parsed + 3, direction);
+    return true;
+}
+
+Layout Plan(const VolumeExtent& extent, const double spacing[3], const double direction[3], double thicknessMm,
+            double stepMm) {
+    Layout layout;
+    const std::size_t size[3] = {extent.x, extent.y, extent.z};
+    double d[3] = {0.0, 0.0, 1.0};
+    const double norm = std::sqrt(Dot(direction, direction));
+    if (norm > 0.0) {
+        for (unsigned int a = 0; a < 3; ++a) {
+            d[a] = direction[a] / norm;
+        }
+    }
+    int aligned = -1;
+    for (int a = 0; a < 3; ++a) {
+        if (std::abs(d[a]) > 1.0 - 1e-9) {
+            aligned = a;
+        }
+    }
+
+    if (aligned >= 0) {
+        const int uAxis = aligned == 0 ? 1 : 0;
+        const int vAxis = aligned == 2 ? 1 : 2;
+        layout.volumeAxis = aligned;
+        layout.width = size[uAxis];
+        layout.height = size[vAxis];
+        layout.samples = size[aligned];
+        layout.pixel[0] = spacing[uAxis];
+        layout.pixel[1] = spacing[vAxis];
+        layout.sampleSpacing = spacing[aligned];
+        for (int a = 0; a < 3; ++a) {
+            layout.u[a] = a == uAxis ? 1.0 : 0.0;
+            layout.v[a] = a == vAxis ? 1.0 : 0.0;
+            layout.axis[a] = a == aligned ? 1.0 : 0.0;
+        }
+    } else {
+        layout.volumeAxis = -1;
+        const double finest = std::min({spacing[0], spacing[1], spacing[2]});
+        // u: the volume axis least aligned with the ray, made orthogonal to it; v completes a right-handed frame
+        int helper = 0;
+        for (int a = 1; a < 3; ++a) {
+            if (std::abs(d[a]) < std::abs(d[helper])) {
+                helper = a;
+            }
+        }
+        double u[3] = {0.0, 0.0, 0.0};
+        u[helper] = 1.0;
+        const double along = Dot(u, d);
+        for (unsigned int a = 0; a < 3; ++a) {
+            u[a] -= along * d[a];
+        }
+        const double uNorm = std::sqrt(Dot(u, u));
+        for (unsigned int a = 0; a < 3; ++a) {
+            u[a] /= uNorm;
+        }
+        const double v[3] = {d[1] * u[2] - d[2] * u[1], d[2] * u[0] - d[0] * u[2], d[0] * u[1] - d[1] * u[0]};
+
+        // Bounding box of the volume's corners in the (u, v, axis) frame
+        double low[3] = {0.0, 0.0, 0.0};
+        double high[3] = {0.0, 0.0, 0.0};
+        for (unsigned int corner = 0; corner < 8; ++corner) {
+            double p[3];
+            for (unsigned int a = 0; a < 3; ++a) {
+                p[a] = (corner >> a) & 1u ? static_cast<double>(size[a] - 1) * spacing[a] : 0.0;
+            }
+            const double projected[3] = {Dot(p, u), Dot(p, v), Dot(p, d)};
+            for (unsigned int a = 0; a < 3; ++a) {
+                low[a] = corner == 0 ? projected[a] : std::min(low[a], projected[a]);
+                high[a] = corner == 0 ? projected[a] : std::max(high[a], projected[a]);
+            }
+        }
+        layout.width = static_cast<std::size_t>(std::floor((high[0] - low[0]) / finest + 1e-9)) + 1;
+        layout.height = static_cast<std::size_t>(std::floor((high[1] - low[1]) / finest + 1e-9)) + 1;
+        layout.samples = static_cast<std::size_t>(std::floor((high[2] - low[2]) / finest + 1e-9)) + 1;
+        layout.pixel[0] = finest;
+        layout.pixel[1] = finest;
+        layout.sampleSpacing = finest;
+        for (unsigned int a = 0; a < 3; ++a) {
+            layout.origin[a] = low[0] * u[a] + low[1] * v[a] + low[2] * d[a];
+            layout.u[a] = u[a];
+            layout.v[a] = v[a];
+            layout.axis[a] = d[a];
+        }
+    }
+
+    if (layout.samples == 0) {
+        layout.slabs = 0;
+        return layout;
+    }
+    layout.thickness = layout.samples;
+    if (thicknessMm > 0.0) {
+        const auto requested = static_cast<std::size_t>(std::max(1.0, std::round(thicknessMm / layout.sampleSpacing)));
+        layout.thickness = std::min(layout.samples, requested);
+    }
+    layout.step = stepMm > 0.0 ? static_cast<std::size_t>(std::max(1.0, std::round(stepMm / layout.sampleSpacing))) : 1;
+    layout.slabs = (layout.samples - layout.thickness) / layout.step + 1;
+    return layout;
+}
+
+void Project(const short* input, const VolumeExtent& extent, const double spacing[3], const Layout& layout, Mode mode,
+             float* output, unsigned int workers) {
+    const std::size_t planeSize = layout.width * layout.height;
+    if (layout.slabs == 0 || planeSize == 0 || extent.Voxels() == 0) {
+        return;
+    }
+    float outside = 0.0f;
+    if (layout.volumeAxis < 0) {
+        const auto range = std::minmax_element(input, input + extent.Voxels());
+        outside = static_cast<float>(mode == Mode::Min ? *range.second : *range.first);
+    }
+
+    const unsigned int threads = ParallelUtils::ResolveWorkerCount(layout.height, workers);
+    struct Scratch {
+        std::vector<float> strip;
+        std::vector<float> forward;
+        std::vector<float> backward;
+        std::vector<double> prefix;
+    };
+    std::vector<Scratch> scratch(threads);
+    const std::size_t stripSize = layout.samples * layout.width;
+
+    ParallelUtils::ParallelFor(layout.height, threads, [&](unsigned int worker, std::size_t row) {
+        Scratch& local = scratch[worker];
+        local.strip.resize(stripSize);
+        LoadStrip(input, extent, spacing, layout, row, outside, local.strip.data());
+        float* target = output + row * layout.width;
+        if (mode == Mode::Max || mode == Mode::Min) {
+            local.forward.resize(stripSize);
+            local.backward.resize(stripSize);
+            if (mode == Mode::Max) {
+                ReduceExtremes(local.strip.data(), local.forward.data(), local.backward.data(), layout, target, planeSize,
+                               MaxOp{});
+            } else {
+                ReduceExtremes(local.strip.data(), local.forward.data(), local.backward.data(), layout, target, planeSize,
+                               MinOp{});
+            }
+        } else {
+            ReduceSums(local.strip.data(), local.prefix, layout, target, planeSize, mode == Mode::Mean);
+        }
+    });
+}
+
+} // namespace SlabProjection
@@ -0,0 +1,55 @@
+//
+// SlabProjection.h
+// DicomToolsCpp
+//
+// Declares the slab projection engine that turns an int16 volume into a stack of thin-slab MIP/MinIP/AvgIP images.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include <string>
+
+#include "VolumeExtent.h"
+
+namespace SlabProjection {
+    enum class Mode { Max, Min, Mean, Sum };
+
+    // max, min, mean or sum; false for anything else
+    bool ModeFromName(const std::string& name, Mode& mode);
+    // x, y, z, or an oblique direction "dx,dy,dz" in the volume's axes (need not be unit length); false if unparsable
+    bool DirectionFromName(const std::string& name, double direction[3]);
+
+    // Sampling frame of a projection. Every pixel of the output plane casts a ray of `samples` points along `axis`;
+    // slab k reduces `thickness` consecutive points starting at point k * step. Positions are in mm from the centre
+    // of the first input voxel: point (i, j, c) sits at origin + i*pixel[0]*u + j*pixel[1]*v + c*sampleSpacing*axis.
+    struct Layout {
+        std::size_t width{0};
+        std::size_t height{0};
+        std::size_t samples{0};
+        std::size_t thickness{0};
+        std::size_t step{1};
+        std::size_t slabs{0};
+        double pixel[2]{1.0, 1.0};
+        double sampleSpacing{1.0};
+        double origin[3]{0.0, 0.0, 0.0};
+        double u[3]{1.0, 0.0, 0.0};
+        double v[3]{0.0, 1.0, 0.0};
+        double axis[3]{0.0, 0.0, 1.0};
+        // 0, 1 or 2 when the axis is a volume axis and rays read voxels directly; -1 for oblique (trilinear) rays
+        int volumeAxis{2};
+    };
+
+    // Plan a stack along `direction`. thicknessMm <= 0 projects the whole depth as one slab; stepMm <= 0 advances
+    // one sample per slab, which gives a cine stack with one image per input slice. Axis-aligned rays keep the
+    // volume's own grid (coronal and sagittal planes have z as rows); oblique rays use the finest spacing throughout.
+    Layout Plan(const VolumeExtent& extent, const double spacing[3], const double direction[3], double thicknessMm,
+                double stepMm);
+
+    // Fill `output` (layout.slabs planes of width x height, x fastest) with one projection per slab. Rows of the
+    // output plane run in parallel; each worker loads its row from every sample plane and reduces all slabs at once:
+    // max/min with the van Herk/Gil-Werman running extremes (three comparisons per sample whatever the thickness),
+    // mean/sum with prefix sums. Oblique samples outside the volume read as its minimum (MinIP: its maximum).
+    void Project(const short* input, const VolumeExtent& extent, const double spacing[3], const Layout& layout, Mode mode,
+                 float* output, unsigned int workers = 0);
+}
@@ -0,0 +1,32 @@
+//
+// TiledClahe.h
+// DicomToolsCpp
+//
+// Declares the tiled contrast-limited adaptive histogram equalization (CLAHE) engine for 16-bit volumes.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include "VolumeExtent.h"
+
+namespace TiledClahe {
+    struct Parameters {
+        // Tiles along x and y (and z when volumetric); fewer when an axis is shorter than that many voxels
+        unsigned int tiles{8};
+        // false: every slice is equalized on its own with bilinear blending; true: 3-D tiles with trilinear blending
+        bool volumetric{false};
+        // Histogram bins are clipped at clipLimit times the mean bin count and the excess is spread over all bins;
+        // 0 disables clipping (plain tiled AHE)
+        double clipLimit{2.0};
+        // Weight of the input in the result, as ITK's beta: 0 = fully equalized, 1 = unchanged
+        double beta{0.0};
+    };
+
+    // Equalize `input` into `output` (which must not alias it). Each tile's clipped histogram becomes a cumulative
+    // mapping onto the volume's [min, max] range, and every voxel blends the mappings of the nearest tile centres.
+    // Ranges wider than 4096 values share bins. Tile histograms, then output rows, run on `workers` threads
+    // (0 = auto); 2-D slices go in batches so only a few slices' mappings are held at once.
+    void Equalize(const short* input, short* output, const VolumeExtent& extent, const Parameters& parameters,
+                  unsigned int workers = 0);
+}
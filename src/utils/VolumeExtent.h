@@ -0,0 +1,21 @@
+//
+// VolumeExtent.h
+// DicomToolsCpp
+//
+// Declares the dimensions record shared by the in-house volume kernels that work on raw x-fastest buffers.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include <cstddef>
+
+// Volume layout: x varies fastest, then y, then z
+struct VolumeExtent {
+    std::size_t x{0};
+    std::size_t y{0};
+    std::size_t z{0};
+
+    std::size_t SliceVoxels() const { return x * y; }
+    std::size_t Voxels() const { return x * y * z; }
+};
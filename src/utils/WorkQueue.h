@@ -0,0 +1,98 @@
+//
+// WorkQueue.h
+// DicomToolsCpp
+//
+// Declares a bounded multi-producer queue drained by a fixed set of worker threads (async writers, dispatchers).
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class WorkQueue {
+public:
+    // Producers block once `capacity` items are pending, which bounds memory when consumers fall behind
+    WorkQueue(std::size_t capacity, unsigned int workers, std::function<void(T&)> handler)
+        : capacity_(capacity == 0 ? 1 : capacity), handler_(std::move(handler)) {
+        for (unsigned int i = 0; i < (workers == 0 ? 1u : workers); ++i) {
+            threads_.emplace_back([this] { Drain(); });
+        }
+    }
+
+    ~WorkQueue() { Close(); }
+
+    WorkQueue(const WorkQueue&) = delete;
+    WorkQueue& operator=(const WorkQueue&) = delete;
+
+    // Returns false once the queue has been closed; the item is dropped in that case
+    bool Push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        items_.push_back(std::move(item));
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    // Stop accepting work, finish everything already queued, and join the workers
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_ && threads_.empty()) {
+                return;
+            }
+            closed_ = true;
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+        for (auto& thread : threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+        threads_.clear();
+    }
+
+    std::size_t Pending() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+
+private:
+    void Drain() {
+        for (;;) {
+            T item;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                notEmpty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+                if (items_.empty()) {
+                    return;
+                }
+                item = std::move(items_.front());
+                items_.pop_front();
+            }
+            notFull_.notify_one();
+            handler_(item);
+        }
+    }
+
+    const std::size_t capacity_;
+    std::function<void(T&)> handler_;
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::deque<T> items_;
+    bool closed_{false};
+    std::vector<std::thread> threads_;
+};
@@ -6,9 +6,16 @@
 #
 # Thales Matheus Mendonça Santos - November 2025
 
-import subprocess
+import json
 import os
+import shutil
+import signal
+import subprocess
 import sys
+import tempfile
+import threading
+import time
+import urllib.request
 
 # Configuration
 BUILD_DIR = "build"
@@ -20,9 +27,171 @@ if not os.path.exists(EXECUTABLE):
     print(f"Error: Executable not found at {EXECUTABLE}")
     sys.exit(1)
 
-def run_test(command, description):
+# Commands compiled into this build, read from --list; checks for modules that were not built are skipped
+def available_commands():
+    listing = subprocess.run([EXECUTABLE, "--list"], capture_output=True, text=True).stdout
+    return {line[4:].split(": ", 1)[0] for line in listing.splitlines() if line.startswith("  - ")}
+
+AVAILABLE = available_commands()
+
+# Starts a long-running command and waits for the line it prints once it accepts work. stdout keeps being drained
+# on a thread so a chatty server never blocks on a full pipe.
+def start_server(args, ready_text, timeout=60):
+    server = subprocess.Popen([EXECUTABLE, *args], stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, text=True)
+    ready = threading.Event()
+    def drain():
+        for line in server.stdout:
+            if ready_text in line:
+                ready.set()
+    threading.Thread(target=drain, daemon=True).start()
+    ready.wait(timeout)
+    return server, ready.is_set()
+
+def stop_server(server):
+    if server.poll() is None:
+        server.send_signal(signal.SIGINT)
+    try:
+        return server.wait(timeout=15)
+    except subprocess.TimeoutExpired:
+        server.kill()
+        return None
+
+def fetch(url, accept=None):
+    request = urllib.request.Request(url, headers={"Accept": accept} if accept else {})
+    with urllib.request.urlopen(request, timeout=10) as response:
+        return response.headers, response.read()
+
+# Starts serve:dicomweb, walks studies -> series -> metadata -> one frame and checks the multipart framing
+def check_dicomweb(port=18080):
+    print("Testing: DICOMweb server...")
+    server = subprocess.Popen([EXECUTABLE, "serve:dicomweb", "--port", str(port), "--duration", "30"],
+                              stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    base = f"http://127.0.0.1:{port}"
+    try:
+        studies = None
+        for _ in range(100):
+            if server.poll() is not None:
+                break
+            try:
+                studies = json.loads(fetch(f"{base}/studies")[1])
+                break
+            except OSError:
+                time.sleep(0.2)
+        if not studies:
+            print("  [FAILED] Server did not answer /studies")
+            return False
+        study = studies[0]["0020000D"]["Value"][0]
+        series = json.loads(fetch(f"{base}/studies/{study}/series")[1])[0]["0020000E"]["Value"][0]
+        metadata = json.loads(fetch(f"{base}/studies/{study}/series/{series}/metadata")[1])
+        sop = metadata[0]["00080018"]["Value"][0]
+        headers, body = fetch(f"{base}/studies/{study}/series/{series}/instances/{sop}/frames/1", "*/*")
+        content_type = headers.get("Content-Type", "")
+        if not content_type.startswith("multipart/related") or "boundary=" not in content_type:
+            print(f"  [FAILED] Unexpected frame Content-Type: {content_type}")
+            return False
+        boundary = content_type.split("boundary=", 1)[1].split(";", 1)[0].strip('"')
+        if int(headers.get("Content-Length", -1)) != len(body):
+            print(f"  [FAILED] Content-Length {headers.get('Content-Length')} does not match body of {len(body)} bytes")
+            return False
+        if not body.startswith(f"--{boundary}".encode()) or not body.endswith(f"--{boundary}--\r\n".encode()):
+            print("  [FAILED] Frame body is not framed by the declared boundary")
+            return False
+    except (OSError, ValueError, KeyError, IndexError) as error:
+        print(f"  [FAILED] {error}")
+        return False
+    finally:
+        stop_server(server)
+    print(f"  [PASS] Frame of {len(body)} bytes framed by {boundary}")
+    return True
+
+# Starts dcmtk:store-scp, replays the input series with dcmtk:store-scu and checks the instances landed on disk
+def check_store_scp(port=11113):
+    print("Testing: C-STORE receiver...")
+    shutil.rmtree(os.path.join("output", "store_scp"), ignore_errors=True)
+    server, ready = start_server(["dcmtk:store-scp", "--port", str(port), "--duration", "60"], "Listening as")
+    try:
+        if not ready:
+            print("  [FAILED] store-scp did not start listening")
+            return False
+        sender = None
+        # The listener opens just after the startup line, so give the first connection a few tries
+        for _ in range(5):
+            sender = subprocess.run([EXECUTABLE, "dcmtk:store-scu", "-i", os.path.dirname(INPUT_FILE),
+                                     "--port", str(port), "--concurrency", "2"], capture_output=True, text=True)
+            if sender.returncode == 0:
+                break
+            time.sleep(0.5)
+        if sender.returncode != 0:
+            print(f"  [FAILED] store-scu return code: {sender.returncode}")
+            print(sender.stderr)
+            return False
+    finally:
+        stop_server(server)
+    stored = [name for _, _, files in os.walk(os.path.join("output", "store_scp")) for name in files
+              if name.endswith(".dcm")]
+    if not stored:
+        print("  [FAILED] No instances written under output/store_scp")
+        return False
+    print(f"  [PASS] {len(stored)} instances stored")
+    return check_file("store_scu_report.txt")
+
+# Starts dcmtk:qr-scp over the input series and runs a short dcmtk:qr-bench of C-FIND and C-GET against it
+def check_qr_scp(port=11114):
+    print("Testing: Query/Retrieve SCP...")
+    server, ready = start_server(["dcmtk:qr-scp", "-i", os.path.dirname(INPUT_FILE), "--port", str(port),
+                                  "--duration", "60"], "Listening as")
+    try:
+        if not ready:
+            print("  [FAILED] qr-scp did not start listening")
+            return False
+        bench = subprocess.run([EXECUTABLE, "dcmtk:qr-bench", "--port", str(port), "--concurrency", "2",
+                                "--duration", "2"], capture_output=True, text=True)
+    finally:
+        stop_server(server)
+    if bench.returncode != 0:
+        print(f"  [FAILED] qr-bench return code: {bench.returncode}")
+        print(bench.stderr)
+        return False
+    print("  [PASS]")
+    return check_file("qr_bench_report.txt")
+
+# Watches a scratch folder, drops the input into a subfolder created after startup (renamed from .part, as a
+# well-behaved writer would) and waits for the command's output in that file's output/watch/ folder
+def check_watch(command, output_name):
+    print(f"Testing: --watch with {command}...")
+    watch_root = os.path.join("output", "watch")
+    shutil.rmtree(watch_root, ignore_errors=True)
+    incoming = tempfile.mkdtemp(prefix="dicomtools_watch_")
+    server, ready = start_server([command, "--watch", incoming, "--duration", "60"], "Watching")
+    produced = []
+    try:
+        if not ready:
+            print("  [FAILED] Watch did not start")
+            return False
+        arrivals = os.path.join(incoming, "arrivals")
+        os.makedirs(arrivals)
+        staged = os.path.join(arrivals, "instance.dcm.part")
+        shutil.copyfile(INPUT_FILE, staged)
+        os.rename(staged, os.path.join(arrivals, "instance.dcm"))
+        for _ in range(300):
+            produced = [folder for folder in (os.listdir(watch_root) if os.path.isdir(watch_root) else [])
+                        if os.path.exists(os.path.join(watch_root, folder, output_name))]
+            if produced or server.poll() is not None:
+                break
+            time.sleep(0.2)
+    finally:
+        # Ctrl-C finishes queued files and writes the latency report
+        stop_server(server)
+        shutil.rmtree(incoming, ignore_errors=True)
+    if not produced:
+        print(f"  [FAILED] No {output_name} under output/watch")
+        return False
+    print(f"  [PASS] {output_name} written to output/watch/{produced[0]}")
+    return check_file("watch_report.txt")
+
+def run_test(command, description, args=()):
     print(f"Testing: {description}...")
-    cmd = [EXECUTABLE, command]
+    cmd = [EXECUTABLE, command, *args]
     # If specific file needed, append it. The tool auto-detects, but consistent to be explicit if we knew the file.
     # cmd.append(INPUT_FILE) 
     
@@ -64,10 +233,19 @@ if run_test("test-gdcm", "GDCM Features"):
     check_file("gdcm_jpegls.dcm")
     check_file("gdcm_stats.txt")
     check_file("gdcm_series_index.csv")
+    check_file("gdcm_pixel_hashes.csv")
+    check_file("gdcm_pixel_hash_report.txt")
     check_file("gdcm_preview.pgm")
 else:
     tests_passed = False
 
+# Lossless transcodes re-decoded under --verify; a pixel-hash mismatch exits non-zero
+for command, output in (("gdcm:transcode-rle", "gdcm_rle.dcm"), ("dcmtk:rle", "dcmtk_rle.dcm")):
+    if run_test(command, f"{command} --verify", ["--verify"]):
+        check_file(output)
+    else:
+        tests_passed = False
+
 # DCMTK
 if run_test("test-dcmtk", "DCMTK Features"):
     check_file("dcmtk_modified.dcm")
@@ -77,12 +255,43 @@ if run_test("test-dcmtk", "DCMTK Features"):
     check_file("dcmtk_rle.dcm")
     check_file("dcmtk_raw_dump.bin")
     check_file("dcmtk_explicit_vr.dcm")
+    check_file("dcmtk_deflated.dcm")
     check_file("dcmtk_metadata.txt")
     check_file("dcmtk_preview.bmp")
+    check_file("dcmtk_cine_sheet.pgm")
     check_file("dicomdir_media/DICOMDIR")
+    check_file("dcmtk_dicomdir_query.txt")
 else:
     tests_passed = False
 
+# Network services; each needs its module, so a build without it skips them
+if "serve:dicomweb" in AVAILABLE:
+    if not check_dicomweb():
+        tests_passed = False
+else:
+    print("Skipping: DICOMweb server (DCMTK not built)")
+
+if "dcmtk:store-scp" in AVAILABLE:
+    if not check_store_scp():
+        tests_passed = False
+else:
+    print("Skipping: C-STORE receiver (DCMTK not built)")
+
+if "dcmtk:qr-scp" in AVAILABLE:
+    if not check_qr_scp():
+        tests_passed = False
+else:
+    print("Skipping: Query/Retrieve SCP (DCMTK not built)")
+
+# Ingest mode (inotify, Linux only) with whichever single-file command this build has
+watch_candidates = [("gdcm:anonymize", "gdcm_anon.dcm"), ("dcmtk:modify", "dcmtk_modified.dcm")]
+watch_command = next((candidate for candidate in watch_candidates if candidate[0] in AVAILABLE), None)
+if sys.platform.startswith("linux") and watch_command:
+    if not check_watch(*watch_command):
+        tests_passed = False
+else:
+    print("Skipping: --watch (needs Linux and GDCM or DCMTK)")
+
 # ITK
 if run_test("test-itk", "ITK Features"):
     check_file("itk_canny.dcm")
@@ -100,6 +309,39 @@ if run_test("test-itk", "ITK Features"):
 else:
     tests_passed = False
 
+# ITK engine options, commands and benchmarks on the single input slice so the timing sweeps stay short
+if "test-itk" in AVAILABLE:
+    itk_smoke = [
+        ("bench:itk-scaling", ["--threads", "2"], ["itk_scaling_report.txt"]),
+        ("itk:gaussian", ["--max-memory", "64M"], ["itk_gaussian.nrrd"]),
+        ("itk:gaussian", ["--gaussian-engine", "separable", "--sigma", "2"], ["itk_gaussian.dcm"]),
+        ("bench:gaussian", [], ["itk_gaussian_bench.txt"]),
+        ("itk:median", ["--median-engine", "histogram", "--radius", "2"], ["itk_median.dcm"]),
+        ("bench:median", [], ["itk_median_bench.txt"]),
+        ("itk:aniso", ["--precision", "fp16"], ["itk_aniso.dcm"]),
+        ("itk:resample", ["--interpolation", "lanczos", "--antialias"], ["itk_resampled.dcm"]),
+        ("bench:resample", [], ["itk_resample_bench.txt"]),
+        ("itk:slab", ["--slab", "10"], ["itk_slab_max.nrrd"]),
+        ("bench:slab", [], ["itk_slab_bench.txt"]),
+        ("itk:histogram", ["--equalize-engine", "clahe3d"], ["itk_histogram_eq.dcm"]),
+        ("bench:equalize", [], ["itk_equalize_bench.txt"]),
+        ("itk:label", ["-i", "output/itk_otsu.dcm", "--connectivity", "26"],
+         ["itk_labels.nrrd", "itk_labels.csv", "itk_labels.json"]),
+        ("itk:mask", ["-i", "output/itk_otsu.dcm", "--mask-op", "close", "--radius", "2"], ["itk_mask_close.dcm"]),
+        ("itk:mask", ["-i", "output/itk_otsu.dcm", "--mask-op", "distance"], ["itk_mask_distance.nrrd"]),
+        ("bench:morphology", [], ["itk_morphology_bench.txt"]),
+    ]
+    for command, args, outputs in itk_smoke:
+        # Rows that name their own input (the masks written by test-itk) keep it
+        inputs = [] if "-i" in args else ["-i", INPUT_FILE]
+        if run_test(command, " ".join([command, *args]), [*inputs, *args]):
+            for output in outputs:
+                check_file(output)
+        else:
+            tests_passed = False
+else:
+    print("Skipping: ITK engines and benchmarks (ITK not built)")
+
 # VTK
 if run_test("test-vtk", "VTK Features"):
     check_file("vtk_export.vti")
@@ -0,0 +1,947 @@
+//
+// utils_check.cpp
+// DicomToolsCpp
+//
+// Checks the dependency-free pixel engines in src/utils against brute-force references on small random volumes.
+//
+// Thales Matheus Mendonça Santos - November 2025
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utils/BinaryMorphology.h"
+#include "utils/ConnectedComponents.h"
+#include "utils/CurvatureDiffusion.h"
+#include "utils/DistanceTransform.h"
+#include "utils/HistogramMedian.h"
+#include "utils/ParallelDeflate.h"
+#include "utils/SeparableGaussian.h"
+#include "utils/SeparableResample.h"
+#include "utils/SlabProjection.h"
+#include "utils/TiledClahe.h"
+#include "utils/VolumeExtent.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+int g_failures = 0;
+
+void Check(bool passed, const std::string& what) {
+    if (!passed) {
+        ++g_failures;
+        std::cerr << "  [FAIL] " << what << std::endl;
+    }
+}
+
+std::size_t Index(const VolumeExtent& extent, std::size_t x, std::size_t y, std::size_t z) {
+    return (z * extent.y + y) * extent.x + x;
+}
+
+// Fixed seeds keep every run on the same volumes
+std::vector<short> RandomVolume(const VolumeExtent& extent, short low, short high, unsigned int seed) {
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> value(low, high);
+    std::vector<short> volume(extent.Voxels());
+    for (short& voxel : volume) {
+        voxel = static_cast<short>(value(random));
+    }
+    return volume;
+}
+
+std::vector<short> RandomMask(const VolumeExtent& extent, double density, unsigned int seed) {
+    std::mt19937 random(seed);
+    std::bernoulli_distribution inside(density);
+    std::vector<short> mask(extent.Voxels());
+    for (short& voxel : mask) {
+        voxel = inside(random) ? 1 : 0;
+    }
+    return mask;
+}
+
+long long Clamp(long long value, std::size_t size) {
+    return std::min<long long>(std::max<long long>(value, 0), static_cast<long long>(size) - 1);
+}
+
+void CheckMedian() {
+    std::cout << "Histogram median vs sorted box" << std::endl;
+    const VolumeExtent extent{13, 11, 7};
+    const std::vector<short> input = RandomVolume(extent, -1000, 3000, 1);
+    for (const unsigned int r : {1u, 2u}) {
+        const unsigned int radius[3] = {r, r + 1, r};
+        std::vector<short> output(extent.Voxels());
+        HistogramMedian::Filter(input.data(), output.data(), extent, radius, 3);
+        std::size_t mismatches = 0;
+        std::vector<short> box;
+        for (std::size_t z = 0; z < extent.z; ++z) {
+            for (std::size_t y = 0; y < extent.y; ++y) {
+                for (std::size_t x = 0; x < extent.x; ++x) {
+                    // Replicated edges, as itk::MedianImageFilter's zero-flux boundary
+                    box.clear();
+                    for (long long dz = -static_cast<long long>(radius[2]); dz <= radius[2]; ++dz) {
+                        for (long long dy = -static_cast<long long>(radius[1]); dy <= radius[1]; ++dy) {
+                            for (long long dx = -static_cast<long long>(radius[0]); dx <= radius[0]; ++dx) {
+                                box.push_back(input[Index(extent, Clamp(x + dx, extent.x), Clamp(y + dy, extent.y),
+                                                          Clamp(z + dz, extent.z))]);
+                            }
+                        }
+                    }
+                    std::nth_element(box.begin(), box.begin() + box.size() / 2, box.end());
+                    mismatches += output[Index(extent, x, y, z)] != box[box.size() / 2] ? 1 : 0;
+                }
+            }
+        }
+        Check(mismatches == 0, "median radius " + std::to_string(r) + ": " + std::to_string(mismatches) + " voxels differ");
+    }
+}
+
+// Breadth-first labelling over the same neighbourhoods; ids follow discovery order
+std::vector<int> FloodComponents(const std::vector<short>& mask, const VolumeExtent& extent, unsigned int connectivity,
+                                 int& count) {
+    std::vector<int> ids(mask.size(), 0);
+    count = 0;
+    std::vector<std::size_t> queue;
+    for (std::size_t start = 0; start < mask.size(); ++start) {
+        if (mask[start] == 0 || ids[start] != 0) {
+            continue;
+        }
+        ids[start] = ++count;
+        queue.assign(1, start);
+        while (!queue.empty()) {
+            const std::size_t at = queue.back();
+            queue.pop_back();
+            const long long x = static_cast<long long>(at % extent.x);
+            const long long y = static_cast<long long>(at / extent.x % extent.y);
+            const long long z = static_cast<long long>(at / extent.SliceVoxels());
+            for (long long dz = -1; dz <= 1; ++dz) {
+                for (long long dy = -1; dy <= 1; ++dy) {
+                    for (long long dx = -1; dx <= 1; ++dx) {
+                        const unsigned int steps = (dx != 0) + (dy != 0) + (dz != 0);
+                        if (steps == 0 || (connectivity == 6 && steps > 1) || (connectivity == 18 && steps > 2)) {
+                            continue;
+                        }
+                        const long long nx = x + dx;
+                        const long long ny = y + dy;
+                        const long long nz = z + dz;
+                        if (nx < 0 || ny < 0 || nz < 0 || nx >= static_cast<long long>(extent.x) ||
+                            ny >= static_cast<long long>(extent.y) || nz >= static_cast<long long>(extent.z)) {
+                            continue;
+                        }
+                        const std::size_t next = Index(extent, nx, ny, nz);
+                        if (mask[next] != 0 && ids[next] == 0) {
+                            ids[next] = count;
+                            queue.push_back(next);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return ids;
+}
+
+void CheckConnectedComponents() {
+    std::cout << "Connected components vs breadth-first flood" << std::endl;
+    // Enough slices for several slabs, so the cross-slab merge is exercised
+    const VolumeExtent extent{21, 17, 24};
+    const std::vector<short> mask = RandomMask(extent, 0.3, 2);
+    for (const unsigned int connectivity : {6u, 18u, 26u}) {
+        const std::string name = std::to_string(connectivity) + "-connected";
+        int expectedCount = 0;
+        const std::vector<int> expected = FloodComponents(mask, extent, connectivity, expectedCount);
+        std::vector<std::uint32_t> labels(extent.Voxels());
+        std::size_t removed = 0;
+        const std::vector<ConnectedComponents::Component> components =
+            ConnectedComponents::Label(mask.data(), nullptr, extent, connectivity, 0, labels.data(), removed, 4);
+        Check(static_cast<int>(components.size()) == expectedCount && removed == 0,
+              name + ": " + std::to_string(components.size()) + " components, expected " +
+                  std::to_string(expectedCount));
+
+        // Same partition: every flood id maps to exactly one label and back
+        std::map<int, std::uint32_t> labelOf;
+        std::map<std::uint32_t, int> idOf;
+        std::vector<std::uint64_t> sizes(components.size() + 1, 0);
+        bool consistent = true;
+        for (std::size_t i = 0; i < mask.size(); ++i) {
+            if ((expected[i] == 0) != (labels[i] == 0) || labels[i] > components.size()) {
+                consistent = false;
+                break;
+            }
+            if (expected[i] == 0) {
+                continue;
+            }
+            ++sizes[labels[i]];
+            const auto forward = labelOf.emplace(expected[i], labels[i]).first;
+            const auto backward = idOf.emplace(labels[i], expected[i]).first;
+            consistent = consistent && forward->second == labels[i] && backward->second == expected[i];
+        }
+        Check(consistent, name + ": labels do not partition the mask like the flood");
+
+        bool ordered = true;
+        for (std::size_t k = 0; consistent && k < components.size(); ++k) {
+            ordered = ordered && components[k].voxels == sizes[k + 1] &&
+                      (k == 0 || components[k - 1].voxels >= components[k].voxels);
+        }
+        Check(ordered, name + ": component sizes wrong or not largest first");
+    }
+}
+
+// Offsets within radius + 0.5 voxels, as itk::BinaryBallStructuringElement
+bool InBall(long long dx, long long dy, long long dz, unsigned int radius) {
+    const long long diameter = 2LL * radius + 1;
+    return 4 * (dx * dx + dy * dy + dz * dz) <= diameter * diameter;
+}
+
+std::vector<short> DirectMorphology(const std::vector<short>& mask, const VolumeExtent& extent, unsigned int radius,
+                                    bool dilate) {
+    const long long r = radius;
+    std::vector<short> output(mask.size(), 0);
+    for (std::size_t z = 0; z < extent.z; ++z) {
+        for (std::size_t y = 0; y < extent.y; ++y) {
+            for (std::size_t x = 0; x < extent.x; ++x) {
+                // Dilation: any ball voxel set. Erosion: no in-volume ball voxel clear (outside counts as set)
+                bool result = !dilate;
+                for (long long dz = -r; dz <= r; ++dz) {
+                    for (long long dy = -r; dy <= r; ++dy) {
+                        for (long long dx = -r; dx <= r; ++dx) {
+                            const long long nx = static_cast<long long>(x) + dx;
+                            const long long ny = static_cast<long long>(y) + dy;
+                            const long long nz = static_cast<long long>(z) + dz;
+                            if (!InBall(dx, dy, dz, radius) || nx < 0 || ny < 0 || nz < 0 ||
+                                nx >= static_cast<long long>(extent.x) || ny >= static_cast<long long>(extent.y) ||
+                                nz >= static_cast<long long>(extent.z)) {
+                                continue;
+                            }
+                            const bool set = mask[Index(extent, nx, ny, nz)] != 0;
+                            result = dilate ? (result || set) : (result && set);
+                        }
+                    }
+                }
+                output[Index(extent, x, y, z)] = result ? 1 : 0;
+            }
+        }
+    }
+    return output;
+}
+
+std::vector<short> DirectFillHoles(const std::vector<short>& mask, const VolumeExtent& extent) {
+    // Background reachable from a border voxel through face neighbours stays background; the rest is filled
+    std::vector<short> background(mask.size());
+    for (std::size_t i = 0; i < mask.size(); ++i) {
+        background[i] = mask[i] == 0 ? 1 : 0;
+    }
+    int count = 0;
+    const std::vector<int> ids = FloodComponents(background, extent, 6, count);
+    std::vector<char> open(count + 1, 0);
+    for (std::size_t z = 0; z < extent.z; ++z) {
+        for (std::size_t y = 0; y < extent.y; ++y) {
+            for (std::size_t x = 0; x < extent.x; ++x) {
+                if (x == 0 || y == 0 || z == 0 || x + 1 == extent.x || y + 1 == extent.y || z + 1 == extent.z) {
+                    open[ids[Index(extent, x, y, z)]] = 1;
+                }
+            }
+        }
+    }
+    std::vector<short> output(mask.size());
+    for (std::size_t i = 0; i < mask.size(); ++i) {
+        output[i] = mask[i] != 0 || !open[ids[i]] ? 1 : 0;
+    }
+    return output;
+}
+
+void CheckMorphology() {
+    std::cout << "Packed morphology vs direct ball scan" << std::endl;
+    // Rows wider than one 64-bit word, so carries between words are exercised
+    const VolumeExtent extent{70, 9, 8};
+    const std::vector<short> mask = RandomMask(extent, 0.35, 3);
+    const BinaryMorphology::PackedMask packed = BinaryMorphology::Pack(mask.data(), extent, 2);
+    std::vector<short> unpacked(extent.Voxels());
+    BinaryMorphology::Unpack(packed, 1, unpacked.data(), 2);
+    Check(unpacked == mask, "pack/unpack round trip");
+
+    for (const unsigned int radius : {1u, 2u, 3u}) {
+        for (const bool dilate : {true, false}) {
+            const auto operation = dilate ? BinaryMorphology::Operation::Dilate : BinaryMorphology::Operation::Erode;
+            std::vector<short> output(extent.Voxels());
+            BinaryMorphology::Unpack(BinaryMorphology::Apply(packed, operation, radius, 2), 1, output.data(), 2);
+            Check(output == DirectMorphology(mask, extent, radius, dilate),
+                  std::string(dilate ? "dilate" : "erode") + " radius " + std::to_string(radius));
+        }
+    }
+
+    const std::vector<short> dense = RandomMask(extent, 0.7, 4);
+    std::vector<short> filled(extent.Voxels());
+    BinaryMorphology::Unpack(
+        BinaryMorphology::Apply(BinaryMorphology::Pack(dense.data(), extent, 2), BinaryMorphology::Operation::FillHoles,
+                                0, 2),
+        1, filled.data(), 2);
+    Check(filled == DirectFillHoles(dense, extent), "fill holes");
+}
+
+void CheckDistanceTransform() {
+    std::cout << "Exact distance transform vs all-pairs search" << std::endl;
+    const VolumeExtent extent{11, 9, 7};
+    const double spacing[3] = {0.7, 1.0, 1.6};
+    for (const double density : {0.05, 0.5}) {
+        const std::vector<short> mask = RandomMask(extent, density, 5);
+        std::vector<float> output(extent.Voxels());
+        DistanceTransform::Signed(BinaryMorphology::Pack(mask.data(), extent, 2), spacing, output.data(), 2);
+        double worst = 0.0;
+        for (std::size_t i = 0; i < mask.size(); ++i) {
+            // Nearest voxel of the other class, in mm between centres
+            double best = std::numeric_limits<double>::infinity();
+            for (std::size_t j = 0; j < mask.size(); ++j) {
+                if ((mask[j] != 0) == (mask[i] != 0)) {
+                    continue;
+                }
+                double squared = 0.0;
+                const std::size_t a[3] = {i % extent.x, i / extent.x % extent.y, i / extent.SliceVoxels()};
+                const std::size_t b[3] = {j % extent.x, j / extent.x % extent.y, j / extent.SliceVoxels()};
+                for (unsigned int axis = 0; axis < 3; ++axis) {
+                    const double offset = (static_cast<double>(a[axis]) - static_cast<double>(b[axis])) * spacing[axis];
+                    squared += offset * offset;
+                }
+                best = std::min(best, squared);
+            }
+            const double expected = mask[i] != 0 ? -std::sqrt(best) : std::sqrt(best);
+            worst = std::max(worst, std::abs(expected - static_cast<double>(output[i])));
+        }
+        Check(worst < 1e-4, "signed distance at density " + std::to_string(density) + ": max error " +
+                                std::to_string(worst) + " mm");
+    }
+
+    const std::vector<short> empty(extent.Voxels(), 0);
+    std::vector<float> output(extent.Voxels());
+    DistanceTransform::Signed(BinaryMorphology::Pack(empty.data(), extent, 2), spacing, output.data(), 2);
+    Check(std::all_of(output.begin(), output.end(), [](float value) { return std::isinf(value) && value > 0; }),
+          "empty mask leaves +infinity everywhere");
+}
+
+void CheckSlabProjection() {
+    std::cout << "Slab projection vs nested loops" << std::endl;
+    const VolumeExtent extent{6, 5, 12};
+    const double spacing[3] = {1.0, 1.0, 1.0};
+    const std::vector<short> input = RandomVolume(extent, -500, 1500, 6);
+    const char* axes[] = {"x", "y", "z"};
+    for (int axisIndex = 0; axisIndex < 3; ++axisIndex) {
+        double direction[3];
+        SlabProjection::DirectionFromName(axes[axisIndex], direction);
+        const SlabProjection::Layout layout = SlabProjection::Plan(extent, spacing, direction, 3.0, 2.0);
+        // Rays read voxels directly: (i, row, c) is (x, y, z) along z, (x, z, y) along y, (y, z, x) along x
+        auto voxel = [&](std::size_t i, std::size_t row, std::size_t c) {
+            switch (layout.volumeAxis) {
+            case 2: return input[Index(extent, i, row, c)];
+            case 1: return input[Index(extent, i, c, row)];
+            default: return input[Index(extent, c, i, row)];
+            }
+        };
+        for (const char* modeName : {"max", "min", "mean", "sum"}) {
+            SlabProjection::Mode mode;
+            SlabProjection::ModeFromName(modeName, mode);
+            const std::size_t planeSize = layout.width * layout.height;
+            std::vector<float> output(layout.slabs * planeSize);
+            SlabProjection::Project(input.data(), extent, spacing, layout, mode, output.data(), 2);
+            double worst = 0.0;
+            for (std::size_t k = 0; k < layout.slabs; ++k) {
+                for (std::size_t row = 0; row < layout.height; ++row) {
+                    for (std::size_t i = 0; i < layout.width; ++i) {
+                        double expected = voxel(i, row, k * layout.step);
+                        double sum = 0.0;
+                        for (std::size_t c = k * layout.step; c < k * layout.step + layout.thickness; ++c) {
+                            const double value = voxel(i, row, c);
+                            expected = mode == SlabProjection::Mode::Max   ? std::max(expected, value)
+                                       : mode == SlabProjection::Mode::Min ? std::min(expected, value)
+                                                                           : expected;
+                            sum += value;
+                        }
+                        if (mode == SlabProjection::Mode::Sum) {
+                            expected = sum;
+                        } else if (mode == SlabProjection::Mode::Mean) {
+                            expected = sum / static_cast<double>(layout.thickness);
+                        }
+                        const double actual = output[k * planeSize + row * layout.width + i];
+                        worst = std::max(worst, std::abs(expected - actual));
+                    }
+                }
+            }
+            Check(layout.slabs > 1 && worst < 1e-3,
+                  std::string(modeName) + " along " + axes[axisIndex] + ": max error " + std::to_string(worst));
+        }
+    }
+}
+void CheckHalfFloat() {
+    std::cout << "Half-float conversions" << std::endl;
+    std::size_t mismatches = 0;
+    for (std::uint32_t bits = 0; bits <= 0xFFFF; ++bits) {
+        const auto half = static_cast<std::uint16_t>(bits);
+        const float value = CurvatureDiffusion::HalfToFloat(half);
+        const std::uint16_t back = CurvatureDiffusion::FloatToHalf(value);
+        const bool nan = (half & 0x7C00) == 0x7C00 && (half & 0x03FF) != 0;
+        mismatches += nan ? !std::isnan(value) || (back & 0x7C00) != 0x7C00 || (back & 0x03FF) == 0
+                          : back != half;
+    }
+    Check(mismatches == 0, "every binary16 value survives half -> float -> half");
+
+    // Halfway cases round to the even neighbour; anything past halfway rounds up
+    Check(CurvatureDiffusion::FloatToHalf(1.0f + std::ldexp(1.0f, -11)) == 0x3C00, "1 + 2^-11 rounds down to even");
+    Check(CurvatureDiffusion::FloatToHalf(1.0f + 3 * std::ldexp(1.0f, -11)) == 0x3C02, "1 + 3*2^-11 rounds up to even");
+    Check(CurvatureDiffusion::FloatToHalf(65520.0f) == 0x7C00, "65520 overflows to infinity");
+    Check(CurvatureDiffusion::FloatToHalf(std::ldexp(1.0f, -25)) == 0x0000, "2^-25 rounds to zero");
+    Check(CurvatureDiffusion::FloatToHalf(std::ldexp(1.0f, -24)) == 0x0001, "2^-24 is the smallest subnormal");
+}
+
+// Plain Jacobi iteration of the modified curvature diffusion update on a whole float copy, with every neighbour
+// clamped into the volume: no chunks, rolling windows or in-place writes
+std::vector<short> ReferenceDiffusion(const std::vector<short>& input, const VolumeExtent& extent,
+                                      const CurvatureDiffusion::Parameters& parameters) {
+    const auto range = std::minmax_element(input.begin(), input.end());
+    const float offset = std::floor(0.5f * (static_cast<float>(*range.first) + static_cast<float>(*range.second)));
+    std::vector<float> current(input.size());
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        current[i] = static_cast<float>(input[i]) - offset;
+    }
+    const long long size[3] = {static_cast<long long>(extent.x), static_cast<long long>(extent.y),
+                               static_cast<long long>(extent.z)};
+    const float scale[3] = {static_cast<float>(1.0 / parameters.spacing[0]),
+                            static_cast<float>(1.0 / parameters.spacing[1]),
+                            static_cast<float>(1.0 / parameters.spacing[2])};
+    auto at = [&](const long long p[3], const long long d[3]) {
+        long long q[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            q[axis] = std::min(std::max(p[axis] + d[axis], 0LL), size[axis] - 1);
+        }
+        return current[Index(extent, q[0], q[1], q[2])];
+    };
+    std::vector<float> next(current.size());
+    for (unsigned int iteration = 0; iteration < parameters.iterations; ++iteration) {
+        double total = 0.0;
+        for (long long z = 0; z < size[2]; ++z) {
+            for (long long y = 0; y < size[1]; ++y) {
+                for (long long x = 0; x < size[0]; ++x) {
+                    const long long p[3] = {x, y, z};
+                    float squared = 0.0f;
+                    for (int i = 0; i < 3; ++i) {
+                        long long plus[3] = {0, 0, 0};
+                        long long minus[3] = {0, 0, 0};
+                        plus[i] = 1;
+                        minus[i] = -1;
+                        const float d = 0.5f * (at(p, plus) - at(p, minus)) * scale[i];
+                        squared += d * d;
+                    }
+                    total += static_cast<double>(squared);
+                }
+            }
+        }
+        const float k = static_cast<float>(total / static_cast<double>(current.size()) * parameters.conductance *
+                                           parameters.conductance * -2.0);
+        for (long long z = 0; z < size[2]; ++z) {
+            for (long long y = 0; y < size[1]; ++y) {
+                for (long long x = 0; x < size[0]; ++x) {
+                    const long long p[3] = {x, y, z};
+                    const long long none[3] = {0, 0, 0};
+                    const float centre = at(p, none);
+                    float forward[3];
+                    float backward[3];
+                    float central[3];
+                    for (int i = 0; i < 3; ++i) {
+                        long long plus[3] = {0, 0, 0};
+                        long long minus[3] = {0, 0, 0};
+                        plus[i] = 1;
+                        minus[i] = -1;
+                        forward[i] = (at(p, plus) - centre) * scale[i];
+                        backward[i] = (centre - at(p, minus)) * scale[i];
+                        central[i] = 0.5f * (at(p, plus) - at(p, minus)) * scale[i];
+                    }
+                    float speed = 0.0f;
+                    for (int i = 0; i < 3; ++i) {
+                        float gradSq = forward[i] * forward[i];
+                        float gradSqBack = backward[i] * backward[i];
+                        for (int j = 0; j < 3; ++j) {
+                            if (j == i) {
+                                continue;
+                            }
+                            // Central difference along j, one voxel ahead of and one behind the centre along i
+                            long long aheadPlus[3] = {0, 0, 0};
+                            long long aheadMinus[3] = {0, 0, 0};
+                            long long behindPlus[3] = {0, 0, 0};
+                            long long behindMinus[3] = {0, 0, 0};
+                            aheadPlus[i] = aheadMinus[i] = 1;
+                            behindPlus[i] = behindMinus[i] = -1;
+                            aheadPlus[j] = behindPlus[j] = 1;
+                            aheadMinus[j] = behindMinus[j] = -1;
+                            const float ahead = 0.5f * (at(p, aheadPlus) - at(p, aheadMinus)) * scale[j];
+                            const float behind = 0.5f * (at(p, behindPlus) - at(p, behindMinus)) * scale[j];
+                            gradSq += 0.25f * (central[j] + ahead) * (central[j] + ahead);
+                            gradSqBack += 0.25f * (central[j] + behind) * (central[j] + behind);
+                        }
+                        const float conductance = k == 0.0f ? 0.0f : std::exp(gradSq / k);
+                        const float conductanceBack = k == 0.0f ? 0.0f : std::exp(gradSqBack / k);
+                        speed += forward[i] / std::sqrt(1.0e-10f + gradSq) * conductance -
+                                 backward[i] / std::sqrt(1.0e-10f + gradSqBack) * conductanceBack;
+                    }
+                    // Upwind gradient magnitude
+                    float propagation = 0.0f;
+                    for (int i = 0; i < 3; ++i) {
+                        const float back = speed > 0.0f ? std::min(backward[i], 0.0f) : std::max(backward[i], 0.0f);
+                        const float ahead = speed > 0.0f ? std::max(forward[i], 0.0f) : std::min(forward[i], 0.0f);
+                        propagation += back * back + ahead * ahead;
+                    }
+                    next[Index(extent, x, y, z)] =
+                        centre + static_cast<float>(parameters.timeStep) * std::sqrt(propagation) * speed;
+                }
+            }
+        }
+        current.swap(next);
+    }
+    std::vector<short> output(current.size());
+    for (std::size_t i = 0; i < current.size(); ++i) {
+        output[i] = static_cast<short>(std::lround(std::min(32767.0f, std::max(-32768.0f, current[i] + offset))));
+    }
+    return output;
+}
+
+// Largest difference and how many voxels differ at all
+std::pair<int, std::size_t> Compare(const std::vector<short>& expected, const std::vector<short>& actual) {
+    int worst = 0;
+    std::size_t differing = 0;
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        const int difference = std::abs(static_cast<int>(expected[i]) - static_cast<int>(actual[i]));
+        worst = std::max(worst, difference);
+        differing += difference != 0 ? 1 : 0;
+    }
+    return {worst, differing};
+}
+
+void CheckCurvatureDiffusion() {
+    std::cout << "Curvature diffusion vs whole-volume Jacobi iteration" << std::endl;
+    using CurvatureDiffusion::Storage;
+    const VolumeExtent extent{12, 10, 9};
+    CurvatureDiffusion::Parameters parameters;
+    parameters.spacing[2] = 2.5;
+    // Span 4095 with an odd min + max: a half-integer offset would round every stored value
+    std::vector<short> input = RandomVolume(extent, -1000, 3095, 7);
+    input[0] = -1000;
+    input[1] = 3095;
+    const std::vector<short> expected = ReferenceDiffusion(input, extent, parameters);
+    for (const unsigned int workers : {1u, 3u}) {
+        std::vector<short> output(extent.Voxels());
+        CurvatureDiffusion::Diffuse(input.data(), output.data(), extent, parameters, Storage::Float32, workers);
+        const auto [worst, differing] = Compare(expected, output);
+        // Same float arithmetic; only a rare rounding tie can land one unit apart
+        Check(worst <= 1 && differing * 1000 <= output.size(),
+              "fp32 on " + std::to_string(workers) + " worker(s): max difference " + std::to_string(worst) + ", " +
+                  std::to_string(differing) + " voxels differ");
+    }
+
+    std::vector<short> half(extent.Voxels());
+    CurvatureDiffusion::Diffuse(input.data(), half.data(), extent, parameters, Storage::Float16, 3);
+    double totalDifference = 0.0;
+    for (std::size_t i = 0; i < half.size(); ++i) {
+        totalDifference += std::abs(static_cast<int>(expected[i]) - static_cast<int>(half[i]));
+    }
+    const double meanDifference = totalDifference / static_cast<double>(half.size());
+    Check(meanDifference < 0.5, "fp16 mean difference from fp32 reference " + std::to_string(meanDifference));
+
+    // With no iterations the working volume is a pure store and load, so it must reproduce the input exactly
+    CurvatureDiffusion::Parameters copy;
+    copy.iterations = 0;
+    Check(CurvatureDiffusion::EffectiveStorage(input.data(), extent, Storage::Float16) == Storage::Float16,
+          "span 4095 keeps fp16 storage");
+    CurvatureDiffusion::Diffuse(input.data(), half.data(), extent, copy, Storage::Float16, 2);
+    Check(half == input, "fp16 stores a 4095-value span exactly");
+
+    std::vector<short> wide = RandomVolume(extent, -2000, 3000, 8);
+    wide[0] = -2000;
+    wide[1] = 3000;
+    Check(CurvatureDiffusion::EffectiveStorage(wide.data(), extent, Storage::Float16) == Storage::Float32,
+          "span 5000 falls back to fp32 storage");
+    CurvatureDiffusion::Diffuse(wide.data(), half.data(), extent, copy, Storage::Float16, 2);
+    Check(half == wide, "fp16 request on a 5000-value span stays exact through the fp32 fallback");
+}
+
+// Direct 3-D convolution in double with independently built truncated Gaussian weights and clamped neighbours
+std::vector<double> DirectGaussian(const std::vector<short>& input, const VolumeExtent& extent, const double sigma[3]) {
+    std::vector<double> weights[3];
+    long long radius[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        radius[axis] = sigma[axis] > 0.0 ? std::max(1LL, static_cast<long long>(std::ceil(4.0 * sigma[axis]))) : 0;
+        double sum = 0.0;
+        for (long long d = -radius[axis]; d <= radius[axis]; ++d) {
+            const double weight = sigma[axis] > 0.0 ? std::exp(-0.5 * d * d / (sigma[axis] * sigma[axis])) : 1.0;
+            weights[axis].push_back(weight);
+            sum += weight;
+        }
+        for (double& weight : weights[axis]) {
+            weight /= sum;
+        }
+    }
+    std::vector<double> output(input.size());
+    for (std::size_t z = 0; z < extent.z; ++z) {
+        for (std::size_t y = 0; y < extent.y; ++y) {
+            for (std::size_t x = 0; x < extent.x; ++x) {
+                double value = 0.0;
+                for (long long dz = -radius[2]; dz <= radius[2]; ++dz) {
+                    for (long long dy = -radius[1]; dy <= radius[1]; ++dy) {
+                        for (long long dx = -radius[0]; dx <= radius[0]; ++dx) {
+                            value += weights[0][dx + radius[0]] * weights[1][dy + radius[1]] *
+                                     weights[2][dz + radius[2]] *
+                                     input[Index(extent, Clamp(x + dx, extent.x), Clamp(y + dy, extent.y),
+                                                 Clamp(z + dz, extent.z))];
+                        }
+                    }
+                }
+                output[Index(extent, x, y, z)] = value;
+            }
+        }
+    }
+    return output;
+}
+
+void CheckSeparableGaussian() {
+    std::cout << "Separable Gaussian vs direct 3-D convolution" << std::endl;
+    const VolumeExtent extent{14, 11, 9};
+    const std::vector<short> input = RandomVolume(extent, -1000, 3000, 9);
+    const double sigma[3] = {0.8, 1.6, 0.0};
+    const std::vector<double> expected = DirectGaussian(input, extent, sigma);
+
+    std::vector<float> floats(input.begin(), input.end());
+    std::vector<float> smoothed(extent.Voxels());
+    SeparableGaussian::Smooth(floats.data(), smoothed.data(), extent, sigma, 3);
+    double worst = 0.0;
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        worst = std::max(worst, std::abs(expected[i] - static_cast<double>(smoothed[i])));
+    }
+    Check(worst < 0.01, "float smoothing: max error " + std::to_string(worst));
+
+    std::vector<short> rounded(extent.Voxels());
+    SeparableGaussian::Smooth(input.data(), rounded.data(), extent, sigma, 2);
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        // Float sums can only move a value sitting right on a rounding boundary
+        mismatches += std::abs(expected[i] - static_cast<double>(rounded[i])) > 0.5 + 1e-3 ? 1 : 0;
+    }
+    Check(mismatches == 0, "int16 smoothing: " + std::to_string(mismatches) + " voxels off by more than rounding");
+
+    const std::vector<float> kernel = SeparableGaussian::MakeKernel(1.3);
+    double sum = 0.0;
+    bool symmetric = kernel.size() == 2 * 6 + 1;
+    for (std::size_t i = 0; i < kernel.size(); ++i) {
+        sum += kernel[i];
+        symmetric = symmetric && kernel[i] == kernel[kernel.size() - 1 - i];
+    }
+    Check(symmetric && std::abs(sum - 1.0) < 1e-6, "kernel for sigma 1.3 spans 4 sigma, is symmetric and sums to 1");
+}
+
+// Trilinear interpolation at i * outputSpacing from the first input voxel, neighbours past the edge replicated
+short TrilinearSample(const std::vector<short>& input, const VolumeExtent& extent, const double position[3]) {
+    const std::size_t sizes[3] = {extent.x, extent.y, extent.z};
+    long long low[3];
+    double fraction[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        const double floor = std::floor(position[axis]);
+        low[axis] = static_cast<long long>(floor);
+        fraction[axis] = position[axis] - floor;
+    }
+    double value = 0.0;
+    for (int corner = 0; corner < 8; ++corner) {
+        double weight = 1.0;
+        long long index[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            const bool high = (corner >> axis) & 1;
+            weight *= high ? fraction[axis] : 1.0 - fraction[axis];
+            index[axis] = Clamp(low[axis] + (high ? 1 : 0), sizes[axis]);
+        }
+        value += weight * input[Index(extent, index[0], index[1], index[2])];
+    }
+    return static_cast<short>(std::lround(value));
+}
+
+void CheckSeparableResample() {
+    std::cout << "Separable resample vs direct trilinear interpolation" << std::endl;
+    const VolumeExtent inputExtent{13, 10, 7};
+    const std::vector<short> input = RandomVolume(inputExtent, -1000, 3000, 10);
+    const double inputSpacing[3] = {1.0, 0.7, 2.5};
+    // Down along x, up along y and z
+    const double outputSpacing[3] = {1.6, 0.45, 1.0};
+    const VolumeExtent outputExtent{8, 16, 17};
+
+    std::vector<short> expected(outputExtent.Voxels());
+    for (std::size_t z = 0; z < outputExtent.z; ++z) {
+        for (std::size_t y = 0; y < outputExtent.y; ++y) {
+            for (std::size_t x = 0; x < outputExtent.x; ++x) {
+                const double position[3] = {x * outputSpacing[0] / inputSpacing[0],
+                                            y * outputSpacing[1] / inputSpacing[1],
+                                            z * outputSpacing[2] / inputSpacing[2]};
+                expected[Index(outputExtent, x, y, z)] = TrilinearSample(input, inputExtent, position);
+            }
+        }
+    }
+    for (unsigned int workers : {1u, 3u}) {
+        std::vector<short> output(outputExtent.Voxels());
+        SeparableResample::Resample(input.data(), inputExtent, inputSpacing, output.data(), outputExtent, outputSpacing,
+                                    SeparableResample::Kernel::Linear, false, workers);
+        int worst = 0;
+        for (std::size_t i = 0; i < output.size(); ++i) {
+            worst = std::max(worst, std::abs(static_cast<int>(output[i]) - expected[i]));
+        }
+        Check(worst <= 1, "linear, " + std::to_string(workers) + " workers: max error " + std::to_string(worst));
+    }
+
+    // Every kernel interpolates, so the identity grid gives the input back; weights sum to 1, so a flat volume stays
+    // flat even when antialiasing widens the kernel
+    const std::vector<short> flat(inputExtent.Voxels(), 1234);
+    const double coarse[3] = {2.0, 2.1, 3.0};
+    const VolumeExtent coarseExtent{7, 4, 6};
+    const std::pair<SeparableResample::Kernel, const char*> kernels[] = {
+        {SeparableResample::Kernel::Linear, "linear"},
+        {SeparableResample::Kernel::BSpline, "bspline"},
+        {SeparableResample::Kernel::Lanczos, "lanczos"},
+    };
+    for (const auto& [kernel, name] : kernels) {
+        std::vector<short> output(inputExtent.Voxels());
+        SeparableResample::Resample(input.data(), inputExtent, inputSpacing, output.data(), inputExtent, inputSpacing,
+                                    kernel, true, 2);
+        int worst = 0;
+        for (std::size_t i = 0; i < output.size(); ++i) {
+            worst = std::max(worst, std::abs(static_cast<int>(output[i]) - input[i]));
+        }
+        Check(worst <= 1, std::string(name) + " identity grid: max error " + std::to_string(worst));
+
+        std::vector<short> reduced(coarseExtent.Voxels());
+        SeparableResample::Resample(flat.data(), inputExtent, inputSpacing, reduced.data(), coarseExtent, coarse,
+                                    kernel, true, 2);
+        Check(std::all_of(reduced.begin(), reduced.end(), [](short value) { return value == 1234; }),
+              std::string(name) + " antialiased downsample keeps a flat volume flat");
+    }
+}
+
+// Voxel position -> the one or two tiles whose centres bracket it, with the weight of the upper tile
+struct TileBlend {
+    std::size_t lower;
+    std::size_t upper;
+    double weight;
+};
+
+TileBlend BlendTiles(std::size_t position, std::size_t length, std::size_t tiles) {
+    tiles = std::max<std::size_t>(1, std::min(tiles, length));
+    const std::size_t size = (length + tiles - 1) / tiles;
+    std::vector<double> centres;
+    for (std::size_t first = 0; first < length; first += size) {
+        centres.push_back(0.5 * static_cast<double>(first + std::min(first + size, length) - 1));
+    }
+    const double p = static_cast<double>(position);
+    if (p <= centres.front()) {
+        return {0, 0, 0.0};
+    }
+    for (std::size_t k = 0; k + 1 < centres.size(); ++k) {
+        if (p < centres[k + 1]) {
+            return {k, k + 1, (p - centres[k]) / (centres[k + 1] - centres[k])};
+        }
+    }
+    return {centres.size() - 1, centres.size() - 1, 0.0};
+}
+
+// Straight CLAHE: clipped cumulative histogram of each tile, evaluated per voxel and blended in double
+std::vector<short> ReferenceClahe(const std::vector<short>& input, const VolumeExtent& extent,
+                                  const TiledClahe::Parameters& parameters) {
+    const auto range = std::minmax_element(input.begin(), input.end());
+    const int low = *range.first;
+    const int high = *range.second;
+    const long long values = high - low + 1;
+    const long long bins = std::min(values, 4096LL);
+    auto binOf = [&](short value) { return (value - low) * bins / values; };
+    const std::size_t lengths[3] = {extent.x, extent.y, extent.z};
+    const std::size_t tiles[3] = {parameters.tiles, parameters.tiles,
+                                  parameters.volumetric ? parameters.tiles : extent.z};
+
+    std::map<std::vector<std::size_t>, std::vector<double>> mappings;
+    auto mapping = [&](const std::vector<std::size_t>& tile) -> const std::vector<double>& {
+        auto found = mappings.find(tile);
+        if (found != mappings.end()) {
+            return found->second;
+        }
+        std::size_t first[3];
+        std::size_t last[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            const std::size_t count = std::max<std::size_t>(1, std::min(tiles[axis], lengths[axis]));
+            const std::size_t size = (lengths[axis] + count - 1) / count;
+            first[axis] = tile[axis] * size;
+            last[axis] = std::min(first[axis] + size, lengths[axis]);
+        }
+        std::vector<double> histogram(bins, 0.0);
+        double voxels = 0.0;
+        for (std::size_t z = first[2]; z < last[2]; ++z) {
+            for (std::size_t y = first[1]; y < last[1]; ++y) {
+                for (std::size_t x = first[0]; x < last[0]; ++x) {
+                    histogram[binOf(input[Index(extent, x, y, z)])] += 1.0;
+                    voxels += 1.0;
+                }
+            }
+        }
+        const double limit = parameters.clipLimit > 0.0 ? std::max(1.0, parameters.clipLimit * voxels / bins) : voxels;
+        double excess = 0.0;
+        for (double count : histogram) {
+            excess += std::max(0.0, count - limit);
+        }
+        std::vector<double> cdf(bins);
+        double running = 0.0;
+        for (long long b = 0; b < bins; ++b) {
+            running += std::min(histogram[b], limit) + excess / bins;
+            cdf[b] = low + running * (high - low) / voxels;
+        }
+        return mappings.emplace(tile, std::move(cdf)).first->second;
+    };
+
+    std::vector<short> output(input.size());
+    for (std::size_t z = 0; z < extent.z; ++z) {
+        for (std::size_t y = 0; y < extent.y; ++y) {
+            for (std::size_t x = 0; x < extent.x; ++x) {
+                const std::size_t position[3] = {x, y, z};
+                TileBlend blend[3];
+                for (int axis = 0; axis < 3; ++axis) {
+                    blend[axis] = BlendTiles(position[axis], lengths[axis], tiles[axis]);
+                }
+                const short value = input[Index(extent, x, y, z)];
+                double mapped = 0.0;
+                for (int corner = 0; corner < 8; ++corner) {
+                    double weight = 1.0;
+                    std::vector<std::size_t> tile(3);
+                    for (int axis = 0; axis < 3; ++axis) {
+                        const bool upper = (corner >> axis) & 1;
+                        weight *= upper ? blend[axis].weight : 1.0 - blend[axis].weight;
+                        tile[axis] = upper ? blend[axis].upper : blend[axis].lower;
+                    }
+                    if (weight > 0.0) {
+                        mapped += weight * mapping(tile)[binOf(value)];
+                    }
+                }
+                mapped += parameters.beta * (value - mapped);
+                output[Index(extent, x, y, z)] = static_cast<short>(std::lround(mapped));
+            }
+        }
+    }
+    return output;
+}
+
+void CheckTiledClahe() {
+    std::cout << "Tiled CLAHE vs per-voxel tile mapping" << std::endl;
+    const VolumeExtent extent{23, 19, 6};
+    // One range with a bin per value and one wide enough that values share bins
+    const std::vector<short> narrow = RandomVolume(extent, -200, 900, 11);
+    const std::vector<short> wide = RandomVolume(extent, -1000, 9000, 12);
+    struct Case {
+        const std::vector<short>* input;
+        TiledClahe::Parameters parameters;
+        const char* name;
+    };
+    const Case cases[] = {
+        {&narrow, {4, false, 2.0, 0.0}, "2-D, clip 2"},
+        {&narrow, {4, true, 2.0, 0.0}, "3-D, clip 2"},
+        {&narrow, {3, true, 0.0, 0.3}, "3-D, unclipped, beta 0.3"},
+        {&wide, {5, false, 1.5, 0.0}, "2-D, shared bins"},
+        {&wide, {4, true, 3.0, 0.0}, "3-D, shared bins"},
+    };
+    for (const Case& test : cases) {
+        const std::vector<short> expected = ReferenceClahe(*test.input, extent, test.parameters);
+        for (unsigned int workers : {1u, 3u}) {
+            std::vector<short> output(extent.Voxels());
+            TiledClahe::Equalize(test.input->data(), output.data(), extent, test.parameters, workers);
+            int worst = 0;
+            for (std::size_t i = 0; i < output.size(); ++i) {
+                worst = std::max(worst, std::abs(static_cast<int>(output[i]) - expected[i]));
+            }
+            Check(worst <= 1, std::string(test.name) + ", " + std::to_string(workers) + " workers: max error " +
+                                  std::to_string(worst));
+        }
+    }
+
+    std::vector<short> unchanged(extent.Voxels());
+    TiledClahe::Equalize(narrow.data(), unchanged.data(), extent, {4, true, 2.0, 1.0}, 2);
+    Check(unchanged == narrow, "beta 1 returns the input");
+}
+
+// Runs of noise alternating with copies from 3000 bytes back, so matches reach across block boundaries
+std::vector<std::uint8_t> DeflateInput(std::size_t size, unsigned int seed) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<std::uint8_t> data(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        data[i] = (i / 5000) % 2 == 1 ? data[i - 3000] : static_cast<std::uint8_t>(byte(generator));
+    }
+    return data;
+}
+
+void CheckParallelDeflate() {
+    std::cout << "Parallel deflate round-trip through zlib inflate" << std::endl;
+#ifdef HAVE_ZLIB
+    for (std::size_t size : {std::size_t{0}, std::size_t{1}, std::size_t{1000}, std::size_t{64 * 1024},
+                             std::size_t{300001}}) {
+        const std::vector<std::uint8_t> data = DeflateInput(size, static_cast<unsigned int>(size) + 13);
+        for (int level : {0, 1, 6, 9}) {
+            // 64 KiB is the smallest block Compress accepts, so the larger inputs span several blocks
+            for (unsigned int workers : {1u, 3u}) {
+                const std::string label = std::to_string(size) + " bytes, level " + std::to_string(level) + ", " +
+                                          std::to_string(workers) + " workers";
+                std::vector<std::uint8_t> stream;
+                if (!ParallelDeflate::Compress(data.data(), data.size(), level, workers, stream, 64 * 1024)) {
+                    Check(false, label + ": compress failed");
+                    continue;
+                }
+
+                // Plain single-call zlib inflate, independent of ParallelDeflate::Decompress
+                z_stream inflater{};
+                std::vector<std::uint8_t> restored(size + 1);
+                int status = inflateInit2(&inflater, -15);
+                if (status == Z_OK) {
+                    inflater.next_in = stream.data();
+                    inflater.avail_in = static_cast<uInt>(stream.size());
+                    inflater.next_out = restored.data();
+                    inflater.avail_out = static_cast<uInt>(restored.size());
+                    status = inflate(&inflater, Z_FINISH);
+                    restored.resize(restored.size() - inflater.avail_out);
+                    inflateEnd(&inflater);
+                }
+                Check(status == Z_STREAM_END && inflater.avail_in == 0 && restored == data,
+                      label + ": zlib inflate restores the input from one complete stream");
+
+                std::vector<std::uint8_t> decompressed;
+                Check(ParallelDeflate::Decompress(stream.data(), stream.size(), decompressed) && decompressed == data,
+                      label + ": Decompress restores the input");
+            }
+        }
+    }
+#else
+    Check(!ParallelDeflate::Available(), "built without zlib, so the engine reports itself unavailable");
+    std::cout << "  skipped: built without zlib" << std::endl;
+#endif
+}
+} // namespace
+
+int main() {
+    CheckMedian();
+    CheckConnectedComponents();
+    CheckMorphology();
+    CheckDistanceTransform();
+    CheckSlabProjection();
+    CheckHalfFloat();
+    CheckCurvatureDiffusion();
+    CheckSeparableGaussian();
+    CheckSeparableResample();
+    CheckTiledClahe();
+    CheckParallelDeflate();
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All utility checks passed" << std::endl;
+    return 0;
+}